@@ -0,0 +1,45 @@
+#ifndef cost_map_h
+#define cost_map_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include "thread_pool.h"
+
+#define COST_MAP_MAGIC 0x70616d63
+#define COST_MAP_SIZE 128
+#define COST_MAP_SAMPLES 16
+#define COST_MAP_ITERATIONS 256
+#define COST_MAP_EXTENT 2.0f
+#define COST_MAP_INTERIOR_THRESHOLD 0.05f//Above this share of interior pixels d() should check for periodicity
+
+/*
+    Expected cost of a Julia frame as a function of c, sampled on a COST_MAP_SIZE^2 grid over [-2, 2]^2.
+    Each cell iterates a COST_MAP_SAMPLES^2 grid over the [-1, 1]^2 window: cost is the mean iteration count
+    as a fraction of COST_MAP_ITERATIONS and interior is the share of samples that never escaped.
+*/
+typedef struct cost_sample_t {
+    float cost;
+    float interior;
+} cost_sample_t;
+
+typedef struct cost_map_header_t {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t samples;
+    uint32_t iterations;
+} cost_map_header_t;
+
+typedef struct cost_map_t {
+    uint32_t size;
+    cost_sample_t *samples;
+} cost_map_t;
+
+cost_map_t load_cost_map(const char *file_name, uint32_t thread_count);
+cost_sample_t predict_cost(cost_map_t *map, complex float c);
+void destroy_cost_map(cost_map_t *map);
+
+#endif /* cost_map_h */
@@ -0,0 +1,35 @@
+#ifndef depth_manager_h
+#define depth_manager_h
+
+#include <vulkan/vulkan.h>
+#include "vulkan_resources.h"
+#include "vulkan_utils.h"
+
+typedef struct depth_target_t {
+    VkImage image;
+    VkDeviceMemory memory;
+    VkImageView view;
+} depth_target_t;
+
+/*
+    The scene's depth buffers, one per frame in flight since a frame only touches its own and the slot is
+    reused only after the frame has been waited for. Depth is cleared on load and never stored, so the
+    targets are transient and live in lazily allocated memory where the device has any, which tiled GPUs
+    never back with real memory. They only depend on the extent and survive a swapchain recreation that
+    keeps it.
+*/
+typedef struct depth_manager_t {
+    VkFormat format;//The smallest depth-only format the device can render to
+    VkExtent2D extent;
+    uint32_t target_count;
+    depth_target_t *targets;//NULL until sized
+    VkDeviceSize memory_size;//Across every target
+} depth_manager_t;
+
+VkFormat choose_depth_format(VkPhysicalDevice physical_device);
+void initialise_depth_manager(depth_manager_t *depth, VkPhysicalDevice physical_device, uint32_t target_count);
+uint32_t depth_targets_match(depth_manager_t *depth, VkExtent2D extent);
+depth_target_t *resize_depth_targets(depth_manager_t *depth, VkDevice logical_device, VkPhysicalDevice physical_device, VkExtent2D extent);
+void destroy_depth_targets(depth_target_t *targets, uint32_t target_count, VkDevice logical_device);
+
+#endif /* depth_manager_h */
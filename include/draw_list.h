@@ -0,0 +1,65 @@
+#ifndef draw_list_h
+#define draw_list_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+#include "material.h"
+#include "vulkan_utils.h"
+
+/*
+    Bits of the sort key, from the most significant: the state that is most expensive to change sorts first
+    and depth last, front to back within a batch. Handles are replaced by small ids handed out in the order
+    they are first seen, an id only wraps once a field's range is exhausted, which costs batching but never
+    correctness since binds are decided on the handles themselves.
+*/
+#define DRAW_KEY_PIPELINE_BITS 8
+#define DRAW_KEY_MATERIAL_BITS 12
+#define DRAW_KEY_MESH_BITS 12
+#define DRAW_KEY_DEPTH_BITS 32
+
+#define DRAW_BINDS_PER_OBJECT 5//Pipeline, scene set, material set, vertex and index buffers, as record_draw binds
+
+typedef struct draw_stats_t {
+    uint32_t draws;
+    uint32_t binds;//Issued
+    uint32_t binds_saved;//Left out because the state was already bound
+} draw_stats_t;
+
+/*
+    The handles the ids of one key field stand for
+*/
+typedef struct draw_key_ids_t {
+    uint64_t *handles;
+    uint32_t count, capacity;
+} draw_key_ids_t;
+
+/*
+    A frame's draws, collected in any order and sorted on a packed 64 bit key so that objects sharing a
+    pipeline, material and mesh are recorded together. The list is reset every frame, its storage and the
+    key ids are kept.
+*/
+typedef struct draw_list_t {
+    render_object_t *objects;//As pushed
+    render_object_t *sorted;//Filled by sort_draw_list
+    uint64_t *keys, *key_scratch;
+    uint32_t *order, *order_scratch;
+    uint32_t count, capacity;
+
+    draw_key_ids_t pipeline_ids, material_ids, mesh_ids;
+
+    draw_stats_t stats;//Since print_draw_list_stats last ran
+    uint32_t frames;
+} draw_list_t;
+
+void initialise_draw_list(draw_list_t *list, uint32_t capacity);
+void reset_draw_list(draw_list_t *list);
+void push_draw(draw_list_t *list, render_object_t *object, float depth);
+void sort_draw_list(draw_list_t *list);
+void record_draws(VkCommandBuffer command_buffer, render_object_t *objects, uint32_t object_count, VkDescriptorSet global_descriptor, draw_stats_t *stats);
+void add_draw_stats(draw_list_t *list, draw_stats_t *stats);
+void print_draw_list_stats(draw_list_t *list);
+void destroy_draw_list(draw_list_t *list);
+
+#endif /* draw_list_h */
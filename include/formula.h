@@ -0,0 +1,32 @@
+#ifndef formula_h
+#define formula_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define FORMULA_MAX_NODES 4096
+#define FORMULA_TABLE_SIZE 8192//Power of two, at least twice FORMULA_MAX_NODES
+#define FORMULA_MAX_POWER 64//Integer powers up to this are expanded into products, larger ones go through polar form
+
+/*
+    Runtime compiler for escape-time iteration formulas, replacing the edit-and-recompile of shader.comp.
+    A formula is an expression of z, c, the iteration count n and the time t, for example "z^2 + c",
+    "z^5 - 0.01/z^3 - 0.01i/z^2 + c", "exp(0.75*c/z^5) + c" or "sin(z + c)". It has + - * / ^, unary minus,
+    real and imaginary literals (2.5, 0.01i, i, pi) and the functions sin cos sinh cosh exp log sqrt conj
+    abs arg re im.
+
+    The formula is lowered to real arithmetic on the parts of z and c in a hash-consed graph, so each
+    subexpression is computed once, including z.x*z.x and z.y*z.y shared between a square and the escape test.
+    Constants are folded, integer powers become chains of squarings and products, multiplication by two
+    becomes an addition, divisions by constants become multiplications and a complex quotient pays for one
+    real division. Nodes that do not depend on z or n are hoisted out of the loop.
+
+    The output is a SPIR-V compute shader with the bindings and push constants of shader.comp. It only
+    implements the window mode, coloured by smoothed iteration count, and records no statistics.
+*/
+uint32_t compile_formula(const char *source, uint32_t **code, size_t *code_size);
+
+#endif /* formula_h */
@@ -0,0 +1,111 @@
+#ifndef fractal_h
+#define fractal_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "material.h"
+#include "fractal_orbit.h"
+#include "formula.h"
+
+#define DEEP_ORBIT_CAPACITY (1 << 18)
+
+#define FRACTAL_DEEP_ORBITS 1//Reference orbit and BLA buffers of DEEP_ORBIT_CAPACITY, otherwise only their headers
+#define FRACTAL_RECOMPUTE_LIST 2//Recompute buffer for every texel, otherwise only its header
+
+#define FRACTAL_INSTRUMENT_COUNTERS 1
+#define FRACTAL_INSTRUMENT_HEAT_MAP 2//Replaces the colouring with iterations per pixel
+
+/*
+    Selects how shader.comp maps an invocation to a point in the plane
+*/
+typedef enum fractal_mode_t {
+    FRACTAL_MODE_WINDOW = 0,
+    FRACTAL_MODE_EXP_MAP = 1,
+    FRACTAL_MODE_DEEP = 2,
+    FRACTAL_MODE_LIST = 3//Window mode, but only for the texels in the recompute buffer
+} fractal_mode_t;
+
+typedef struct compute_push_constants_t {
+    float x_min, x_max, y_min, y_max;
+    union {
+        complex float z;
+        float C[2];
+    };
+    float t;
+    uint32_t mode;
+    float centre[2];
+    float log_radius_min, log_radius_max;
+    uint32_t max_iterations;
+    float bailout;
+    uint32_t width, height;//Region of the texture written in window and deep modes
+    uint32_t interior_check;//Periodicity checking in d(), worth it when much of the frame never escapes
+    uint32_t instrumentation;//FRACTAL_INSTRUMENT_* flags
+    uint32_t origin[2];//Texel the region is written to in window and deep modes
+} compute_push_constants_t;
+
+/*
+    Written by shader.comp, read back once the frame that produced it has completed. Skipped iterations are
+    counted in the deep mode, the rest only with FRACTAL_INSTRUMENT_COUNTERS. The sum of per-workgroup maxima
+    times the workgroup size is what the GPU actually paid for, so total_iterations over it measures divergence.
+*/
+typedef struct fractal_stats_t {
+    uint32_t skipped_iterations_low, skipped_iterations_high;
+    uint32_t total_iterations_low, total_iterations_high;
+    uint32_t workgroup_max_sum_low, workgroup_max_sum_high;
+    uint32_t escaped_pixels, interior_pixels;
+    uint32_t workgroup_count;
+    uint32_t max_iterations;
+} fractal_stats_t;
+
+/*
+    Head of the recompute buffer, the packed texels x | y << 16 follow. The dispatch covers count invocations
+    in workgroups of 64, so the list can be dispatched indirectly as written.
+*/
+typedef struct recompute_header_t {
+    VkDispatchIndirectCommand dispatch;
+    uint32_t count;
+} recompute_header_t;
+
+typedef struct fractal_data_t {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+
+    VkImageMemoryBarrier2 *begin_barriers, *end_barriers;
+
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet *descriptors;
+
+    uint32_t texture_width, texture_height;
+    image_t *fractal_images;
+    VkImageView *fractal_image_views;
+
+    buffer_t orbit_buffer, bla_buffer;
+    VkDeviceSize orbit_buffer_size, bla_buffer_size;
+    buffer_t recompute_buffer;
+    VkDeviceSize recompute_buffer_size;
+    host_buffer_t *stats_buffers;
+
+    VkQueryPool timestamp_pool;
+    double timestamp_period;
+    uint32_t *timestamps_written;
+
+    compute_push_constants_t push_data;
+} fractal_data_t;
+
+void write_fractal_set(fractal_data_t *fractal_data, descriptor_writer_t *writer, VkDevice logical_device, VkDescriptorSet set, VkImageView target_view, uint32_t frame_index);
+fractal_data_t initialise_fractal_data(renderer_t *renderer, uint32_t buffers);
+void upload_reference_orbits(fractal_data_t *fractal_data, renderer_t *renderer, reference_orbit_t orbits[ORBIT_COUNT], bla_table_t *table);
+fractal_stats_t collect_fractal_stats(fractal_data_t *fractal_data, uint32_t frame_index);
+uint64_t skipped_iterations(fractal_stats_t *stats);
+void print_fractal_stats(fractal_stats_t *stats);
+double fractal_dispatch_time(fractal_data_t *fractal_data, VkDevice logical_device, uint32_t frame_index);
+uint32_t use_fractal_formula(fractal_data_t *fractal_data, VkDevice logical_device, const char *formula);
+VkBufferMemoryBarrier2 host_read_barrier(VkBuffer buffer);
+void dispatch_fractal(fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index);
+void update_fractal(fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index);
+void destroy_fractal_data(fractal_data_t *fractal_data, VkDevice logical_device);
+
+#endif /* fractal_h */
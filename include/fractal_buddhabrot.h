@@ -0,0 +1,78 @@
+#ifndef fractal_buddhabrot_h
+#define fractal_buddhabrot_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+#include "fractal_density.h"
+
+#define BUDDHABROT_THREAD_COUNT 64
+
+/*
+    Buddhabrot of the Mandelbrot set, accumulated over frames into a density target. Every invocation owns a
+    Metropolis chain over c whose target density is the number of points an escaping orbit puts in the window,
+    so orbits that never escape or never pass through the window are rarely iterated. Proposals are either a
+    small jump around the current c or, with probability large_mutation, a fresh c from |c| < 2; both are
+    symmetric, so a proposal is accepted with min(1, f(c')/f(c)). Each step splats the current orbit with
+    weight/f(c) per hit, rounded stochastically, which undoes the bias of sampling c in proportion to f.
+*/
+typedef struct buddhabrot_push_constants_t {
+    float x_min, x_max, y_min, y_max;
+    uint32_t width, height;
+    uint32_t chain_count;
+    uint32_t steps;
+    uint32_t max_iterations;
+    uint32_t min_iterations;
+    uint32_t weight;
+    float mutation_radius;
+    float large_mutation;
+    uint32_t padding[3];
+} buddhabrot_push_constants_t;
+
+/*
+    Written by the frame's dispatch. peak only moves when a cell's count crosses a power of two, so it is
+    the largest count to within a factor of two.
+*/
+typedef struct buddhabrot_stats_t {
+    uint32_t peak;
+    uint32_t proposed;
+    uint32_t accepted;
+    uint32_t contributing;
+} buddhabrot_stats_t;
+
+typedef struct buddhabrot_t {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet *descriptors;
+
+    buffer_t chain_buffer;
+    VkDeviceSize chain_size;
+    host_buffer_t *stats_buffers;
+
+    float window[4];
+    uint32_t chain_count;
+    uint32_t steps;
+    uint32_t max_iterations;
+    uint32_t min_iterations;
+    uint32_t weight;
+    float mutation_radius;
+    float large_mutation;
+
+    uint32_t reset;
+    uint32_t peak;
+    uint64_t proposed, accepted, contributing;
+} buddhabrot_t;
+
+buddhabrot_t initialise_buddhabrot(renderer_t *renderer, density_target_t *target);
+void collect_buddhabrot_stats(buddhabrot_t *buddhabrot, uint32_t frame_index);
+void print_buddhabrot_stats(buddhabrot_t *buddhabrot, double seconds);
+void render_buddhabrot(buddhabrot_t *buddhabrot, density_target_t *target, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, uint32_t frame_index);
+void destroy_buddhabrot(buddhabrot_t *buddhabrot, VkDevice logical_device);
+
+#endif /* fractal_buddhabrot_h */
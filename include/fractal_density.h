@@ -0,0 +1,39 @@
+#ifndef fractal_density_h
+#define fractal_density_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+
+#define DENSITY_THREAD_COUNT 8
+
+/*
+    A grid of hit counters that point-splatting passes accumulate into, resolved into the fractal image
+    with brightness log(1 + count)*scale raised to gamma
+*/
+typedef struct density_push_constants_t {
+    uint32_t width, height;
+    float scale;
+    float gamma;
+} density_push_constants_t;
+
+typedef struct density_target_t {
+    VkPipeline resolve_pipeline;
+    VkPipelineLayout resolve_layout;
+
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet *descriptors;
+
+    uint32_t width, height;
+    buffer_t density_buffer;
+    VkDeviceSize density_size;
+} density_target_t;
+
+density_target_t initialise_density_target(renderer_t *renderer, fractal_data_t *fractal_data, uint32_t width, uint32_t height);
+void clear_density(density_target_t *target, VkCommandBuffer command_buffer);
+void resolve_density(density_target_t *target, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, float scale, float gamma, uint32_t frame_index);
+void destroy_density_target(density_target_t *target, VkDevice logical_device);
+
+#endif /* fractal_density_h */
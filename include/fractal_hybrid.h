@@ -0,0 +1,68 @@
+#ifndef fractal_hybrid_h
+#define fractal_hybrid_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+#include "thread_pool.h"
+
+#define HYBRID_TILE_SIZE 64
+#define HYBRID_RING_TILES 512//Staging slots shared by all frames in flight
+#define HYBRID_SMOOTHING 0.25
+
+struct hybrid_renderer_t;
+
+/*
+    What the CPU workers of one frame need. Tiles are numbered row-major, the GPU has already claimed every
+    tile before next_tile and the workers claim the rest one at a time until tile_count.
+*/
+typedef struct hybrid_job_t {
+    struct hybrid_renderer_t *hybrid;
+    compute_push_constants_t push;
+    uint32_t columns;
+    uint32_t first_tile, tile_count;
+    uint32_t ring_base;
+    atomic_uint next_tile;
+} hybrid_job_t;
+
+/*
+    Renders the window mode of shader.comp cooperatively. The image is split into tiles of HYBRID_TILE_SIZE;
+    the GPU takes whole tile rows from the front of the queue in a single dispatch and a pool of CPU workers
+    takes the remaining tiles, writing them into a host-visible staging ring that is copied into the fractal
+    image in the same command buffer. The workers are waited for while the frame is recorded, so within a
+    frame the CPU tiles are always done before the GPU band can start. The two sides only overlap across
+    frames in flight: a frame's tiles are computed while the GPU still runs earlier frames. The split follows
+    the measured throughput of both sides in pixels per second: the GPU from its timestamp queries once the
+    frame has retired, the CPU from the wall time of the workers. With frames in flight to overlap, the
+    split evens out the per-frame time of each side. With a single frame in flight nothing overlaps, so the
+    faster side takes everything but the one row each side keeps so both stay measured.
+*/
+typedef struct hybrid_renderer_t {
+    thread_pool_t pool;
+    uint32_t thread_count;
+    uint32_t frame_count;
+
+    host_buffer_t ring;
+    uint32_t ring_head, ring_free;
+    uint32_t *ring_used;//Slots each frame in flight holds until it has been waited for
+    VkBufferImageCopy *regions;
+
+    uint32_t *gpu_pixels;//Pixels dispatched by each frame in flight, paired with its timestamps
+    double gpu_rate, cpu_rate;//Pixels per second, 0 until measured
+    double gpu_share;
+
+    hybrid_job_t job;
+    uint64_t gpu_total, cpu_total;
+} hybrid_renderer_t;
+
+void initialise_hybrid_renderer(hybrid_renderer_t *hybrid, renderer_t *renderer, uint32_t thread_count);
+void render_hybrid_frame(hybrid_renderer_t *hybrid, fractal_data_t *fractal_data, VkDevice logical_device, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index);
+void print_hybrid_stats(hybrid_renderer_t *hybrid);
+void destroy_hybrid_renderer(hybrid_renderer_t *hybrid, VkDevice logical_device);
+
+#endif /* fractal_hybrid_h */
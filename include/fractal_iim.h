@@ -0,0 +1,47 @@
+#ifndef fractal_iim_h
+#define fractal_iim_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <complex.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+#include "fractal_density.h"
+
+#define IIM_THREAD_COUNT 64
+
+/*
+    Preview of the Julia set boundary by inverse iteration, splatted into a density target.
+    2^seed_depth invocations each visit at most splat_budget preimages, so the cost is bounded by
+    2^seed_depth*splat_budget square roots no matter how expensive c is for the escape time shader.
+*/
+typedef struct iim_push_constants_t {
+    float c[2];
+    float x_min, x_max, y_min, y_max;
+    uint32_t width, height;
+    uint32_t cell_cap;
+    uint32_t seed_depth;
+    uint32_t max_depth;
+    uint32_t splat_budget;
+} iim_push_constants_t;
+
+typedef struct iim_preview_t {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet descriptor;
+
+    uint32_t cell_cap;
+    uint32_t seed_depth;
+    uint32_t max_depth;
+    uint32_t splat_budget;
+} iim_preview_t;
+
+iim_preview_t initialise_iim_preview(renderer_t *renderer, density_target_t *target);
+void render_iim_preview(iim_preview_t *preview, density_target_t *target, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, complex float c, uint32_t frame_index);
+void destroy_iim_preview(iim_preview_t *preview, VkDevice logical_device);
+
+#endif /* fractal_iim_h */
@@ -0,0 +1,73 @@
+#ifndef fractal_orbit_h
+#define fractal_orbit_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+#define ORBIT_COUNT 2
+#define ORBIT_CENTRE 0
+#define ORBIT_CRITICAL 1
+#define BLA_MAX_LEVELS 24
+#define BLA_MAX_MULTIPLIER 1e18
+
+/*
+    Reference orbits for perturbation, uploaded as a vec2 array behind an orbit_header_t.
+    The centre orbit starts near the view centre, offset is where it starts relative to the centre.
+    The critical orbit starts at 0 and is used when a pixel rebases.
+*/
+typedef struct reference_orbit_t {
+    uint32_t capacity;
+    uint32_t length;
+    double offset[2];
+    float *points;
+} reference_orbit_t;
+
+typedef struct orbit_header_t {
+    uint32_t info[4];
+    float offset[2];
+    float padding[2];
+} orbit_header_t;
+
+/*
+    Bilinear approximation: an entry of level k at index j replaces the 2^k steps starting at iteration j*2^k
+    by delta -> a*delta, valid while |delta|^2 < radius_squared. Layout matches the bla_table block in shader.comp.
+*/
+typedef struct bla_entry_t {
+    float a[2];
+    float radius_squared;
+    uint32_t length;
+} bla_entry_t;
+
+typedef struct bla_level_t {
+    uint32_t offset;
+    uint32_t count;
+    uint32_t padding[2];
+} bla_level_t;
+
+typedef struct bla_header_t {
+    uint32_t level_count;
+    uint32_t padding[3];
+    bla_level_t levels[ORBIT_COUNT][BLA_MAX_LEVELS];
+} bla_header_t;
+
+typedef struct bla_table_t {
+    bla_header_t header;
+    uint32_t capacity;
+    uint32_t entry_count;
+    bla_entry_t *entries;
+} bla_table_t;
+
+reference_orbit_t create_reference_orbit(uint32_t capacity);
+void destroy_reference_orbit(reference_orbit_t *orbit);
+uint32_t compute_reference_orbit(reference_orbit_t *orbit, double complex z_0, double complex c, double bailout);
+
+bla_table_t create_bla_table(uint32_t orbit_capacity);
+void destroy_bla_table(bla_table_t *table);
+void clear_bla_table(bla_table_t *table);
+void build_bla_levels(bla_table_t *table, uint32_t orbit_index, reference_orbit_t *orbit, double epsilon);
+
+#endif /* fractal_orbit_h */
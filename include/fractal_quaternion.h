@@ -0,0 +1,86 @@
+#ifndef fractal_quaternion_h
+#define fractal_quaternion_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+
+#define QUATERNION_THREAD_COUNT 8
+#define QUATERNION_GRID_SIZE 32//Cells along each side of the bounding cube
+#define QUATERNION_CONE_FACTOR 8//Pixels along each side of a cone marched in the pre-pass
+
+#define QUATERNION_PASS_GRID 0
+#define QUATERNION_PASS_CONE 1
+#define QUATERNION_PASS_MARCH 2
+
+/*
+    Ray-marched slice w = 0 of the quaternion Julia set q -> q^2 + c, stepped by the distance estimate of d()
+    carried over to quaternions. A frame is three dispatches of quaternion.comp:
+    - grid: the estimate at the centre of every cell of a coarse grid over the bounding cube. The distance
+      from any point to the set is at least the centre's estimate less the distance to the centre, so where
+      that bound is comfortably positive a ray steps by it without iterating.
+    - cone: one ray per QUATERNION_CONE_FACTOR square of pixels, stepped only as far as the whole cone of
+      rays through the square is clear of the set. Where it stops is a safe start for each of those rays.
+    - march: every pixel, from the cone's distance, down to a surface within epsilon pixel footprints.
+*/
+typedef struct quaternion_push_constants_t {
+    float eye[4];
+    float forward[4], right[4], up[4];//right and up are scaled to one pixel at unit distance
+    float c[4];
+    uint32_t width, height;
+    uint32_t pass;
+    uint32_t max_steps;
+    uint32_t max_iterations;
+    float epsilon;
+    float bound_radius;
+    uint32_t grid_size;
+    uint32_t cone_factor;
+    float t;
+    uint32_t padding[2];
+} quaternion_push_constants_t;
+
+/*
+    Written by the frame's dispatches, 64-bit counters are split into a low and a high word.
+    Grid steps are steps taken from the grid bound alone, without evaluating the estimate.
+*/
+typedef struct quaternion_stats_t {
+    uint32_t march_steps_low, march_steps_high;
+    uint32_t grid_steps_low, grid_steps_high;
+    uint32_t cone_steps_low, cone_steps_high;
+    uint32_t pixels;
+    uint32_t hits;
+} quaternion_stats_t;
+
+typedef struct quaternion_julia_t {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet *descriptors;
+
+    buffer_t grid_buffer, cone_buffer;
+    VkDeviceSize grid_size, cone_size;
+    host_buffer_t *stats_buffers;
+
+    uint32_t max_steps;
+    uint32_t max_iterations;
+    float epsilon;
+    float bound_radius;
+
+    uint64_t march_steps, grid_steps, cone_steps;
+    uint64_t pixels, hits;
+    double gpu_time;
+    uint32_t frames;
+} quaternion_julia_t;
+
+quaternion_julia_t initialise_quaternion_julia(renderer_t *renderer, fractal_data_t *fractal_data);
+void collect_quaternion_stats(quaternion_julia_t *julia, fractal_data_t *fractal_data, VkDevice logical_device, uint32_t frame_index);
+void print_quaternion_stats(quaternion_julia_t *julia);
+void render_quaternion_julia(quaternion_julia_t *julia, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, float c[4], float t, uint32_t width, uint32_t height, uint32_t frame_index);
+void destroy_quaternion_julia(quaternion_julia_t *julia, VkDevice logical_device);
+
+#endif /* fractal_quaternion_h */
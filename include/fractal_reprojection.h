@@ -0,0 +1,63 @@
+#ifndef fractal_reprojection_h
+#define fractal_reprojection_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+
+#define REPROJECTION_THREAD_COUNT 8
+#define REPROJECTION_TOLERANCE 0.5f//Pixels a reused sample may sit from where the texel would sample
+
+/*
+    Reuse of the previous frame's field while the window pans or zooms over a fixed c. Every texel keeps the
+    offset of the point it was actually sampled at from the point the window mode would sample it at. The
+    reprojection pass takes for each new texel the nearest texel of the previous frame, and keeps its colour
+    and its sample if that sample is within REPROJECTION_TOLERANCE pixels of the new texel's. Offsets are
+    carried exactly, so reuse never drifts however many frames a sample survives. Texels the window uncovered,
+    and texels whose nearest sample is too far, as when zooming in spreads the old samples apart, are appended
+    to the recompute buffer and the fractal compute runs over that list only.
+*/
+typedef struct reprojection_push_constants_t {
+    float x_min, x_max, y_min, y_max;
+    float previous_x_min, previous_x_max, previous_y_min, previous_y_max;
+    uint32_t width, height;
+    uint32_t previous_width, previous_height;
+    uint32_t valid;
+    float tolerance;
+    uint32_t padding[2];
+} reprojection_push_constants_t;
+
+typedef struct reprojection_stats_t {
+    uint32_t reused;
+    uint32_t recomputed;
+} reprojection_stats_t;
+
+typedef struct reprojection_t {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet *descriptors;
+
+    buffer_t *offset_buffers;//Sample offsets in the plane of each frame's texels
+    VkDeviceSize offset_size;
+    host_buffer_t *stats_buffers;
+
+    compute_push_constants_t previous;
+    uint32_t valid;//Whether the previous frame slot holds a field reprojection may use
+
+    uint64_t reused, recomputed;
+    double gpu_time;
+    uint32_t frames;
+} reprojection_t;
+
+reprojection_t initialise_reprojection(renderer_t *renderer, fractal_data_t *fractal_data);
+void collect_reprojection_stats(reprojection_t *reprojection, fractal_data_t *fractal_data, VkDevice logical_device, uint32_t frame_index);
+void print_reprojection_stats(reprojection_t *reprojection);
+void update_fractal_reprojected(reprojection_t *reprojection, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index);
+void destroy_reprojection(reprojection_t *reprojection, VkDevice logical_device);
+
+#endif /* fractal_reprojection_h */
@@ -0,0 +1,91 @@
+#ifndef fractal_virtual_h
+#define fractal_virtual_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <stdatomic.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+#include "tile_cache.h"
+
+#define VT_PAGE_SIZE 128
+#define VT_PAGE_BORDER 1//Copy of the neighbouring page so bilinear filtering never reads another slot
+#define VT_PAGE_PAYLOAD (VT_PAGE_SIZE - 2*VT_PAGE_BORDER)
+#define VT_ATLAS_PAGES 16//Slots per side of the atlas
+#define VT_SLOT_COUNT (VT_ATLAS_PAGES*VT_ATLAS_PAGES)
+#define VT_MAX_LEVEL 13//Beyond this float uv on the donut cannot address single texels
+#define VT_TABLE_SIZE 1024//Power of two, at most a quarter full
+#define VT_REQUEST_CAPACITY 1024
+#define VT_PAGES_PER_FRAME 8
+#define VT_STAGING_PAGES 16//Cache reads in flight
+#define VT_PAGE_TEXELS (VT_PAGE_SIZE*VT_PAGE_SIZE)
+#define VT_PAGE_BYTES (VT_PAGE_TEXELS*4*sizeof(float))
+#define VT_EMPTY 0xFFFFFFFFu
+
+/*
+    Virtual texture over one mirrored tile of uv, mapped to the [-1, 1]^2 window of the fractal.
+    Level L splits the tile into 2^L x 2^L pages of VT_PAGE_PAYLOAD texels. Resident pages live in slots of a
+    fixed atlas and are found through a hash table of (level, x, y) -> slot, so memory does not depend on the
+    virtual size. Fragments sample the finest resident page at or above the level their footprint needs and
+    report the next level down through a feedback buffer, the pages are then computed by shader.comp straight
+    into their slots and the least recently used ones evicted. With a tile cache, pages computed before are
+    uploaded from disk instead and newly computed ones are read back and stored.
+*/
+typedef struct vt_page_t {
+    uint32_t level, x, y;
+    uint32_t slot;
+} vt_page_t;
+
+typedef struct vt_feedback_t {
+    uint32_t request_count;
+    uint32_t padding[3];
+    uint32_t slot_used[VT_SLOT_COUNT];
+    vt_page_t requests[VT_REQUEST_CAPACITY];
+} vt_feedback_t;
+
+typedef struct vt_staging_t {
+    atomic_uint state;//tile_read_state_t, written by the tile cache's I/O thread
+    vt_page_t page;
+    uint64_t release_frame;//The upload out of this staging page has retired once the frame counter gets here
+} vt_staging_t;
+
+typedef struct virtual_texture_t {
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet *descriptors;
+    VkDescriptorSet atlas_descriptor;
+    VkSampler sampler;
+
+    image_t atlas;
+    VkImageView atlas_view;
+    uint32_t atlas_ready;
+
+    host_buffer_t *page_tables;
+    host_buffer_t *feedback;
+
+    vt_page_t table[VT_TABLE_SIZE];
+    vt_page_t slots[VT_SLOT_COUNT];
+    uint32_t slot_pending[VT_SLOT_COUNT];
+    uint64_t last_used[VT_SLOT_COUNT];
+    uint64_t frame;
+
+    tile_cache_t *cache;//Optional, pages are then read from and written back to disk
+    host_buffer_t staging;
+    vt_staging_t staging_pages[VT_STAGING_PAGES];
+    host_buffer_t *readback;
+    uint64_t *written_hashes;
+    uint32_t *written_counts;
+
+    complex float c;
+    uint32_t base_iterations;
+    uint32_t level_iterations;
+    uint32_t max_iterations;
+} virtual_texture_t;
+
+void initialise_virtual_texture(virtual_texture_t *texture, renderer_t *renderer, fractal_data_t *fractal_data, complex float c, tile_cache_t *cache);
+uint32_t update_virtual_texture(virtual_texture_t *texture, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, uint32_t frame_index);
+void finish_virtual_texture(virtual_texture_t *texture, VkCommandBuffer command_buffer, uint32_t frame_index);
+void destroy_virtual_texture(virtual_texture_t *texture, VkDevice logical_device);
+
+#endif /* fractal_virtual_h */
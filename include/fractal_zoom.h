@@ -0,0 +1,49 @@
+#ifndef fractal_zoom_h
+#define fractal_zoom_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "fractal.h"
+
+/*
+    Zoom sequences are synthesised from a single log-polar strip: column x is the angle 2*pi*(x + 0.5)/width
+    and row y is the log radius, linearly spaced from log_radius_min to log_radius_max around the zoom centre.
+    A frame of half width r only needs the rows between log(r) - log(texture_width/2) and log(r*sqrt(2)),
+    so every frame of the sequence is a cheap resample of the strip.
+*/
+typedef struct zoom_push_constants_t {
+    float log_radius;
+    float log_radius_min;
+    float log_radius_max;
+    uint32_t padding;
+} zoom_push_constants_t;
+
+typedef struct fractal_zoom_t {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+
+    VkDescriptorSetLayout descriptor_layout;
+    VkDescriptorSet *descriptors;
+    VkDescriptorSet strip_descriptor;
+    VkSampler sampler;
+
+    VkImageMemoryBarrier2 begin_barrier, end_barrier;
+
+    uint32_t strip_width, strip_height;
+    image_t strip_image;
+    VkImageView strip_image_view;
+
+    float centre[2];
+    float log_radius_min, log_radius_max;
+    uint32_t strip_ready;
+} fractal_zoom_t;
+
+fractal_zoom_t initialise_fractal_zoom(renderer_t *renderer, fractal_data_t *fractal_data, complex float centre, float log_radius_start, float log_radius_end, uint32_t strip_width, uint32_t rows_per_unit);
+void render_zoom_strip(fractal_zoom_t *zoom, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push);
+void update_zoom_frame(fractal_zoom_t *zoom, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, float log_radius, uint32_t frame_index);
+void destroy_fractal_zoom(fractal_zoom_t *zoom, VkDevice logical_device);
+
+#endif /* fractal_zoom_h */
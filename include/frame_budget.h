@@ -0,0 +1,48 @@
+#ifndef frame_budget_h
+#define frame_budget_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define BUDGET_HIGH_WATERMARK 1.1
+#define BUDGET_LOW_WATERMARK 0.4
+#define BUDGET_COOLDOWN_FRAMES 8
+#define BUDGET_RAISE_FRAMES 30
+#define BUDGET_SMOOTHING 0.2
+#define BUDGET_MIN_COST 0.01
+
+/*
+    One rung of the quality ladder. Each rung roughly halves the worst case cost of the one above,
+    alternating between fewer iterations and fewer pixels, with the bailout lowered alongside the iterations.
+*/
+typedef struct quality_level_t {
+    uint32_t max_iterations;
+    float resolution_scale;
+    float bailout;
+} quality_level_t;
+
+/*
+    Holds the fractal dispatch near target_time seconds. Measured times are divided by the predicted cost of the
+    frame they came from, so the frame about to be recorded can be judged by its own predicted cost before it runs.
+    Over the high watermark it drops as many rungs as the overshoot needs at once; it only climbs one rung after
+    BUDGET_RAISE_FRAMES consecutive frames under the low watermark, and ignores measurements for
+    BUDGET_COOLDOWN_FRAMES after every change so frames still in flight are not counted.
+*/
+typedef struct frame_budget_t {
+    double target_time;
+    double smoothed_time;//Per unit of predicted cost
+
+    uint32_t level;
+    uint32_t cooldown;
+    uint32_t frames_under;
+    uint32_t has_sample;
+} frame_budget_t;
+
+frame_budget_t initialise_frame_budget(double target_time);
+void update_frame_budget(frame_budget_t *budget, double dispatch_time, float measured_cost, float next_cost);
+quality_level_t current_quality(frame_budget_t *budget);
+uint32_t scaled_resolution(quality_level_t *quality, uint32_t texture_size);
+
+#endif /* frame_budget_h */
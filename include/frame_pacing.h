@@ -0,0 +1,46 @@
+#ifndef frame_pacing_h
+#define frame_pacing_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define PACING_LOW_LATENCY_FRAMES 1
+#define PACING_THROUGHPUT_FRAMES 3
+#define PACING_TARGET_FPS_FRAMES 2
+
+typedef enum pacing_mode_t {
+    PACING_LOW_LATENCY,//One frame in flight, so input is sampled only once the GPU has caught up
+    PACING_THROUGHPUT,//A deep queue that never waits for the display, for batch rendering
+    PACING_TARGET_FPS//Frames are started at a fixed rate, sleeping in between
+} pacing_mode_t;
+
+/*
+    Decides how far the CPU may run ahead of the GPU and when a frame may start, and measures the latency
+    from a frame's input being sampled to the CPU seeing its submission complete. Without a present timing
+    extension that is the closest observable point to the image reaching the display, and it is only seen
+    when the next frame waits or polls, so it is an upper bound off by at most one such gap.
+*/
+typedef struct frame_pacing_t {
+    pacing_mode_t mode;
+    uint32_t frame_count;
+
+    double frame_period;//Seconds, for PACING_TARGET_FPS
+    double next_start;
+
+    double *input_times;//Per frame in flight, of the frame last recorded in the slot, 0 once measured
+
+    double latency_sum, latency_max;
+    uint32_t latency_count;
+} frame_pacing_t;
+
+uint32_t pacing_frames_in_flight(pacing_mode_t mode);
+frame_pacing_t initialise_frame_pacing(pacing_mode_t mode, double target_fps);
+double pacing_time();
+void wait_for_frame_start(frame_pacing_t *pacing);
+void sample_frame_input(frame_pacing_t *pacing, uint32_t frame_index);
+void complete_frame(frame_pacing_t *pacing, uint32_t frame_index);
+void print_frame_pacing_stats(frame_pacing_t *pacing);
+void destroy_frame_pacing(frame_pacing_t *pacing);
+
+#endif /* frame_pacing_h */
@@ -0,0 +1,59 @@
+#ifndef gpu_scene_h
+#define gpu_scene_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "material.h"
+
+#define GPU_SCENE_THREAD_COUNT 64
+
+/*
+    An object as the cull shader and indirect.vert read it, laid out for std430. Its model is applied after
+    the model shared by the whole scene. The bounding sphere is in the mesh's own space and assumed to be
+    kept by both models, which only rotate and translate.
+*/
+typedef struct gpu_object_t {
+    transformation_t model;
+    float sphere[4];//Centre and radius
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t padding;
+} gpu_object_t;
+
+typedef struct gpu_cull_push_t {
+    transformation_t model;//Shared by every object
+    transformation_t view_projection;
+} gpu_cull_push_t;
+
+/*
+    A scene whose objects live in a storage buffer and are culled against the view frustum on the GPU. The
+    cull pass writes an indexed indirect command per visible object and their count, which the frame draws
+    with one vkCmdDrawIndexedIndirectCount, so the CPU's work per frame does not depend on the number of
+    objects. Commands and counts are per frame in flight, the objects are uploaded once.
+*/
+typedef struct gpu_scene_t {
+    uint32_t object_count;
+    uint32_t frame_count;
+    buffer_t object_buffer;
+    buffer_t *command_buffers;
+    buffer_t *count_buffers;
+
+    VkDescriptorSetLayout cull_layout;
+    VkDescriptorSet *cull_descriptors;
+    VkPipelineLayout cull_pipeline_layout;
+    VkPipeline cull_pipeline;
+
+    VkDescriptorSetLayout object_layout;//Set 2 of pipelines built with build_indirect_mesh_pipeline
+    VkDescriptorSet object_descriptor;
+} gpu_scene_t;
+
+uint32_t gpu_scene_supported(VkPhysicalDevice physical_device);
+void initialise_gpu_scene(gpu_scene_t *scene, renderer_t *renderer, gpu_object_t *objects, uint32_t object_count);
+void cull_gpu_scene(gpu_scene_t *scene, VkCommandBuffer command_buffer, transformation_t model, transformation_t view_projection, uint32_t frame_index);
+void draw_gpu_scene(gpu_scene_t *scene, VkCommandBuffer command_buffer, render_object_t *mesh, VkDescriptorSet global_descriptor, uint32_t frame_index);
+void destroy_gpu_scene(gpu_scene_t *scene, VkDevice logical_device);
+
+#endif /* gpu_scene_h */
@@ -27,6 +27,10 @@ typedef struct push_data_t {
 typedef struct scene_data_t {
     transformation_t view;
     transformation_t projection;
+    float texture_scale[2];//Fraction of the fractal texture written this frame
+    float julia_c[2];//Parameter of the procedural material
+    uint32_t julia_iterations;//Iteration cap of the procedural material, lowered further per fragment by its footprint
+    float padding[3];
 } scene_data_t;
 
 typedef struct render_object_t {
@@ -52,10 +56,16 @@ typedef struct {
     } texture_coordinates;
 } vertex_t;
 
-material_pipeline_t build_textured_mesh_pipeline(VkDevice logical_device, VkRenderPass render_pass, VkDescriptorSetLayout *scene_layout, VkDescriptorSetLayout *material_layout, VkExtent2D extent);
+material_pipeline_t build_material_pipeline(VkDevice logical_device, render_target_t target, uint32_t layout_count, VkDescriptorSetLayout *layouts, VkExtent2D extent, const char *vertex_file, const char *fragment_file);
+material_pipeline_t build_mesh_pipeline(VkDevice logical_device, render_target_t target, uint32_t layout_count, VkDescriptorSetLayout *layouts, VkExtent2D extent, const char *fragment_file);
+material_pipeline_t build_indirect_mesh_pipeline(VkDevice logical_device, render_target_t target, uint32_t layout_count, VkDescriptorSetLayout *layouts, VkExtent2D extent, const char *fragment_file);
+material_pipeline_t build_textured_mesh_pipeline(VkDevice logical_device, render_target_t target, VkDescriptorSetLayout *scene_layout, VkDescriptorSetLayout *material_layout, VkExtent2D extent);
+material_pipeline_t build_procedural_mesh_pipeline(VkDevice logical_device, render_target_t target, VkDescriptorSetLayout *scene_layout, VkExtent2D extent);
 
 VkSampler create_linear_sampler(VkDevice logical_device);
+void create_compute_layout(VkPipelineLayout *pipeline_layout, VkDevice logical_device, uint32_t layout_count, VkDescriptorSetLayout *layouts, uint32_t push_constant_size);
 void create_compute_pipeline_layout(VkPipelineLayout *pipeline_layout, VkDevice logical_device, VkDescriptorSetLayout layout);
 void create_compute_pipeline(VkPipeline *compute_pipeline, VkPipelineLayout pipeline_layout, VkDevice logical_device, const char *file_name);
+void create_compute_pipeline_from_code(VkPipeline *compute_pipeline, VkPipelineLayout pipeline_layout, VkDevice logical_device, const uint32_t *code, size_t code_size);
 
 #endif
\ No newline at end of file
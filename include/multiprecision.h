@@ -0,0 +1,37 @@
+#ifndef multiprecision_h
+#define multiprecision_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/*
+    Signed fixed-point numbers in two's complement. Limbs are little endian 32-bit words,
+    the top limb is the integer part and the remaining MP_FRACTION_LIMBS hold 32*MP_FRACTION_LIMBS fraction bits.
+    Products are accumulated in 64-bit columns so the inner loops vectorise.
+*/
+#define MP_LIMBS 16
+#define MP_FRACTION_LIMBS (MP_LIMBS - 1)
+
+typedef struct mp_t {
+    uint32_t limbs[MP_LIMBS];
+} mp_t;
+
+typedef struct mp_complex_t {
+    mp_t re, im;
+} mp_complex_t;
+
+mp_t mp_zero();
+mp_t mp_from_double(double x);
+mp_t mp_from_decimal(const char *string);
+double mp_to_double(mp_t *x);
+
+uint32_t mp_is_negative(mp_t *x);
+mp_t mp_negate(mp_t *x);
+mp_t mp_add(mp_t *a, mp_t *b);
+mp_t mp_sub(mp_t *a, mp_t *b);
+mp_t mp_mul(mp_t *a, mp_t *b);
+
+#endif /* multiprecision_h */
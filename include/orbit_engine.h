@@ -0,0 +1,52 @@
+#ifndef orbit_engine_h
+#define orbit_engine_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "multiprecision.h"
+#include "thread_pool.h"
+#include "fractal_orbit.h"
+
+/*
+    The fixed-point limbs only hold an integer part below 2^31, so orbits stop early once |z|^2 passes this
+*/
+#define MP_ORBIT_BAILOUT 268435456.0
+
+struct orbit_engine_t;
+
+typedef struct orbit_task_t {
+    struct orbit_engine_t *engine;
+    mp_complex_t z_0;
+    reference_orbit_t orbit;
+} orbit_task_t;
+
+/*
+    Reference orbits at full precision, computed off the render thread. A request spreads candidate starting points
+    around the view centre, one per task, plus the critical orbit. The last task to finish keeps the candidate that
+    stays bounded longest and builds the BLA levels, then the result is picked up with collect_reference_orbits.
+*/
+typedef struct orbit_engine_t {
+    thread_pool_t pool;
+
+    uint32_t candidate_count;
+    orbit_task_t *tasks;//candidate_count candidates followed by the critical orbit
+    uint32_t best;
+
+    mp_complex_t c;
+    double bailout, epsilon;
+    bla_table_t table;
+
+    atomic_uint pending;
+    atomic_uint ready;
+} orbit_engine_t;
+
+uint32_t compute_mp_reference_orbit(reference_orbit_t *orbit, mp_complex_t z_0, mp_complex_t c, double bailout);
+
+void initialise_orbit_engine(orbit_engine_t *engine, uint32_t thread_count, uint32_t candidate_count, uint32_t orbit_capacity, double bailout, double epsilon);
+uint32_t request_reference_orbits(orbit_engine_t *engine, mp_complex_t centre, double radius, mp_complex_t c);
+uint32_t collect_reference_orbits(orbit_engine_t *engine, reference_orbit_t orbits[ORBIT_COUNT]);
+void destroy_orbit_engine(orbit_engine_t *engine);
+
+#endif /* orbit_engine_h */
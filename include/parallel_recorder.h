@@ -0,0 +1,57 @@
+#ifndef parallel_recorder_h
+#define parallel_recorder_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "vulkan_resources.h"
+#include "thread_pool.h"
+#include "draw_list.h"
+
+#define RECORDER_MIN_OBJECTS 64//Fewer draws than this per thread are not worth a secondary buffer
+
+struct parallel_recorder_t;
+
+/*
+    A contiguous run of a scene's objects and the secondary buffer they are recorded into
+*/
+typedef struct recording_job_t {
+    struct parallel_recorder_t *recorder;
+    VkCommandBuffer command_buffer;
+
+    render_object_t *objects;
+    uint32_t object_count;
+    VkDescriptorSet global_descriptor;
+
+    VkRenderPass render_pass;//VK_NULL_HANDLE with dynamic rendering, the formats are inherited instead
+    VkFramebuffer framebuffer;
+    VkFormat color_format, depth_format;
+    VkViewport viewport;
+    VkRect2D scissor;
+
+    draw_stats_t stats;
+} recording_job_t;
+
+/*
+    Records a scene's draws on worker threads. Every thread has a command allocator per frame in flight, so
+    a frame's allocators can be reset as a whole once it has been waited for and no two threads ever record
+    from the same pool. The secondary buffers continue the primary's rendering and are executed from it in
+    scene order, which must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+*/
+typedef struct parallel_recorder_t {
+    thread_pool_t pool;
+    uint32_t thread_count;
+    uint32_t frame_count;
+
+    command_allocator_t *command_allocators;//thread_count per frame in flight
+    VkCommandBuffer *command_buffers;//The secondary buffers of the frame being recorded, in scene order
+    recording_job_t *jobs;
+} parallel_recorder_t;
+
+void initialise_parallel_recorder(parallel_recorder_t *recorder, renderer_t *renderer, uint32_t thread_count);
+void record_draws_parallel(parallel_recorder_t *recorder, renderer_t *renderer, VkCommandBuffer command_buffer, uint32_t image_index, render_object_t *objects, uint32_t object_count, VkDescriptorSet global_descriptor, uint32_t frame_index, draw_stats_t *stats);
+void destroy_parallel_recorder(parallel_recorder_t *recorder, VkDevice logical_device);
+
+#endif /* parallel_recorder_h */
@@ -0,0 +1,150 @@
+#ifndef render_graph_h
+#define render_graph_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+#include "renderer.h"
+#include "vulkan_resources.h"
+
+#define GRAPH_MAX_PASSES 32
+#define GRAPH_MAX_RESOURCES 32
+#define GRAPH_MAX_ACCESSES 128
+
+#define GRAPH_PASS_SIDE_EFFECTS 1//Never culled, for passes whose results leave the graph some other way, e.g. presenting
+
+typedef enum graph_resource_type_t {
+    GRAPH_RESOURCE_IMAGE,
+    GRAPH_RESOURCE_BUFFER
+} graph_resource_type_t;
+
+typedef void (*graph_record_t)(VkCommandBuffer command_buffer, void *data, uint32_t frame_index);
+
+/*
+    A use of a resource by a pass. Whether it writes is read off the access mask, the layout is ignored for buffers.
+*/
+typedef struct graph_access_t {
+    uint32_t resource;
+    VkPipelineStageFlags2 stages;
+    VkAccessFlags2 access;
+    VkImageLayout layout;
+} graph_access_t;
+
+/*
+    What the graph knows of a resource between passes: the last write, whether it has been made visible to
+    the stages and accesses that read it since, and the stages of those reads, which the next write waits for
+*/
+typedef struct graph_state_t {
+    VkPipelineStageFlags2 write_stages, read_stages, visible_stages;
+    VkAccessFlags2 write_access, visible_access;
+    VkImageLayout layout;
+} graph_state_t;
+
+/*
+    Imported resources are owned by the caller, who sets their handles before every execution. Transient
+    resources are owned by the graph and only live between their first and last use within a frame, so any
+    two whose uses do not overlap can share memory. Each frame in flight has its own copy.
+*/
+typedef struct graph_resource_t {
+    const char *name;
+    graph_resource_type_t type;
+    uint32_t transient;
+    uint32_t exported;//Read after the graph, so the passes writing it are never culled
+
+    VkImageAspectFlags aspect;
+    uint32_t width, height;
+    VkFormat format;
+    VkImageUsageFlags image_usage;
+    VkDeviceSize size;
+    VkBufferUsageFlags buffer_usage;
+
+    graph_state_t initial;//Of imported resources at the start of every execution
+
+    uint32_t first_pass, last_pass;//Lifetime in passes of transient resources
+    VkDeviceSize offset;//Into the frame's transient memory
+    VkMemoryRequirements requirements;
+
+    VkImage *images;//One per frame in flight
+    VkImageView *image_views;
+    VkBuffer *buffers;
+} graph_resource_t;
+
+/*
+    Barriers are derived once when the graph is compiled. Only the handles change between executions, so a
+    barrier keeps the index of its resource and the handle is filled in as the pass is executed. Each carries
+    its own stages, so a barrier only waits for the work that touched its resource.
+*/
+typedef struct graph_barrier_t {
+    uint32_t resource;
+    VkPipelineStageFlags2 source_stages, destination_stages;
+    VkAccessFlags2 source_access, destination_access;
+    VkImageLayout old_layout, new_layout;
+} graph_barrier_t;
+
+typedef struct graph_pass_t {
+    const char *name;
+    graph_record_t record;
+    void *data;
+    uint32_t flags;
+    uint32_t culled;
+
+    uint32_t first_access, access_count;
+    uint32_t first_barrier, barrier_count;
+} graph_pass_t;
+
+typedef struct render_graph_stats_t {
+    uint32_t pass_count, culled_passes;
+    uint32_t barrier_count;//Per execution
+    uint32_t barrier_batches;//vkCmdPipelineBarrier2 calls per execution
+    VkDeviceSize transient_memory;//Per frame in flight, with aliasing
+    VkDeviceSize unaliased_memory;//What the transient resources would take without it
+} render_graph_stats_t;
+
+/*
+    A frame described as passes that declare the resources they use, in the order they execute. Compiling
+    culls the passes nothing depends on, places transient resources in memory, aliasing the ones whose
+    lifetimes do not overlap, and derives the barriers between passes. A pass's barriers are batched into
+    a single vkCmdPipelineBarrier2 ahead of it. Barriers inside a render pass are still its subpass
+    dependencies; the graph only orders the work around it.
+*/
+typedef struct render_graph_t {
+    uint32_t frame_count;
+    uint32_t compiled;
+
+    uint32_t resource_count;
+    graph_resource_t resources[GRAPH_MAX_RESOURCES];
+
+    uint32_t pass_count;
+    graph_pass_t passes[GRAPH_MAX_PASSES];
+
+    uint32_t access_count;
+    graph_access_t accesses[GRAPH_MAX_ACCESSES];
+
+    uint32_t barrier_count;
+    graph_barrier_t barriers[GRAPH_MAX_ACCESSES];
+
+    VkDeviceMemory *transient_memory;//One allocation per frame in flight, VK_NULL_HANDLE without transients
+
+    render_graph_stats_t stats;
+} render_graph_t;
+
+void initialise_render_graph(render_graph_t *graph, uint32_t frame_count);
+uint32_t import_graph_image(render_graph_t *graph, const char *name, VkImageAspectFlags aspect, VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout);
+uint32_t import_graph_buffer(render_graph_t *graph, const char *name, VkPipelineStageFlags2 stages, VkAccessFlags2 access);
+uint32_t create_graph_image(render_graph_t *graph, const char *name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+uint32_t create_graph_buffer(render_graph_t *graph, const char *name, VkDeviceSize size, VkBufferUsageFlags usage);
+void export_graph_resource(render_graph_t *graph, uint32_t resource);
+uint32_t add_graph_pass(render_graph_t *graph, const char *name, graph_record_t record, void *data, uint32_t flags);
+void use_graph_resource(render_graph_t *graph, uint32_t pass, uint32_t resource, VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout);
+void compile_render_graph(render_graph_t *graph, renderer_t *renderer);
+void set_graph_image(render_graph_t *graph, uint32_t resource, VkImage image, uint32_t frame_index);
+void set_graph_buffer(render_graph_t *graph, uint32_t resource, VkBuffer buffer, uint32_t frame_index);
+VkImage graph_image(render_graph_t *graph, uint32_t resource, uint32_t frame_index);
+VkImageView graph_image_view(render_graph_t *graph, uint32_t resource, uint32_t frame_index);
+VkBuffer graph_buffer(render_graph_t *graph, uint32_t resource, uint32_t frame_index);
+void execute_render_graph(render_graph_t *graph, VkCommandBuffer command_buffer, uint32_t frame_index);
+void print_render_graph_stats(render_graph_t *graph);
+void destroy_render_graph(render_graph_t *graph, VkDevice logical_device);
+
+#endif /* render_graph_h */
@@ -8,6 +8,8 @@
 #include "vulkan_swapchain.h"
 #include "vulkan_command_buffers.h"
 #include "material.h"
+#include "frame_pacing.h"
+#include "depth_manager.h"
 
 typedef struct buffer_t {
     VkBuffer buffer;
@@ -33,12 +35,38 @@ typedef struct host_image_t {
 
 typedef struct frame_t {
     VkSemaphore image_available_semaphore, render_finished_semaphore;
-    VkFence in_flight_fence;
+    uint64_t timeline_value;//Reached by the renderer's timeline once the slot's last submission has completed
 
-    VkCommandPool command_pool;
-    VkCommandBuffer command_buffer;
+    command_allocator_t command_allocator;
+    VkCommandBuffer command_buffer;//The frame's main primary buffer, allocated anew from command_allocator every frame
 } frame_t;
 
+struct renderer_t;
+
+typedef void (*deletion_t)(struct renderer_t *renderer, void *data);
+
+/*
+    Destroys data once the frame timeline has reached timeline_value, i.e. once every frame submitted
+    before it was deferred has completed
+*/
+typedef struct deferred_deletion_t {
+    uint64_t timeline_value;
+    deletion_t destroy;
+    void *data;
+} deferred_deletion_t;
+
+/*
+    Everything tied to a swapchain that has been replaced, kept until the frames still using it have completed
+*/
+typedef struct retired_swapchain_t {
+    VkSwapchainKHR swapchain;
+    uint32_t image_count;
+    VkImage *images;
+    VkImageView *image_views;
+    VkFramebuffer *framebuffers;
+    uint32_t framebuffer_count;
+} retired_swapchain_t;
+
 typedef struct renderer_t {
     VkInstance instance;
     VkSurfaceKHR surface;
@@ -50,24 +78,31 @@ typedef struct renderer_t {
     uint32_t graphics_family;
 
     VkSwapchainKHR swapchain;
+    VkPresentModeKHR present_mode;//Chosen once for the pacing mode, kept across recreation
     VkExtent2D extent;
     VkFormat swapchain_image_format;
     uint32_t swapchain_image_count;
     VkImage *swapchain_images;
     VkImageView *swapchain_image_views;
-    VkFramebuffer *framebuffers;
+    VkFramebuffer *framebuffers;//Per frame in flight and swapchain image, as depth is per frame, NULL with dynamic rendering
 
+    uint32_t dynamic_rendering;//The scene is drawn with vkCmdBeginRendering, without a render pass or framebuffers
     VkRenderPass render_pass;
-    VkFormat depth_image_format;
-    image_t *depth_images;
-    VkImageView *depth_image_views;
+    depth_manager_t depth;
 
     VkCommandPool command_pool;
     VkDescriptorPool global_pool;
 
-    uint32_t frame_index;
+    uint32_t frame_index;//Of the frame being recorded, set by begin_frame
     uint32_t frame_count;
     frame_t *frames;
+
+    VkSemaphore frame_timeline;//Signalled with the frame number as each frame's submission completes
+    uint64_t frame_number;
+    frame_pacing_t pacing;
+
+    deferred_deletion_t *deletions;
+    uint32_t deletion_count, deletion_capacity;
 } renderer_t;
 
 typedef struct engine_t {
@@ -82,7 +117,7 @@ void run(engine_t *engine);
 void initialise_renderer(renderer_t *renderer, window_t window);
 void terminate_renderer(renderer_t *renderer);
 
-void setup_swapchain(renderer_t *renderer, window_t window);
+void setup_swapchain(renderer_t *renderer, window_t window, VkSwapchainKHR old_swapchain);
 void recreate_swapchain(renderer_t *renderer, window_t window);
 void terminate_swapchain(renderer_t *renderer);
 
@@ -91,14 +126,25 @@ void destroy_render_pass(renderer_t *renderer);
 
 void setup_framebuffers(renderer_t *renderer);
 void destroy_framebuffers(renderer_t *renderer);
+VkFramebuffer scene_framebuffer(renderer_t *renderer, uint32_t image_index);
+
+render_target_t scene_render_target(renderer_t *renderer);
+void begin_scene_rendering(renderer_t *renderer, VkCommandBuffer command_buffer, uint32_t image_index, VkClearValue clear_values[2], VkSubpassContents contents);
+void end_scene_rendering(renderer_t *renderer, VkCommandBuffer command_buffer, uint32_t image_index);
 
 void setup_depth_resources(renderer_t *renderer);
 void destroy_depth_resources(renderer_t *renderer);
 
+void defer_deletion(renderer_t *renderer, deletion_t destroy, void *data);
+void flush_deletions(renderer_t *renderer, uint64_t completed_value);
+
 void setup_frame_resources(renderer_t *renderer, uint32_t frame_count);
 void destroy_frame_resources(renderer_t *renderer);
 
 host_buffer_t create_host_buffer(renderer_t *renderer, VkDeviceSize device_size, VkQueue queue);
+host_buffer_t create_mapped_buffer(renderer_t *renderer, VkDeviceSize device_size, VkBufferUsageFlags usage);
+buffer_t create_device_buffer(renderer_t *renderer, VkDeviceSize device_size, VkBufferUsageFlags usage);
+void upload_buffer(renderer_t *renderer, buffer_t *destination, void *data, VkDeviceSize size);
 buffer_t create_vertex_buffer(renderer_t *renderer, uint32_t vertex_count, size_t vertex_size, void *vertices, VkQueue queue, VkCommandBuffer command_buffer);
 buffer_t create_index_buffer(renderer_t *renderer, uint32_t index_count, uint16_t indices[], VkQueue queue, VkCommandBuffer command_buffer);
 image_t create_image(renderer_t *renderer, uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits sample_count, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties);
@@ -112,9 +158,11 @@ void clean_up_frame(frame_t *frames, VkDevice logical_device);
 void clean_up_frames(frame_t *frames, uint32_t frame_count, VkDevice logical_device);
 
 
+void wait_for_frame(renderer_t *renderer, uint32_t frame_index);
 uint32_t begin_frame(engine_t *engine, uint32_t frame_index);
 void end_frame(engine_t *engine, uint32_t frame_index, uint32_t image_index);
 void draw_frame(engine_t *engine, uint32_t frame_index);
 void draw_mesh(frame_t *frame, render_object_t *object, VkDescriptorSet global_descriptor);
+void record_draw(VkCommandBuffer command_buffer, render_object_t *object, VkDescriptorSet global_descriptor);
 
 #endif /* renderer_h */
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef thread_pool_h
+#define thread_pool_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+typedef void (*task_function_t)(void *argument);
+
+typedef struct task_t {
+    task_function_t function;
+    void *argument;
+} task_t;
+
+/*
+    Fixed set of worker threads consuming a bounded ring of tasks. submit_task blocks while the ring is full,
+    so it must not be called from inside a task.
+*/
+typedef struct thread_pool_t {
+    uint32_t thread_count;
+    pthread_t *threads;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t task_available, slot_available, tasks_done;
+
+    uint32_t capacity, head, count;
+    task_t *tasks;
+
+    uint32_t active;
+    uint32_t stop;
+} thread_pool_t;
+
+uint32_t hardware_thread_count(void);
+void initialise_thread_pool(thread_pool_t *pool, uint32_t thread_count, uint32_t capacity);
+void submit_task(thread_pool_t *pool, task_function_t function, void *argument);
+void wait_for_tasks(thread_pool_t *pool);
+void destroy_thread_pool(thread_pool_t *pool);
+
+#endif /* thread_pool_h */
@@ -0,0 +1,78 @@
+#ifndef tile_cache_h
+#define tile_cache_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "thread_pool.h"
+
+#define TILE_CACHE_MAGIC 0x656c6974
+#define TILE_CACHE_VERSION 1//Bump when shader.comp colours tiles differently, old payloads are then dropped
+#define TILE_CACHE_CAPACITY (1 << 16)//Index entries, power of two
+#define TILE_CACHE_MAX_LOAD 2//Stores stop once 1/TILE_CACHE_MAX_LOAD of the index is used
+#define TILE_CACHE_QUEUE 64
+
+/*
+    Computed fractal tiles memoized on disk. A tile is identified by everything shader.comp reads for it,
+    hashed to 64 bits. The index is an open-addressed table of hash -> payload offset in a memory-mapped file,
+    payloads are appended to a second file as RGBA8, a quarter of the RGBA32F the tiles are rendered in.
+    All file traffic goes through a single I/O thread: reads decode straight into the caller's staging memory
+    and flag completion, stores are encoded on submission so the caller's buffer can be reused immediately.
+*/
+typedef struct tile_key_t {
+    uint32_t formula;
+    float c[2];
+    float window[4];//x_min, x_max, y_min, y_max
+    uint32_t width, height;
+    uint32_t max_iterations;
+    float bailout;
+} tile_key_t;
+
+typedef enum tile_read_state_t {
+    TILE_READ_IDLE = 0,
+    TILE_READ_PENDING,
+    TILE_READ_DONE,
+    TILE_READ_FAILED
+} tile_read_state_t;
+
+typedef struct tile_index_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t count;
+    uint64_t payload_size;//Payloads past this offset were never indexed and are overwritten
+    uint64_t padding;
+} tile_index_header_t;
+
+typedef struct tile_index_entry_t {
+    uint64_t hash;//0 marks an empty entry
+    uint64_t offset;
+    uint32_t size;
+    uint32_t padding;
+} tile_index_entry_t;
+
+typedef struct tile_cache_t {
+    FILE *payload;
+    size_t index_size;
+    tile_index_header_t *header;
+    tile_index_entry_t *entries;
+    int index_descriptor;
+    const char *index_name;
+
+    pthread_mutex_t mutex;
+    thread_pool_t io_thread;
+
+    uint64_t hits, misses, stores;
+} tile_cache_t;
+
+void open_tile_cache(tile_cache_t *cache, const char *index_name, const char *payload_name);
+uint64_t tile_hash(tile_key_t *key);
+uint32_t tile_cached(tile_cache_t *cache, uint64_t hash);
+void read_tile(tile_cache_t *cache, uint64_t hash, float *destination, uint32_t texel_count, atomic_uint *state);
+void store_tile(tile_cache_t *cache, uint64_t hash, const float *texels, uint32_t texel_count);
+void close_tile_cache(tile_cache_t *cache);
+
+#endif /* tile_cache_h */
@@ -7,14 +7,37 @@
 #include <vulkan/vulkan.h>
 #include "vulkan_utils.h"
 
+/*
+    A command pool owned by one frame in flight, or one thread of one frame. Buffers are handed out in
+    order and all of them are reset together with the pool once the frame has been waited for, so the
+    buffers allocated for earlier frames are reused and the cost of a reset does not grow with their number.
+*/
+typedef struct command_allocator_t {
+    VkCommandPool command_pool;
+
+    VkCommandBuffer *primary_buffers, *secondary_buffers;
+    uint32_t primary_count, secondary_count;//Allocated from the pool so far
+    uint32_t primary_used, secondary_used;//Handed out since the last reset
+} command_allocator_t;
+
 void create_primary_command_buffer(VkCommandBuffer *command_buffer, VkDevice logical_device, VkCommandPool command_pool, uint32_t num_buffers);
 void create_secondary_command_buffer(VkCommandBuffer *command_buffer, VkDevice logical_device, VkCommandPool command_pool, uint32_t num_buffers);
 
 void begin_command_buffer(VkCommandBuffer command_buffer, VkCommandBufferUsageFlags usage);
+void begin_secondary_command_buffer(VkCommandBuffer command_buffer, VkRenderPass render_pass, uint32_t subpass, VkFramebuffer framebuffer);
+void begin_secondary_rendering_buffer(VkCommandBuffer command_buffer, VkFormat color_format, VkFormat depth_format);
 void end_command_buffer(VkCommandBuffer command_buffer);
 
 void submit_command_buffer(VkQueue queue, VkCommandBuffer command_buffer);
 void reset_command_pool(VkDevice device, VkCommandPool command_pool);
+
+void create_command_allocator(command_allocator_t *allocator, VkDevice logical_device, uint32_t queue_family);
+VkCommandBuffer allocate_primary_buffer(command_allocator_t *allocator, VkDevice logical_device);
+VkCommandBuffer allocate_secondary_buffer(command_allocator_t *allocator, VkDevice logical_device);
+void reset_command_allocator(command_allocator_t *allocator, VkDevice logical_device);
+void destroy_command_allocator(command_allocator_t *allocator, VkDevice logical_device);
+
+void pipeline_barrier(VkCommandBuffer command_buffer, uint32_t memory_barrier_count, const VkMemoryBarrier2 *memory_barriers, uint32_t buffer_barrier_count, const VkBufferMemoryBarrier2 *buffer_barriers, uint32_t image_barrier_count, const VkImageMemoryBarrier2 *image_barriers);
     
 
 
@@ -28,6 +28,15 @@ typedef struct pipeline_details_t {
     VkPipelineLayout layout;
 } pipeline_details_t;
 
+/*
+    What a graphics pipeline is compiled against. Without a render pass the pipeline is made for dynamic
+    rendering into attachments of the given formats, and only has to match those.
+*/
+typedef struct render_target_t {
+    VkRenderPass render_pass;
+    VkFormat color_format, depth_format;
+} render_target_t;
+
 void create_render_pass(VkRenderPass *render_pass, uint32_t attachment_count, VkAttachmentDescription *attachment_descriptions, VkSubpassDescription *sub_pass);
 
 void create_render_pass_simple(VkRenderPass *render_pass, VkDevice logical_device, VkFormat image_format);
@@ -50,6 +59,6 @@ void set_blend_attachment_none(VkPipelineColorBlendAttachmentState *color_blend_
 void set_depth_test_none(pipeline_details_t *pipeline_details);
 void create_render_pass_depth_buffered(VkRenderPass *render_pass, VkDevice logical_device, VkFormat render_image_format, VkFormat depth_image_format);
 
-VkPipeline create_graphics_pipeline(VkDevice logical_device, VkPipelineLayout pipeline_layout, VkRenderPass render_pass, pipeline_details_t *pipeline_details);
+VkPipeline create_graphics_pipeline(VkDevice logical_device, VkPipelineLayout pipeline_layout, render_target_t target, pipeline_details_t *pipeline_details);
 
 #endif /* vulkan_render_pipeline_h */
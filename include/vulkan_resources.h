@@ -14,6 +14,7 @@
 #include "vulkan_utils.h"
 
 uint32_t select_memory_type(VkPhysicalDevice physical_device, uint32_t type_filter, VkMemoryPropertyFlags properties);
+uint32_t compute_subgroup_support(VkPhysicalDevice physical_device, VkSubgroupFeatureFlags operations);
 
 
 VkImageView create_image_view(VkImage image, VkDevice logical_device, uint32_t mip_levels, VkFormat image_format, VkImageAspectFlags aspect_flags);
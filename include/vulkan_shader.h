@@ -9,6 +9,8 @@
 
 uint32_t parse_file(const char *file_name, char **buffer);
 
+void create_shader_module(VkShaderModule *shader_module, VkDevice logical_device, const uint32_t *code, size_t code_size);
+
 void load_shader_module(VkShaderModule *shader_module, VkDevice logical_device, const char *file_name);
 
 VkPipelineShaderStageCreateInfo create_shader_stage(VkShaderModule shader_module, VkShaderStageFlagBits shader_stage);
@@ -14,10 +14,10 @@
 #include "vulkan_device.h"
 #include "vulkan_utils.h"
 
-VkPresentModeKHR choose_swap_present_mode(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
+VkPresentModeKHR choose_swap_present_mode(VkPhysicalDevice physical_device, VkSurfaceKHR surface, const VkPresentModeKHR *preferred_modes, uint32_t preferred_count);
 VkSurfaceFormatKHR choose_swap_surface_format(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
 
-void create_swapchain(VkSwapchainKHR *swapchain, VkDevice device, VkPhysicalDevice physical_device, VkSurfaceKHR surface, uint32_t image_count, VkExtent2D image_extent);
+void create_swapchain(VkSwapchainKHR *swapchain, VkDevice device, VkPhysicalDevice physical_device, VkSurfaceKHR surface, uint32_t image_count, VkExtent2D image_extent, VkPresentModeKHR present_mode, VkSwapchainKHR old_swapchain);
 void get_swapchain_images(VkSwapchainKHR swapchain, VkDevice device, dynamic_vector *swapchain_images);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#version 460
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec4 in_color;
+layout(location = 2) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec2 out_uv;
+
+layout( push_constant ) uniform object_block {
+    mat4 model;
+    float t;
+} push;
+
+layout(set = 0, binding = 0) uniform scene {
+    mat4 view;
+    mat4 projection;
+    vec2 texture_scale;
+    vec2 julia_c;
+    uint julia_iterations;
+} scene_data;
+
+struct object_t {
+    mat4 model;
+    vec4 sphere;
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint padding;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer object_buffer {
+    object_t objects[];
+};
+
+//The cull pass sets each draw's first instance to its object's index
+void main() {
+    gl_Position = vec4(in_position, 1.0) * push.model * objects[gl_InstanceIndex].model * scene_data.view * scene_data.projection;
+    out_color = in_color;
+    out_uv = in_uv;
+}
@@ -0,0 +1,106 @@
+#version 460
+#define PI (3.1415926535897932384626433832795)
+#define R_SQUARED 1e15
+#define MIN_ITERATIONS 16.0
+#define BASE_ITERATIONS 32.0
+#define ITERATIONS_PER_OCTAVE 24.0
+
+layout(location = 0) in vec4 frag_color;
+layout(location = 1) in vec2 uv;
+
+layout( push_constant ) uniform object_block {
+    mat4 model;
+    float t;
+} push;
+
+layout(set = 0, binding = 0) uniform scene {
+    mat4 view;
+    mat4 projection;
+    vec2 texture_scale;
+    vec2 julia_c;
+    uint julia_iterations;
+} scene_data;
+
+layout(location = 0) out vec4 out_color;
+
+float unit_wave(float x) {
+    return (1.0 - cos(PI*x)) * 0.5;
+}
+
+vec3 C_alt(float H) {
+    float h = fract(H);
+    float r = unit_wave(h);
+    float b = unit_wave(h + 1.0);
+    float g = 1 - unit_wave(h + 0.5);
+    vec3 C = vec3(r, 0.75*g, b);
+    return C*C;
+}
+
+vec3 hsv_to_rgb(float H, float S, float V) {
+    return V*(S*(C_alt(H) - 1.0) + 1.0);
+}
+
+vec3 color_mag(vec2 z, float d) {
+    float h = -length(z)+push.t-log(d)/8;
+    return vec3(h, 0.95, 0.95);
+}
+
+vec3 color_gradient(vec2 z, float t) {
+    float a = 0.25, b = 0.125;
+    return 0.5 + 0.5*cos(2.0*PI*(a*t + b*(z.xyx + vec3(0.0, 1.0, 2.0))));
+}
+
+//Same tiling as the mirrored repeat sampler used for the fractal texture
+vec2 mirrored(vec2 x) {
+    return 1.0 - abs(mod(x, 2.0) - 1.0);
+}
+
+/*
+    d() from shader.comp with the iteration cap passed in
+*/
+float d(vec2 z_0, vec2 c, uint max_iterations) {
+    vec2 z = z_0;
+    float d_squared = 1.0;
+    float m_squared = z.x*z.x + z.y*z.y;
+    float a, b;
+    uint i;
+
+    for(i = 0; i < max_iterations && m_squared < R_SQUARED; i++) {
+        d_squared *= 4.0*m_squared;
+        a = z.x*z.x, b = z.y*z.y;
+        z = vec2((a - b), (2*z.x*z.y)) + c;
+        m_squared = a + b;
+    }
+
+    if(i == max_iterations)
+        return 0;
+
+    return sqrt(m_squared/d_squared)*0.5*log(m_squared);
+}
+
+/*
+    The window [-1, 1]^2 spans one tile of uv, so a pixel covers about 2*fwidth(uv) of the plane.
+    Detail finer than that cannot show, so the cap grows with the number of octaves below one tile,
+    and points closer to the set than the footprint fade into the interior colour instead of aliasing.
+*/
+void main() {
+    float footprint = 2.0*max(length(fwidth(uv)), 1e-7);
+    float octaves = log2(1.0/footprint);
+    uint max_iterations = uint(clamp(BASE_ITERATIONS + ITERATIONS_PER_OCTAVE*octaves, MIN_ITERATIONS, float(scene_data.julia_iterations)));
+
+    vec2 z = 2.0*mirrored(uv) - 1.0;
+    float estimate = d(z, scene_data.julia_c, max_iterations);
+
+    vec2 w = vec2(cos(0.25*push.t), sin(0.25*push.t));
+    z = vec2(w.x*z.x - w.y*z.y, w.x*z.y + w.y*z.x);
+
+    vec3 interior = color_gradient(z, push.t);
+    if(estimate > 0) {
+        vec3 hsv = color_mag(z, estimate);
+        vec3 exterior = hsv_to_rgb(hsv.x, hsv.y, hsv.z);
+
+        out_color = vec4(mix(interior, exterior, smoothstep(0.0, footprint, estimate)), 1);
+    } else {
+        out_color = vec4(interior, 1);
+    }
+}
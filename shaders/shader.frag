@@ -8,6 +8,14 @@ layout( push_constant ) uniform object_block {
     float t;
 } push;
 
+layout(set = 0, binding = 0) uniform scene {
+    mat4 view;
+    mat4 projection;
+    vec2 texture_scale;
+    vec2 julia_c;
+    uint julia_iterations;
+} scene_data;
+
 layout(set = 1, binding = 0) uniform texture2D texture_image;
 layout(set = 1, binding = 1) uniform sampler texture_sampler;
 
@@ -23,5 +31,5 @@ float Y = gl_FragCoord.y/800 - 1.0;
 
 float pi = 3.14159;
 void main() {
-    out_color = vec4(texture(sampler2D(texture_image, texture_sampler), uv));
+    out_color = vec4(texture(sampler2D(texture_image, texture_sampler), (1.0 - abs(mod(uv, 2.0) - 1.0))*scene_data.texture_scale));
 }
@@ -15,6 +15,9 @@ layout( push_constant ) uniform object_block {
 layout(set = 0, binding = 0) uniform scene {
     mat4 view;
     mat4 projection;
+    vec2 texture_scale;
+    vec2 julia_c;
+    uint julia_iterations;
 } scene_data;
 
 void main() {
@@ -0,0 +1,109 @@
+#version 460
+#define PAGE_SIZE 128
+#define PAGE_BORDER 1
+#define PAGE_PAYLOAD (PAGE_SIZE - 2*PAGE_BORDER)
+#define ATLAS_PAGES 16
+#define SLOT_COUNT (ATLAS_PAGES*ATLAS_PAGES)
+#define MAX_LEVEL 13
+#define TABLE_SIZE 1024
+#define REQUEST_CAPACITY 1024
+#define EMPTY 0xFFFFFFFFu
+
+layout(location = 0) in vec4 frag_color;
+layout(location = 1) in vec2 uv;
+
+layout( push_constant ) uniform object_block {
+    mat4 model;
+    float t;
+} push;
+
+layout(set = 0, binding = 0) uniform scene {
+    mat4 view;
+    mat4 projection;
+    vec2 texture_scale;
+    vec2 julia_c;
+    uint julia_iterations;
+} scene_data;
+
+layout(set = 1, binding = 0) uniform texture2D atlas_image;
+layout(set = 1, binding = 1) uniform sampler atlas_sampler;
+layout(std430, set = 1, binding = 2) readonly buffer page_table_buffer {
+    uvec4 page_table[];//level, x, y, slot
+};
+layout(std430, set = 1, binding = 3) buffer feedback_buffer {
+    uint request_count;
+    uint padding[3];
+    uint slot_used[SLOT_COUNT];
+    uvec4 requests[REQUEST_CAPACITY];
+};
+
+layout(location = 0) out vec4 out_color;
+
+//Same hash as page_hash() in fractal_virtual.c
+uint find_slot(uint level, uvec2 page) {
+    uint i = (page.x*73856093u ^ page.y*19349663u ^ level*83492791u) & (TABLE_SIZE - 1);
+
+    for(uint probe = 0; probe < TABLE_SIZE; probe++) {
+        uvec4 entry = page_table[i];
+
+        if(entry.x == EMPTY) {
+            return EMPTY;
+        }
+
+        if(entry.x == level && entry.yz == page) {
+            return entry.w;
+        }
+
+        i = (i + 1) & (TABLE_SIZE - 1);
+    }
+
+    return EMPTY;
+}
+
+/*
+    Samples the finest resident page at or above the level where a page texel matches the fragment's footprint,
+    and requests the page one level below the one found. Requesting one level at a time keeps every page's parent
+    resident, so refinement is progressive instead of waiting on deep pages. One fragment in four reports back.
+*/
+void main() {
+    vec2 m = 1.0 - abs(mod(uv, 2.0) - 1.0);
+    float footprint = max(length(dFdx(uv)), length(dFdy(uv)));
+    uint desired = uint(clamp(round(log2(1.0/(max(footprint, 1e-9)*float(PAGE_PAYLOAD)))), 0.0, float(MAX_LEVEL)));
+    bool report = (uint(gl_FragCoord.x) & 1) == 0 && (uint(gl_FragCoord.y) & 1) == 0;
+
+    uint level = desired + 1;
+    uint slot = EMPTY;
+    uvec2 page;
+    vec2 position;
+
+    do {
+        level--;
+        float pages = float(1u << level);
+
+        position = m*pages;
+        page = uvec2(min(floor(position), vec2(pages - 1.0)));
+        slot = find_slot(level, page);
+    } while(slot == EMPTY && level > 0);
+
+    if(slot == EMPTY) {
+        out_color = vec4(0, 0, 0, 1);
+        return;
+    }
+
+    if(report) {
+        slot_used[slot] = 1;
+
+        if(level < desired) {
+            uint index = atomicAdd(request_count, 1);
+            if(index < REQUEST_CAPACITY) {
+                uvec2 child = uvec2(min(floor(m*float(2u << level)), vec2(float(2u << level) - 1.0)));
+                requests[index] = uvec4(level + 1, child, 0);
+            }
+        }
+    }
+
+    vec2 local = clamp(position - vec2(page), 0.0, 1.0);
+    vec2 texel = vec2(slot % ATLAS_PAGES, slot / ATLAS_PAGES)*float(PAGE_SIZE) + float(PAGE_BORDER) + local*float(PAGE_PAYLOAD);
+
+    out_color = textureLod(sampler2D(atlas_image, atlas_sampler), texel/float(ATLAS_PAGES*PAGE_SIZE), 0.0);
+}
@@ -0,0 +1,142 @@
+#include "cost_map.h"
+#include "vulkan_utils.h"
+
+typedef struct cost_row_t {
+    cost_map_t *map;
+    uint32_t row;
+} cost_row_t;
+
+cost_sample_t measure_cost(float c_re, float c_im) {
+    uint32_t total = 0, interior = 0;
+
+    for(uint32_t j = 0; j < COST_MAP_SAMPLES; j++) {
+        for(uint32_t i = 0; i < COST_MAP_SAMPLES; i++) {
+            float re = 2.0f*((float)i + 0.5f)/(float)COST_MAP_SAMPLES - 1.0f;
+            float im = 2.0f*((float)j + 0.5f)/(float)COST_MAP_SAMPLES - 1.0f;
+            uint32_t n;
+
+            for(n = 0; n < COST_MAP_ITERATIONS && re*re + im*im < 4.0f; n++) {
+                float next_re = re*re - im*im + c_re;
+                im = 2.0f*re*im + c_im;
+                re = next_re;
+            }
+
+            total += n;
+            interior += n == COST_MAP_ITERATIONS;
+        }
+    }
+
+    float sample_count = (float)(COST_MAP_SAMPLES*COST_MAP_SAMPLES);
+    return (cost_sample_t){
+        .cost = (float)total/(sample_count*(float)COST_MAP_ITERATIONS),
+        .interior = (float)interior/sample_count
+    };
+}
+
+void cost_row_task(void *argument) {
+    cost_row_t *task = argument;
+    cost_map_t *map = task->map;
+
+    for(uint32_t x = 0; x < map->size; x++) {
+        float c_re = COST_MAP_EXTENT*(2.0f*((float)x + 0.5f)/(float)map->size - 1.0f);
+        float c_im = COST_MAP_EXTENT*(2.0f*((float)task->row + 0.5f)/(float)map->size - 1.0f);
+
+        map->samples[task->row*map->size + x] = measure_cost(c_re, c_im);
+    }
+}
+
+void build_cost_map(cost_map_t *map, uint32_t thread_count) {
+    thread_pool_t pool;
+    cost_row_t *rows = malloc(map->size*sizeof(cost_row_t));
+
+    if(rows == NULL) {
+        error(1, "Failed to allocate cost map rows\n");
+    }
+
+    initialise_thread_pool(&pool, thread_count, map->size);
+    for(uint32_t y = 0; y < map->size; y++) {
+        rows[y] = (cost_row_t){
+            .map = map,
+            .row = y
+        };
+        submit_task(&pool, cost_row_task, &rows[y]);
+    }
+    wait_for_tasks(&pool);
+    destroy_thread_pool(&pool);
+
+    free(rows);
+}
+
+/*
+    Reads the map from file_name if it was built with the current parameters, otherwise builds it and writes it back
+*/
+cost_map_t load_cost_map(const char *file_name, uint32_t thread_count) {
+    cost_map_t map = {
+        .size = COST_MAP_SIZE,
+        .samples = malloc(COST_MAP_SIZE*COST_MAP_SIZE*sizeof(cost_sample_t))
+    };
+
+    if(map.samples == NULL) {
+        error(1, "Failed to allocate cost map\n");
+    }
+
+    cost_map_header_t expected = {
+        .magic = COST_MAP_MAGIC,
+        .size = COST_MAP_SIZE,
+        .samples = COST_MAP_SAMPLES,
+        .iterations = COST_MAP_ITERATIONS
+    };
+    size_t sample_count = COST_MAP_SIZE*COST_MAP_SIZE;
+
+    FILE *file = fopen(file_name, "rb");
+    if(file != NULL) {
+        cost_map_header_t header;
+        uint32_t valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(&header, &expected, sizeof(header)) == 0
+            && fread(map.samples, sizeof(cost_sample_t), sample_count, file) == sample_count;
+        fclose(file);
+
+        if(valid) {
+            return map;
+        }
+    }
+
+    build_cost_map(&map, thread_count);
+
+    file = fopen(file_name, "wb");
+    if(file != NULL) {
+        fwrite(&expected, sizeof(expected), 1, file);
+        fwrite(map.samples, sizeof(cost_sample_t), sample_count, file);
+        fclose(file);
+    }
+
+    return map;
+}
+
+/*
+    Bilinear lookup, c outside the map is clamped to its border
+*/
+cost_sample_t predict_cost(cost_map_t *map, complex float c) {
+    float x = ((crealf(c)/COST_MAP_EXTENT + 1.0f)*0.5f)*(float)map->size - 0.5f;
+    float y = ((cimagf(c)/COST_MAP_EXTENT + 1.0f)*0.5f)*(float)map->size - 0.5f;
+    float max = (float)(map->size - 1);
+
+    x = fminf(fmaxf(x, 0.0f), max);
+    y = fminf(fmaxf(y, 0.0f), max);
+
+    uint32_t x_0 = (uint32_t)x, y_0 = (uint32_t)y;
+    uint32_t x_1 = x_0 + (x_0 < map->size - 1), y_1 = y_0 + (y_0 < map->size - 1);
+    float u = x - (float)x_0, v = y - (float)y_0;
+
+    cost_sample_t s_00 = map->samples[y_0*map->size + x_0], s_10 = map->samples[y_0*map->size + x_1];
+    cost_sample_t s_01 = map->samples[y_1*map->size + x_0], s_11 = map->samples[y_1*map->size + x_1];
+
+    return (cost_sample_t){
+        .cost = (1 - v)*((1 - u)*s_00.cost + u*s_10.cost) + v*((1 - u)*s_01.cost + u*s_11.cost),
+        .interior = (1 - v)*((1 - u)*s_00.interior + u*s_10.interior) + v*((1 - u)*s_01.interior + u*s_11.interior)
+    };
+}
+
+void destroy_cost_map(cost_map_t *map) {
+    free(map->samples);
+    map->samples = NULL;
+}
@@ -0,0 +1,120 @@
+#include "depth_manager.h"
+
+/*
+    D16 is required to be renderable, so the search always succeeds. The scene's depth range is small
+    enough for 16 bits, and nothing uses stencil.
+*/
+VkFormat choose_depth_format(VkPhysicalDevice physical_device) {
+    const VkFormat candidates[] = {VK_FORMAT_D16_UNORM, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D32_SFLOAT};
+
+    for(uint32_t i = 0; i < sizeof(candidates)/sizeof(VkFormat); i++) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physical_device, candidates[i], &properties);
+
+        if(properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            return candidates[i];
+        }
+    }
+
+    error(1, "Failed to find a depth format\n");
+    return VK_FORMAT_UNDEFINED;
+}
+
+void initialise_depth_manager(depth_manager_t *depth, VkPhysicalDevice physical_device, uint32_t target_count) {
+    *depth = (depth_manager_t){
+        .format = choose_depth_format(physical_device),
+        .extent = {0, 0},
+        .target_count = target_count,
+        .targets = NULL,
+        .memory_size = 0
+    };
+}
+
+uint32_t depth_targets_match(depth_manager_t *depth, VkExtent2D extent) {
+    return depth->targets != NULL && depth->extent.width == extent.width && depth->extent.height == extent.height;
+}
+
+static depth_target_t create_depth_target(depth_manager_t *depth, VkDevice logical_device, VkPhysicalDevice physical_device, VkExtent2D extent) {
+    depth_target_t target;
+
+    VkImageCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .extent = {extent.width, extent.height, 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .format = depth->format,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+    };
+
+    if(vkCreateImage(logical_device, &create_info, NULL, &target.image) != VK_SUCCESS) {
+        error(1, "Failed to create depth image\n");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetImageMemoryRequirements(logical_device, target.image, &memory_requirements);
+
+    uint32_t memory_type = select_memory_type(physical_device, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+    if(memory_type == ~0) {
+        memory_type = select_memory_type(physical_device, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    if(memory_type == ~0) {
+        error(1, "Failed to find suitable memory type for depth\n");
+    }
+
+    VkMemoryAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = memory_requirements.size,
+        .memoryTypeIndex = memory_type
+    };
+
+    if(vkAllocateMemory(logical_device, &alloc_info, NULL, &target.memory) != VK_SUCCESS) {
+        error(1, "Failed to allocate depth memory\n");
+    }
+
+    vkBindImageMemory(logical_device, target.image, target.memory, 0);
+    target.view = create_image_view(target.image, logical_device, 1, depth->format, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    depth->memory_size += memory_requirements.size;
+    return target;
+}
+
+/*
+    Builds targets for extent unless the current ones already match it. Returns the targets that were
+    replaced, which frames already submitted may still be using, for the caller to destroy with
+    destroy_depth_targets once they have completed, or NULL when nothing was replaced.
+*/
+depth_target_t *resize_depth_targets(depth_manager_t *depth, VkDevice logical_device, VkPhysicalDevice physical_device, VkExtent2D extent) {
+    if(depth_targets_match(depth, extent)) {
+        return NULL;
+    }
+
+    depth_target_t *replaced = depth->targets;
+
+    depth->targets = malloc(depth->target_count*sizeof(depth_target_t));
+    if(depth->targets == NULL) {
+        error(1, "Failed to allocate depth targets\n");
+    }
+
+    depth->extent = extent;
+    depth->memory_size = 0;
+    for(uint32_t i = 0; i < depth->target_count; i++) {
+        depth->targets[i] = create_depth_target(depth, logical_device, physical_device, extent);
+    }
+
+    return replaced;
+}
+
+void destroy_depth_targets(depth_target_t *targets, uint32_t target_count, VkDevice logical_device) {
+    for(uint32_t i = 0; i < target_count && targets != NULL; i++) {
+        vkDestroyImageView(logical_device, targets[i].view, NULL);
+        vkDestroyImage(logical_device, targets[i].image, NULL);
+        vkFreeMemory(logical_device, targets[i].memory, NULL);
+    }
+
+    free(targets);
+}
@@ -0,0 +1,210 @@
+#include "draw_list.h"
+
+static void grow_draw_list(draw_list_t *list, uint32_t capacity) {
+    list->objects = realloc(list->objects, capacity*sizeof(render_object_t));
+    list->sorted = realloc(list->sorted, capacity*sizeof(render_object_t));
+    list->keys = realloc(list->keys, capacity*sizeof(uint64_t));
+    list->key_scratch = realloc(list->key_scratch, capacity*sizeof(uint64_t));
+    list->order = realloc(list->order, capacity*sizeof(uint32_t));
+    list->order_scratch = realloc(list->order_scratch, capacity*sizeof(uint32_t));
+
+    if(list->objects == NULL || list->sorted == NULL || list->keys == NULL || list->key_scratch == NULL || list->order == NULL || list->order_scratch == NULL) {
+        error(1, "Failed to allocate draw list\n");
+    }
+    list->capacity = capacity;
+}
+
+void initialise_draw_list(draw_list_t *list, uint32_t capacity) {
+    *list = (draw_list_t){0};
+    grow_draw_list(list, capacity > 0 ? capacity : 1);
+}
+
+void reset_draw_list(draw_list_t *list) {
+    list->count = 0;
+}
+
+//The id of handle within bits, handing out the next one for a handle not seen before
+static uint64_t key_id(draw_key_ids_t *ids, uint64_t handle, uint32_t bits) {
+    for(uint32_t i = 0; i < ids->count; i++) {
+        if(ids->handles[i] == handle) {
+            return i & ((1ull << bits) - 1);
+        }
+    }
+
+    if(ids->count == ids->capacity) {
+        ids->capacity = ids->capacity > 0 ? 2*ids->capacity : 16;
+        ids->handles = realloc(ids->handles, ids->capacity*sizeof(uint64_t));
+        if(ids->handles == NULL) {
+            error(1, "Failed to allocate draw key ids\n");
+        }
+    }
+
+    ids->handles[ids->count] = handle;
+    return ids->count++ & ((1ull << bits) - 1);
+}
+
+/*
+    depth is the object's distance from the camera. A non-negative float's bits order the same way as its
+    value, so they go into the key as they are.
+*/
+void push_draw(draw_list_t *list, render_object_t *object, float depth) {
+    if(list->count == list->capacity) {
+        grow_draw_list(list, 2*list->capacity);
+    }
+
+    material_t *material = object->material_instance;
+    uint64_t pipeline = key_id(&list->pipeline_ids, (uint64_t)material->material_pipeline->pipeline, DRAW_KEY_PIPELINE_BITS);
+    uint64_t descriptor = key_id(&list->material_ids, (uint64_t)material->descriptor, DRAW_KEY_MATERIAL_BITS);
+    //Both buffers of a mesh share an id, a pair that collides with another only batches worse
+    uint64_t mesh = key_id(&list->mesh_ids, (uint64_t)*object->vertex_buffer ^ ((uint64_t)object->index_buffer << 1), DRAW_KEY_MESH_BITS);
+
+    depth = depth > 0.0f ? depth : 0.0f;
+    uint32_t depth_bits;
+    memcpy(&depth_bits, &depth, sizeof(uint32_t));
+
+    list->keys[list->count] = pipeline << (DRAW_KEY_MATERIAL_BITS + DRAW_KEY_MESH_BITS + DRAW_KEY_DEPTH_BITS)
+        | descriptor << (DRAW_KEY_MESH_BITS + DRAW_KEY_DEPTH_BITS)
+        | mesh << DRAW_KEY_DEPTH_BITS
+        | (uint64_t)depth_bits;
+    list->order[list->count] = list->count;
+    list->objects[list->count] = *object;
+    list->count++;
+}
+
+/*
+    Least significant digit first radix sort of the keys, a byte per pass, carrying the objects' indices
+    along. Passes whose byte is the same in every key are skipped, which with few pipelines and materials
+    is most of the upper ones. Stable, so equal keys keep the order they were pushed in.
+*/
+void sort_draw_list(draw_list_t *list) {
+    for(uint32_t shift = 0; shift < 64; shift += 8) {
+        uint32_t offsets[256] = {0};
+        for(uint32_t i = 0; i < list->count; i++) {
+            offsets[(list->keys[i] >> shift) & 0xff]++;
+        }
+
+        if(list->count == 0 || offsets[(list->keys[0] >> shift) & 0xff] == list->count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t bucket_count = offsets[i];
+            offsets[i] = offset;
+            offset += bucket_count;
+        }
+
+        for(uint32_t i = 0; i < list->count; i++) {
+            uint32_t destination = offsets[(list->keys[i] >> shift) & 0xff]++;
+            list->key_scratch[destination] = list->keys[i];
+            list->order_scratch[destination] = list->order[i];
+        }
+
+        uint64_t *keys = list->keys;
+        list->keys = list->key_scratch;
+        list->key_scratch = keys;
+
+        uint32_t *order = list->order;
+        list->order = list->order_scratch;
+        list->order_scratch = order;
+    }
+
+    for(uint32_t i = 0; i < list->count; i++) {
+        list->sorted[i] = list->objects[list->order[i]];
+    }
+}
+
+/*
+    Records objects in order like record_draw, binding only what differs from the previous draw. A pipeline
+    layout change can disturb the sets bound so far, so both are bound again after one. Push constants are
+    per object and always recorded. Counts are added to stats.
+*/
+void record_draws(VkCommandBuffer command_buffer, render_object_t *objects, uint32_t object_count, VkDescriptorSet global_descriptor, draw_stats_t *stats) {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkDescriptorSet material_descriptor = VK_NULL_HANDLE;
+    VkBuffer vertex_buffer = VK_NULL_HANDLE, index_buffer = VK_NULL_HANDLE;
+    VkDeviceSize offsets[] = {0};
+
+    uint32_t binds = 0, unsorted_binds = 0;
+    for(uint32_t i = 0; i < object_count; i++) {
+        render_object_t *object = &objects[i];
+        material_t *material = object->material_instance;
+        material_pipeline_t *material_pipeline = material->material_pipeline;
+
+        if(material_pipeline->pipeline != pipeline) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->pipeline);
+            pipeline = material_pipeline->pipeline;
+            binds++;
+        }
+
+        if(material_pipeline->layout != layout) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->layout, 0, 1, &global_descriptor, 0, NULL);
+            layout = material_pipeline->layout;
+            material_descriptor = VK_NULL_HANDLE;
+            binds++;
+        }
+
+        if(material->descriptor != VK_NULL_HANDLE && material->descriptor != material_descriptor) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &material->descriptor, 0, NULL);
+            material_descriptor = material->descriptor;
+            binds++;
+        }
+        vkCmdPushConstants(command_buffer, layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_data_t), &object->push_constant);
+
+        if(*object->vertex_buffer != vertex_buffer) {
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, object->vertex_buffer, offsets);
+            vertex_buffer = *object->vertex_buffer;
+            binds++;
+        }
+
+        if(object->index_buffer != index_buffer) {
+            vkCmdBindIndexBuffer(command_buffer, object->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+            index_buffer = object->index_buffer;
+            binds++;
+        }
+
+        vkCmdDrawIndexed(command_buffer, object->index_count, 1, object->first_index, 0, 0);
+        unsorted_binds += material->descriptor != VK_NULL_HANDLE ? DRAW_BINDS_PER_OBJECT : DRAW_BINDS_PER_OBJECT - 1;
+    }
+
+    stats->draws += object_count;
+    stats->binds += binds;
+    stats->binds_saved += unsorted_binds - binds;
+}
+
+//Adds a frame's counts, possibly from several recording threads, to the list's
+void add_draw_stats(draw_list_t *list, draw_stats_t *stats) {
+    list->stats.draws += stats->draws;
+    list->stats.binds += stats->binds;
+    list->stats.binds_saved += stats->binds_saved;
+    list->frames++;
+}
+
+//Prints the averages since the last call and starts over
+void print_draw_list_stats(draw_list_t *list) {
+    if(list->frames == 0) {
+        return;
+    }
+
+    double frames = (double)list->frames;
+    uint32_t total_binds = list->stats.binds + list->stats.binds_saved;
+    printf("Draw list: %.0f draws/frame, %.1f binds/frame, %.1f binds saved/frame (%.0f%%)\n",
+        (double)list->stats.draws/frames, (double)list->stats.binds/frames, (double)list->stats.binds_saved/frames,
+        total_binds > 0 ? 100.0*(double)list->stats.binds_saved/(double)total_binds : 0.0);
+
+    list->stats = (draw_stats_t){0};
+    list->frames = 0;
+}
+
+void destroy_draw_list(draw_list_t *list) {
+    free(list->objects);
+    free(list->sorted);
+    free(list->keys);
+    free(list->key_scratch);
+    free(list->order);
+    free(list->order_scratch);
+    free(list->pipeline_ids.handles);
+    free(list->material_ids.handles);
+    free(list->mesh_ids.handles);
+}
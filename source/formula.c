@@ -0,0 +1,1100 @@
+#include "formula.h"
+#include "vulkan_utils.h"
+#include <ctype.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define PUSH_X_MIN 0//Members of compute_push_constants_t, all four bytes wide
+#define PUSH_X_MAX 1
+#define PUSH_Y_MIN 2
+#define PUSH_Y_MAX 3
+#define PUSH_RE 4
+#define PUSH_IM 5
+#define PUSH_T 6
+#define PUSH_MAX_ITERATIONS 12
+#define PUSH_BAILOUT 13
+#define PUSH_WIDTH 14
+#define PUSH_HEIGHT 15
+#define PUSH_ORIGIN_X 18
+#define PUSH_ORIGIN_Y 19
+#define PUSH_MEMBER_COUNT 20
+
+#define UINT_CONSTANT_CAPACITY 32
+
+typedef enum spirv_op_t {
+    OP_EXT_INST_IMPORT = 11,
+    OP_EXT_INST = 12,
+    OP_MEMORY_MODEL = 14,
+    OP_ENTRY_POINT = 15,
+    OP_EXECUTION_MODE = 16,
+    OP_CAPABILITY = 17,
+    OP_TYPE_VOID = 19,
+    OP_TYPE_BOOL = 20,
+    OP_TYPE_INT = 21,
+    OP_TYPE_FLOAT = 22,
+    OP_TYPE_VECTOR = 23,
+    OP_TYPE_IMAGE = 25,
+    OP_TYPE_STRUCT = 30,
+    OP_TYPE_POINTER = 32,
+    OP_TYPE_FUNCTION = 33,
+    OP_CONSTANT = 43,
+    OP_FUNCTION = 54,
+    OP_FUNCTION_END = 56,
+    OP_VARIABLE = 59,
+    OP_LOAD = 61,
+    OP_ACCESS_CHAIN = 65,
+    OP_DECORATE = 71,
+    OP_MEMBER_DECORATE = 72,
+    OP_COMPOSITE_CONSTRUCT = 80,
+    OP_COMPOSITE_EXTRACT = 81,
+    OP_IMAGE_WRITE = 99,
+    OP_CONVERT_U_TO_F = 112,
+    OP_BITCAST = 124,
+    OP_F_NEGATE = 127,
+    OP_I_ADD = 128,
+    OP_F_ADD = 129,
+    OP_F_SUB = 131,
+    OP_F_MUL = 133,
+    OP_F_DIV = 136,
+    OP_LOGICAL_AND = 167,
+    OP_SELECT = 169,
+    OP_U_LESS_THAN = 176,
+    OP_F_ORD_LESS_THAN = 184,
+    OP_PHI = 245,
+    OP_LOOP_MERGE = 246,
+    OP_SELECTION_MERGE = 247,
+    OP_LABEL = 248,
+    OP_BRANCH = 249,
+    OP_BRANCH_CONDITIONAL = 250,
+    OP_RETURN = 253
+} spirv_op_t;
+
+//GLSL.std.450 extended instructions
+typedef enum glsl_inst_t {
+    GLSL_SIN = 13,
+    GLSL_COS = 14,
+    GLSL_SINH = 19,
+    GLSL_COSH = 20,
+    GLSL_ATAN2 = 25,
+    GLSL_POW = 26,
+    GLSL_EXP = 27,
+    GLSL_LOG = 28,
+    GLSL_LOG2 = 30,
+    GLSL_SQRT = 31,
+    GLSL_F_MAX = 40
+} glsl_inst_t;
+
+typedef enum real_op_t {
+    REAL_CONSTANT,
+    REAL_Z_RE,
+    REAL_Z_IM,
+    REAL_C_RE,
+    REAL_C_IM,
+    REAL_N,
+    REAL_T,
+    REAL_NEGATE,
+    REAL_SIN,
+    REAL_COS,
+    REAL_SINH,
+    REAL_COSH,
+    REAL_EXP,
+    REAL_LOG,
+    REAL_SQRT,
+    REAL_ADD,
+    REAL_SUB,
+    REAL_MUL,
+    REAL_DIV,
+    REAL_ATAN2,
+    REAL_POW
+} real_op_t;
+
+#define REAL_FIRST_UNARY REAL_NEGATE
+#define REAL_FIRST_BINARY REAL_ADD
+
+typedef struct real_node_t {
+    real_op_t op;
+    uint32_t a, b;
+    float value;
+    uint32_t variant;//Depends on z or n, so it is computed inside the loop
+    uint32_t id;//SPIR-V result, 0 until emitted
+} real_node_t;
+
+typedef struct complex_node_t {
+    uint32_t re, im;
+} complex_node_t;
+
+typedef struct word_buffer_t {
+    uint32_t *words;
+    size_t count, capacity;
+} word_buffer_t;
+
+typedef struct formula_compiler_t {
+    const char *source;
+    const char *cursor;
+    const char *error;
+    size_t error_offset;
+
+    real_node_t nodes[FORMULA_MAX_NODES];
+    uint32_t node_count;
+    uint32_t table[FORMULA_TABLE_SIZE];//Node index + 1, 0 marks an empty entry
+
+    word_buffer_t annotations, globals, entry, preheader, condition, body, merge;
+    word_buffer_t *current;//Block variant nodes are emitted into, invariant ones always go to the preheader
+    uint32_t next_id;
+
+    uint32_t glsl;
+    uint32_t type_void, type_function, type_bool, type_float, type_uint, type_int;
+    uint32_t type_v2int, type_v3uint, type_v4float, type_image;
+    uint32_t pointer_image, pointer_input, pointer_push_block, pointer_push_float, pointer_push_uint;
+    uint32_t push_block, image_variable, invocation_variable, push_variable;
+    uint32_t iteration;
+
+    uint32_t uint_values[UINT_CONSTANT_CAPACITY];
+    uint32_t uint_ids[UINT_CONSTANT_CAPACITY];
+    uint32_t uint_count;
+} formula_compiler_t;
+
+void formula_error(formula_compiler_t *compiler, const char *message) {
+    if(compiler->error == NULL) {
+        compiler->error = message;
+        compiler->error_offset = (size_t)(compiler->cursor - compiler->source);
+    }
+}
+
+float fold_real(real_op_t op, float x, float y) {
+    switch(op) {
+        case REAL_NEGATE: return -x;
+        case REAL_SIN: return sinf(x);
+        case REAL_COS: return cosf(x);
+        case REAL_SINH: return sinhf(x);
+        case REAL_COSH: return coshf(x);
+        case REAL_EXP: return expf(x);
+        case REAL_LOG: return logf(x);
+        case REAL_SQRT: return sqrtf(x);
+        case REAL_ADD: return x + y;
+        case REAL_SUB: return x - y;
+        case REAL_MUL: return x*y;
+        case REAL_DIV: return x/y;
+        case REAL_ATAN2: return atan2f(x, y);
+        case REAL_POW: return powf(x, y);
+        default: return 0.0f;
+    }
+}
+
+uint32_t hash_node(real_op_t op, uint32_t a, uint32_t b, uint32_t bits) {
+    uint32_t hash = (uint32_t)op*0x9E3779B1u ^ a*0x85EBCA77u ^ b*0xC2B2AE3Du ^ bits*0x27D4EB2Fu;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    return hash ^ (hash >> 13);
+}
+
+/*
+    Returns the existing node with these operands if there is one, this is where common subexpressions merge
+*/
+uint32_t find_node(formula_compiler_t *compiler, real_op_t op, uint32_t a, uint32_t b, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    uint32_t mask = FORMULA_TABLE_SIZE - 1;
+    for(uint32_t i = hash_node(op, a, b, bits) & mask;; i = (i + 1) & mask) {
+        uint32_t entry = compiler->table[i];
+
+        if(entry == 0) {
+            if(compiler->node_count == FORMULA_MAX_NODES) {
+                formula_error(compiler, "Formula too large");
+                return 0;
+            }
+
+            uint32_t index = compiler->node_count++;
+            uint32_t variant = op == REAL_Z_RE || op == REAL_Z_IM || op == REAL_N;
+            if(op >= REAL_FIRST_UNARY) {
+                variant |= compiler->nodes[a].variant;
+            }
+            if(op >= REAL_FIRST_BINARY) {
+                variant |= compiler->nodes[b].variant;
+            }
+
+            compiler->nodes[index] = (real_node_t){
+                .op = op,
+                .a = a,
+                .b = b,
+                .value = value,
+                .variant = variant,
+                .id = 0
+            };
+            compiler->table[i] = index + 1;
+            return index;
+        }
+
+        real_node_t *node = &compiler->nodes[entry - 1];
+        if(node->op == op && node->a == a && node->b == b && memcmp(&node->value, &value, sizeof(float)) == 0) {
+            return entry - 1;
+        }
+    }
+}
+
+uint32_t real_constant(formula_compiler_t *compiler, float value) {
+    return find_node(compiler, REAL_CONSTANT, 0, 0, value);
+}
+
+uint32_t real_leaf(formula_compiler_t *compiler, real_op_t op) {
+    return find_node(compiler, op, 0, 0, 0.0f);
+}
+
+uint32_t is_constant(formula_compiler_t *compiler, uint32_t a, float value) {
+    return compiler->nodes[a].op == REAL_CONSTANT && compiler->nodes[a].value == value;
+}
+
+uint32_t real_unary(formula_compiler_t *compiler, real_op_t op, uint32_t a) {
+    real_node_t x = compiler->nodes[a];
+
+    if(x.op == REAL_CONSTANT) {
+        return real_constant(compiler, fold_real(op, x.value, 0.0f));
+    }
+
+    if(op == REAL_NEGATE && x.op == REAL_NEGATE) {
+        return x.a;
+    }
+
+    if(op == REAL_NEGATE && x.op == REAL_SUB) {
+        return find_node(compiler, REAL_SUB, x.b, x.a, 0.0f);
+    }
+
+    return find_node(compiler, op, a, 0, 0.0f);
+}
+
+/*
+    Algebraic simplification and strength reduction happen here, before a node is looked up
+*/
+uint32_t real_binary(formula_compiler_t *compiler, real_op_t op, uint32_t a, uint32_t b) {
+    real_node_t x = compiler->nodes[a];
+    real_node_t y = compiler->nodes[b];
+
+    if(x.op == REAL_CONSTANT && y.op == REAL_CONSTANT) {
+        return real_constant(compiler, fold_real(op, x.value, y.value));
+    }
+
+    switch(op) {
+        case REAL_ADD:
+            if(is_constant(compiler, a, 0.0f)) {
+                return b;
+            }
+            if(is_constant(compiler, b, 0.0f)) {
+                return a;
+            }
+            if(y.op == REAL_NEGATE) {
+                return real_binary(compiler, REAL_SUB, a, y.a);
+            }
+            if(x.op == REAL_NEGATE) {
+                return real_binary(compiler, REAL_SUB, b, x.a);
+            }
+            break;
+        case REAL_SUB:
+            if(is_constant(compiler, b, 0.0f)) {
+                return a;
+            }
+            if(is_constant(compiler, a, 0.0f)) {
+                return real_unary(compiler, REAL_NEGATE, b);
+            }
+            if(a == b) {
+                return real_constant(compiler, 0.0f);
+            }
+            if(y.op == REAL_NEGATE) {
+                return real_binary(compiler, REAL_ADD, a, y.a);
+            }
+            break;
+        case REAL_MUL:
+            if(x.op == REAL_CONSTANT) {
+                uint32_t swap = a;
+                a = b;
+                b = swap;
+                x = compiler->nodes[a];
+                y = compiler->nodes[b];
+            }
+            if(is_constant(compiler, b, 0.0f)) {
+                return b;
+            }
+            if(is_constant(compiler, b, 1.0f)) {
+                return a;
+            }
+            if(is_constant(compiler, b, -1.0f)) {
+                return real_unary(compiler, REAL_NEGATE, a);
+            }
+            if(is_constant(compiler, b, 2.0f)) {
+                return real_binary(compiler, REAL_ADD, a, a);
+            }
+            if(x.op == REAL_NEGATE && y.op == REAL_NEGATE) {
+                return real_binary(compiler, REAL_MUL, x.a, y.a);
+            }
+            break;
+        case REAL_DIV:
+            if(y.op == REAL_CONSTANT) {
+                return real_binary(compiler, REAL_MUL, a, real_constant(compiler, 1.0f/y.value));
+            }
+            break;
+        case REAL_POW:
+            if(is_constant(compiler, b, 1.0f)) {
+                return a;
+            }
+            if(is_constant(compiler, b, 2.0f)) {
+                return real_binary(compiler, REAL_MUL, a, a);
+            }
+            if(is_constant(compiler, b, 0.5f)) {
+                return real_unary(compiler, REAL_SQRT, a);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if((op == REAL_ADD || op == REAL_MUL) && a > b) {
+        uint32_t swap = a;
+        a = b;
+        b = swap;
+    }
+
+    return find_node(compiler, op, a, b, 0.0f);
+}
+
+uint32_t real_add(formula_compiler_t *compiler, uint32_t a, uint32_t b) {
+    return real_binary(compiler, REAL_ADD, a, b);
+}
+
+uint32_t real_sub(formula_compiler_t *compiler, uint32_t a, uint32_t b) {
+    return real_binary(compiler, REAL_SUB, a, b);
+}
+
+uint32_t real_mul(formula_compiler_t *compiler, uint32_t a, uint32_t b) {
+    return real_binary(compiler, REAL_MUL, a, b);
+}
+
+complex_node_t complex_constant(formula_compiler_t *compiler, float re, float im) {
+    return (complex_node_t){real_constant(compiler, re), real_constant(compiler, im)};
+}
+
+complex_node_t complex_add(formula_compiler_t *compiler, complex_node_t a, complex_node_t b) {
+    return (complex_node_t){real_add(compiler, a.re, b.re), real_add(compiler, a.im, b.im)};
+}
+
+complex_node_t complex_sub(formula_compiler_t *compiler, complex_node_t a, complex_node_t b) {
+    return (complex_node_t){real_sub(compiler, a.re, b.re), real_sub(compiler, a.im, b.im)};
+}
+
+complex_node_t complex_negate(formula_compiler_t *compiler, complex_node_t a) {
+    return (complex_node_t){real_unary(compiler, REAL_NEGATE, a.re), real_unary(compiler, REAL_NEGATE, a.im)};
+}
+
+uint32_t complex_norm(formula_compiler_t *compiler, complex_node_t a) {
+    return real_add(compiler, real_mul(compiler, a.re, a.re), real_mul(compiler, a.im, a.im));
+}
+
+complex_node_t complex_square(formula_compiler_t *compiler, complex_node_t a) {
+    uint32_t re = real_sub(compiler, real_mul(compiler, a.re, a.re), real_mul(compiler, a.im, a.im));
+    uint32_t im = real_mul(compiler, real_add(compiler, a.re, a.re), a.im);
+    return (complex_node_t){re, im};
+}
+
+complex_node_t complex_mul(formula_compiler_t *compiler, complex_node_t a, complex_node_t b) {
+    if(a.re == b.re && a.im == b.im) {
+        return complex_square(compiler, a);
+    }
+
+    uint32_t re = real_sub(compiler, real_mul(compiler, a.re, b.re), real_mul(compiler, a.im, b.im));
+    uint32_t im = real_add(compiler, real_mul(compiler, a.re, b.im), real_mul(compiler, a.im, b.re));
+    return (complex_node_t){re, im};
+}
+
+//One real division for the reciprocal of |b|^2, none at all for a real divisor
+complex_node_t complex_divide(formula_compiler_t *compiler, complex_node_t a, complex_node_t b) {
+    if(is_constant(compiler, b.im, 0.0f)) {
+        return (complex_node_t){real_binary(compiler, REAL_DIV, a.re, b.re), real_binary(compiler, REAL_DIV, a.im, b.re)};
+    }
+
+    uint32_t reciprocal = real_binary(compiler, REAL_DIV, real_constant(compiler, 1.0f), complex_norm(compiler, b));
+    uint32_t re = real_add(compiler, real_mul(compiler, a.re, b.re), real_mul(compiler, a.im, b.im));
+    uint32_t im = real_sub(compiler, real_mul(compiler, a.im, b.re), real_mul(compiler, a.re, b.im));
+    return (complex_node_t){real_mul(compiler, re, reciprocal), real_mul(compiler, im, reciprocal)};
+}
+
+complex_node_t complex_exp(formula_compiler_t *compiler, complex_node_t a) {
+    uint32_t magnitude = real_unary(compiler, REAL_EXP, a.re);
+    return (complex_node_t){real_mul(compiler, magnitude, real_unary(compiler, REAL_COS, a.im)), real_mul(compiler, magnitude, real_unary(compiler, REAL_SIN, a.im))};
+}
+
+complex_node_t complex_log(formula_compiler_t *compiler, complex_node_t a) {
+    uint32_t re = real_mul(compiler, real_constant(compiler, 0.5f), real_unary(compiler, REAL_LOG, complex_norm(compiler, a)));
+    return (complex_node_t){re, real_binary(compiler, REAL_ATAN2, a.im, a.re)};
+}
+
+complex_node_t complex_sin(formula_compiler_t *compiler, complex_node_t a) {
+    uint32_t re = real_mul(compiler, real_unary(compiler, REAL_SIN, a.re), real_unary(compiler, REAL_COSH, a.im));
+    uint32_t im = real_mul(compiler, real_unary(compiler, REAL_COS, a.re), real_unary(compiler, REAL_SINH, a.im));
+    return (complex_node_t){re, im};
+}
+
+complex_node_t complex_cos(formula_compiler_t *compiler, complex_node_t a) {
+    uint32_t re = real_mul(compiler, real_unary(compiler, REAL_COS, a.re), real_unary(compiler, REAL_COSH, a.im));
+    uint32_t im = real_mul(compiler, real_unary(compiler, REAL_SIN, a.re), real_unary(compiler, REAL_SINH, a.im));
+    return (complex_node_t){re, real_unary(compiler, REAL_NEGATE, im)};
+}
+
+complex_node_t complex_sinh(formula_compiler_t *compiler, complex_node_t a) {
+    uint32_t re = real_mul(compiler, real_unary(compiler, REAL_SINH, a.re), real_unary(compiler, REAL_COS, a.im));
+    uint32_t im = real_mul(compiler, real_unary(compiler, REAL_COSH, a.re), real_unary(compiler, REAL_SIN, a.im));
+    return (complex_node_t){re, im};
+}
+
+complex_node_t complex_cosh(formula_compiler_t *compiler, complex_node_t a) {
+    uint32_t re = real_mul(compiler, real_unary(compiler, REAL_COSH, a.re), real_unary(compiler, REAL_COS, a.im));
+    uint32_t im = real_mul(compiler, real_unary(compiler, REAL_SINH, a.re), real_unary(compiler, REAL_SIN, a.im));
+    return (complex_node_t){re, im};
+}
+
+//Squarings and one product per set bit, z^3 and z^5 in one formula share z^2
+complex_node_t complex_power_integer(formula_compiler_t *compiler, complex_node_t a, int32_t n) {
+    if(n < 0) {
+        return complex_divide(compiler, complex_constant(compiler, 1.0f, 0.0f), complex_power_integer(compiler, a, -n));
+    }
+    if(n == 0) {
+        return complex_constant(compiler, 1.0f, 0.0f);
+    }
+    if(n == 1) {
+        return a;
+    }
+    if(n % 2 == 0) {
+        return complex_square(compiler, complex_power_integer(compiler, a, n/2));
+    }
+    return complex_mul(compiler, complex_power_integer(compiler, a, n - 1), a);
+}
+
+complex_node_t complex_power_real(formula_compiler_t *compiler, complex_node_t a, float p) {
+    uint32_t magnitude = real_binary(compiler, REAL_POW, complex_norm(compiler, a), real_constant(compiler, 0.5f*p));
+    uint32_t angle = real_mul(compiler, real_binary(compiler, REAL_ATAN2, a.im, a.re), real_constant(compiler, p));
+    return (complex_node_t){real_mul(compiler, magnitude, real_unary(compiler, REAL_COS, angle)), real_mul(compiler, magnitude, real_unary(compiler, REAL_SIN, angle))};
+}
+
+complex_node_t complex_power(formula_compiler_t *compiler, complex_node_t a, complex_node_t b) {
+    if(compiler->nodes[b.re].op == REAL_CONSTANT && is_constant(compiler, b.im, 0.0f)) {
+        float p = compiler->nodes[b.re].value;
+
+        if(p == floorf(p) && fabsf(p) <= FORMULA_MAX_POWER) {
+            return complex_power_integer(compiler, a, (int32_t)p);
+        }
+        return complex_power_real(compiler, a, p);
+    }
+
+    return complex_exp(compiler, complex_mul(compiler, b, complex_log(compiler, a)));
+}
+
+complex_node_t apply_function(formula_compiler_t *compiler, const char *name, complex_node_t a) {
+    uint32_t zero = real_constant(compiler, 0.0f);
+
+    if(strcmp(name, "sin") == 0) return complex_sin(compiler, a);
+    if(strcmp(name, "cos") == 0) return complex_cos(compiler, a);
+    if(strcmp(name, "sinh") == 0) return complex_sinh(compiler, a);
+    if(strcmp(name, "cosh") == 0) return complex_cosh(compiler, a);
+    if(strcmp(name, "exp") == 0) return complex_exp(compiler, a);
+    if(strcmp(name, "log") == 0) return complex_log(compiler, a);
+    if(strcmp(name, "sqrt") == 0) return complex_power_real(compiler, a, 0.5f);
+    if(strcmp(name, "conj") == 0) return (complex_node_t){a.re, real_unary(compiler, REAL_NEGATE, a.im)};
+    if(strcmp(name, "abs") == 0) return (complex_node_t){real_unary(compiler, REAL_SQRT, complex_norm(compiler, a)), zero};
+    if(strcmp(name, "arg") == 0) return (complex_node_t){real_binary(compiler, REAL_ATAN2, a.im, a.re), zero};
+    if(strcmp(name, "re") == 0) return (complex_node_t){a.re, zero};
+    if(strcmp(name, "im") == 0) return (complex_node_t){a.im, zero};
+
+    formula_error(compiler, "Unknown function");
+    return a;
+}
+
+void skip_space(formula_compiler_t *compiler) {
+    while(isspace((unsigned char)*compiler->cursor)) {
+        compiler->cursor++;
+    }
+}
+
+uint32_t accept(formula_compiler_t *compiler, char symbol) {
+    skip_space(compiler);
+
+    if(*compiler->cursor == symbol) {
+        compiler->cursor++;
+        return 1;
+    }
+    return 0;
+}
+
+complex_node_t parse_expression(formula_compiler_t *compiler);
+complex_node_t parse_unary(formula_compiler_t *compiler);
+
+complex_node_t parse_primary(formula_compiler_t *compiler) {
+    skip_space(compiler);
+    const char *start = compiler->cursor;
+
+    if(isdigit((unsigned char)*start) || *start == '.') {
+        char *end;
+        float value = strtof(start, &end);
+
+        if(end == start) {
+            formula_error(compiler, "Malformed number");
+            return complex_constant(compiler, 0.0f, 0.0f);
+        }
+
+        compiler->cursor = end;
+        if(*end == 'i' && !isalnum((unsigned char)end[1])) {
+            compiler->cursor++;
+            return complex_constant(compiler, 0.0f, value);
+        }
+        return complex_constant(compiler, value, 0.0f);
+    }
+
+    if(accept(compiler, '(')) {
+        complex_node_t a = parse_expression(compiler);
+
+        if(!accept(compiler, ')')) {
+            formula_error(compiler, "Expected ')'");
+        }
+        return a;
+    }
+
+    if(isalpha((unsigned char)*start)) {
+        char name[16] = {0};
+        size_t length = 0;
+
+        while(isalnum((unsigned char)*compiler->cursor)) {
+            if(length < sizeof(name) - 1) {
+                name[length++] = *compiler->cursor;
+            }
+            compiler->cursor++;
+        }
+
+        if(accept(compiler, '(')) {
+            complex_node_t a = parse_expression(compiler);
+
+            if(!accept(compiler, ')')) {
+                formula_error(compiler, "Expected ')'");
+            }
+            return apply_function(compiler, name, a);
+        }
+
+        if(strcmp(name, "z") == 0) return (complex_node_t){real_leaf(compiler, REAL_Z_RE), real_leaf(compiler, REAL_Z_IM)};
+        if(strcmp(name, "c") == 0) return (complex_node_t){real_leaf(compiler, REAL_C_RE), real_leaf(compiler, REAL_C_IM)};
+        if(strcmp(name, "n") == 0) return (complex_node_t){real_leaf(compiler, REAL_N), real_constant(compiler, 0.0f)};
+        if(strcmp(name, "t") == 0) return (complex_node_t){real_leaf(compiler, REAL_T), real_constant(compiler, 0.0f)};
+        if(strcmp(name, "i") == 0) return complex_constant(compiler, 0.0f, 1.0f);
+        if(strcmp(name, "pi") == 0) return complex_constant(compiler, (float)M_PI, 0.0f);
+
+        compiler->cursor = start;
+        formula_error(compiler, "Unknown variable");
+        return complex_constant(compiler, 0.0f, 0.0f);
+    }
+
+    formula_error(compiler, "Expected a number, variable or '('");
+    return complex_constant(compiler, 0.0f, 0.0f);
+}
+
+//Binds tighter than unary minus and to the right, -z^2^3 is -(z^(2^3))
+complex_node_t parse_power(formula_compiler_t *compiler) {
+    complex_node_t base = parse_primary(compiler);
+
+    if(accept(compiler, '^')) {
+        return complex_power(compiler, base, parse_unary(compiler));
+    }
+    return base;
+}
+
+complex_node_t parse_unary(formula_compiler_t *compiler) {
+    if(accept(compiler, '-')) {
+        return complex_negate(compiler, parse_unary(compiler));
+    }
+    if(accept(compiler, '+')) {
+        return parse_unary(compiler);
+    }
+    return parse_power(compiler);
+}
+
+complex_node_t parse_term(formula_compiler_t *compiler) {
+    complex_node_t a = parse_unary(compiler);
+
+    while(compiler->error == NULL) {
+        if(accept(compiler, '*')) {
+            a = complex_mul(compiler, a, parse_unary(compiler));
+        } else if(accept(compiler, '/')) {
+            a = complex_divide(compiler, a, parse_unary(compiler));
+        } else {
+            break;
+        }
+    }
+    return a;
+}
+
+complex_node_t parse_expression(formula_compiler_t *compiler) {
+    complex_node_t a = parse_term(compiler);
+
+    while(compiler->error == NULL) {
+        if(accept(compiler, '+')) {
+            a = complex_add(compiler, a, parse_term(compiler));
+        } else if(accept(compiler, '-')) {
+            a = complex_sub(compiler, a, parse_term(compiler));
+        } else {
+            break;
+        }
+    }
+    return a;
+}
+
+void emit_words(word_buffer_t *buffer, const uint32_t *words, size_t count) {
+    if(buffer->count + count > buffer->capacity) {
+        size_t capacity = buffer->capacity == 0 ? 256 : buffer->capacity;
+        while(capacity < buffer->count + count) {
+            capacity *= 2;
+        }
+
+        uint32_t *grown = realloc(buffer->words, capacity*sizeof(uint32_t));
+        if(grown == NULL) {
+            error(1, "Failed to allocate formula code\n");
+        }
+
+        buffer->words = grown;
+        buffer->capacity = capacity;
+    }
+
+    if(count > 0) {
+        memcpy(buffer->words + buffer->count, words, count*sizeof(uint32_t));
+        buffer->count += count;
+    }
+}
+
+void emit_instruction(word_buffer_t *buffer, spirv_op_t op, uint32_t operand_count, const uint32_t *operands) {
+    uint32_t head = (operand_count + 1) << 16 | (uint32_t)op;
+
+    emit_words(buffer, &head, 1);
+    emit_words(buffer, operands, operand_count);
+}
+
+#define EMIT(buffer, op, ...) emit_instruction(buffer, op, sizeof((uint32_t[]){__VA_ARGS__})/sizeof(uint32_t), (uint32_t[]){__VA_ARGS__})
+
+//Nul-terminated and padded to whole words
+uint32_t string_words(const char *string, uint32_t words[8]) {
+    uint32_t count = (uint32_t)strlen(string)/4 + 1;
+
+    memset(words, 0, count*sizeof(uint32_t));
+    memcpy(words, string, strlen(string));
+    return count;
+}
+
+uint32_t new_id(formula_compiler_t *compiler) {
+    return compiler->next_id++;
+}
+
+uint32_t uint_constant(formula_compiler_t *compiler, uint32_t value) {
+    for(uint32_t i = 0; i < compiler->uint_count; i++) {
+        if(compiler->uint_values[i] == value) {
+            return compiler->uint_ids[i];
+        }
+    }
+
+    if(compiler->uint_count == UINT_CONSTANT_CAPACITY) {
+        error(1, "Too many formula constants\n");
+    }
+
+    uint32_t id = new_id(compiler);
+    EMIT(&compiler->globals, OP_CONSTANT, compiler->type_uint, id, value);
+
+    compiler->uint_values[compiler->uint_count] = value;
+    compiler->uint_ids[compiler->uint_count++] = id;
+    return id;
+}
+
+uint32_t load_push(formula_compiler_t *compiler, word_buffer_t *block, uint32_t member) {
+    uint32_t is_uint = member == PUSH_MAX_ITERATIONS || member == PUSH_WIDTH || member == PUSH_HEIGHT || member == PUSH_ORIGIN_X || member == PUSH_ORIGIN_Y;
+    uint32_t pointer = new_id(compiler);
+    uint32_t value = new_id(compiler);
+
+    EMIT(block, OP_ACCESS_CHAIN, is_uint ? compiler->pointer_push_uint : compiler->pointer_push_float, pointer, compiler->push_variable, uint_constant(compiler, member));
+    EMIT(block, OP_LOAD, is_uint ? compiler->type_uint : compiler->type_float, value, pointer);
+    return value;
+}
+
+/*
+    Operands are emitted first, so every node lands after its inputs. Nodes that do not depend on z or n go
+    to the preheader, which dominates the whole loop; the others go to the block being generated.
+*/
+uint32_t emit_node(formula_compiler_t *compiler, uint32_t index) {
+    real_node_t node = compiler->nodes[index];
+
+    if(node.id != 0) {
+        return node.id;
+    }
+
+    word_buffer_t *block = node.variant ? compiler->current : &compiler->preheader;
+    uint32_t a = node.op >= REAL_FIRST_UNARY ? emit_node(compiler, node.a) : 0;
+    uint32_t b = node.op >= REAL_FIRST_BINARY ? emit_node(compiler, node.b) : 0;
+    uint32_t id = 0;
+    uint32_t bits;
+
+    static const uint32_t glsl_unary[] = {
+        [REAL_SIN] = GLSL_SIN, [REAL_COS] = GLSL_COS, [REAL_SINH] = GLSL_SINH, [REAL_COSH] = GLSL_COSH,
+        [REAL_EXP] = GLSL_EXP, [REAL_LOG] = GLSL_LOG, [REAL_SQRT] = GLSL_SQRT
+    };
+    static const uint32_t arithmetic[] = {
+        [REAL_ADD] = OP_F_ADD, [REAL_SUB] = OP_F_SUB, [REAL_MUL] = OP_F_MUL, [REAL_DIV] = OP_F_DIV
+    };
+
+    switch(node.op) {
+        case REAL_CONSTANT:
+            id = new_id(compiler);
+            memcpy(&bits, &node.value, sizeof(float));
+            EMIT(&compiler->globals, OP_CONSTANT, compiler->type_float, id, bits);
+            break;
+        case REAL_Z_RE:
+        case REAL_Z_IM:
+            error(1, "Formula loop variables emitted before the loop\n");
+            break;
+        case REAL_C_RE:
+            id = load_push(compiler, block, PUSH_RE);
+            break;
+        case REAL_C_IM:
+            id = load_push(compiler, block, PUSH_IM);
+            break;
+        case REAL_T:
+            id = load_push(compiler, block, PUSH_T);
+            break;
+        case REAL_N:
+            id = new_id(compiler);
+            EMIT(block, OP_CONVERT_U_TO_F, compiler->type_float, id, compiler->iteration);
+            break;
+        case REAL_NEGATE:
+            id = new_id(compiler);
+            EMIT(block, OP_F_NEGATE, compiler->type_float, id, a);
+            break;
+        case REAL_SIN:
+        case REAL_COS:
+        case REAL_SINH:
+        case REAL_COSH:
+        case REAL_EXP:
+        case REAL_LOG:
+        case REAL_SQRT:
+            id = new_id(compiler);
+            EMIT(block, OP_EXT_INST, compiler->type_float, id, compiler->glsl, glsl_unary[node.op], a);
+            break;
+        case REAL_ADD:
+        case REAL_SUB:
+        case REAL_MUL:
+        case REAL_DIV:
+            id = new_id(compiler);
+            EMIT(block, arithmetic[node.op], compiler->type_float, id, a, b);
+            break;
+        case REAL_ATAN2:
+            id = new_id(compiler);
+            EMIT(block, OP_EXT_INST, compiler->type_float, id, compiler->glsl, GLSL_ATAN2, a, b);
+            break;
+        case REAL_POW:
+            id = new_id(compiler);
+            EMIT(block, OP_EXT_INST, compiler->type_float, id, compiler->glsl, GLSL_POW, a, b);
+            break;
+    }
+
+    compiler->nodes[index].id = id;
+    return id;
+}
+
+uint32_t emit_constant(formula_compiler_t *compiler, float value) {
+    return emit_node(compiler, real_constant(compiler, value));
+}
+
+void emit_types(formula_compiler_t *compiler) {
+    word_buffer_t *globals = &compiler->globals;
+    uint32_t words[8];
+    uint32_t count = string_words("GLSL.std.450", words);
+
+    compiler->glsl = new_id(compiler);
+    uint32_t import[9] = {compiler->glsl};
+    memcpy(import + 1, words, count*sizeof(uint32_t));
+    emit_instruction(globals, OP_EXT_INST_IMPORT, count + 1, import);
+
+    compiler->type_void = new_id(compiler);
+    compiler->type_function = new_id(compiler);
+    compiler->type_bool = new_id(compiler);
+    compiler->type_float = new_id(compiler);
+    compiler->type_uint = new_id(compiler);
+    compiler->type_int = new_id(compiler);
+    compiler->type_v2int = new_id(compiler);
+    compiler->type_v3uint = new_id(compiler);
+    compiler->type_v4float = new_id(compiler);
+    compiler->type_image = new_id(compiler);
+    compiler->push_block = new_id(compiler);
+    compiler->pointer_image = new_id(compiler);
+    compiler->pointer_input = new_id(compiler);
+    compiler->pointer_push_block = new_id(compiler);
+    compiler->pointer_push_float = new_id(compiler);
+    compiler->pointer_push_uint = new_id(compiler);
+    compiler->image_variable = new_id(compiler);
+    compiler->invocation_variable = new_id(compiler);
+    compiler->push_variable = new_id(compiler);
+
+    EMIT(globals, OP_TYPE_VOID, compiler->type_void);
+    EMIT(globals, OP_TYPE_FUNCTION, compiler->type_function, compiler->type_void);
+    EMIT(globals, OP_TYPE_BOOL, compiler->type_bool);
+    EMIT(globals, OP_TYPE_FLOAT, compiler->type_float, 32);
+    EMIT(globals, OP_TYPE_INT, compiler->type_uint, 32, 0);
+    EMIT(globals, OP_TYPE_INT, compiler->type_int, 32, 1);
+    EMIT(globals, OP_TYPE_VECTOR, compiler->type_v2int, compiler->type_int, 2);
+    EMIT(globals, OP_TYPE_VECTOR, compiler->type_v3uint, compiler->type_uint, 3);
+    EMIT(globals, OP_TYPE_VECTOR, compiler->type_v4float, compiler->type_float, 4);
+    EMIT(globals, OP_TYPE_IMAGE, compiler->type_image, compiler->type_float, 1, 0, 0, 0, 2, 1);//2D, storage, rgba32f
+
+    uint32_t members[PUSH_MEMBER_COUNT + 1] = {compiler->push_block};
+    for(uint32_t i = 0; i < PUSH_MEMBER_COUNT; i++) {
+        uint32_t is_uint = i == 7 || i == PUSH_MAX_ITERATIONS || (i >= PUSH_WIDTH && i <= PUSH_ORIGIN_Y);
+        members[i + 1] = is_uint ? compiler->type_uint : compiler->type_float;
+
+        EMIT(&compiler->annotations, OP_MEMBER_DECORATE, compiler->push_block, i, 35, 4*i);//Offset
+    }
+    emit_instruction(globals, OP_TYPE_STRUCT, PUSH_MEMBER_COUNT + 1, members);
+
+    EMIT(globals, OP_TYPE_POINTER, compiler->pointer_image, 0, compiler->type_image);//UniformConstant
+    EMIT(globals, OP_TYPE_POINTER, compiler->pointer_input, 1, compiler->type_v3uint);//Input
+    EMIT(globals, OP_TYPE_POINTER, compiler->pointer_push_block, 9, compiler->push_block);//PushConstant
+    EMIT(globals, OP_TYPE_POINTER, compiler->pointer_push_float, 9, compiler->type_float);
+    EMIT(globals, OP_TYPE_POINTER, compiler->pointer_push_uint, 9, compiler->type_uint);
+    EMIT(globals, OP_VARIABLE, compiler->pointer_image, compiler->image_variable, 0);
+    EMIT(globals, OP_VARIABLE, compiler->pointer_input, compiler->invocation_variable, 1);
+    EMIT(globals, OP_VARIABLE, compiler->pointer_push_block, compiler->push_variable, 9);
+
+    EMIT(&compiler->annotations, OP_DECORATE, compiler->push_block, 2);//Block
+    EMIT(&compiler->annotations, OP_DECORATE, compiler->invocation_variable, 11, 28);//BuiltIn GlobalInvocationId
+    EMIT(&compiler->annotations, OP_DECORATE, compiler->image_variable, 34, 0);//DescriptorSet
+    EMIT(&compiler->annotations, OP_DECORATE, compiler->image_variable, 33, 0);//Binding
+}
+
+/*
+    Smoothed iteration count through a cosine palette that drifts with t, never escaping is black
+*/
+uint32_t emit_colour(formula_compiler_t *compiler, uint32_t norm, uint32_t max_iterations) {
+    word_buffer_t *block = &compiler->merge;
+    uint32_t type_float = compiler->type_float;
+    uint32_t escaped = new_id(compiler), count = new_id(compiler), log_norm = new_id(compiler), half = new_id(compiler);
+    uint32_t clamped = new_id(compiler), correction = new_id(compiler), next = new_id(compiler), smooth = new_id(compiler);
+    uint32_t scaled = new_id(compiler), drift = new_id(compiler), phase = new_id(compiler), weight = new_id(compiler);
+    uint32_t t = emit_node(compiler, real_leaf(compiler, REAL_T));
+    uint32_t channels[3];
+
+    EMIT(block, OP_U_LESS_THAN, compiler->type_bool, escaped, compiler->iteration, max_iterations);
+    EMIT(block, OP_CONVERT_U_TO_F, type_float, count, compiler->iteration);
+    EMIT(block, OP_EXT_INST, type_float, log_norm, compiler->glsl, GLSL_LOG2, norm);
+    EMIT(block, OP_F_MUL, type_float, half, log_norm, emit_constant(compiler, 0.5f));
+    EMIT(block, OP_EXT_INST, type_float, clamped, compiler->glsl, GLSL_F_MAX, half, emit_constant(compiler, 1.0f));
+    EMIT(block, OP_EXT_INST, type_float, correction, compiler->glsl, GLSL_LOG2, clamped);
+    EMIT(block, OP_F_ADD, type_float, next, count, emit_constant(compiler, 1.0f));
+    EMIT(block, OP_F_SUB, type_float, smooth, next, correction);
+    EMIT(block, OP_F_MUL, type_float, scaled, smooth, emit_constant(compiler, 0.02f));
+    EMIT(block, OP_F_MUL, type_float, drift, t, emit_constant(compiler, 0.125f));
+    EMIT(block, OP_F_ADD, type_float, phase, scaled, drift);
+    EMIT(block, OP_SELECT, type_float, weight, escaped, emit_constant(compiler, 1.0f), emit_constant(compiler, 0.0f));
+
+    for(uint32_t i = 0; i < 3; i++) {
+        uint32_t offset = new_id(compiler), angle = new_id(compiler), wave = new_id(compiler), half_wave = new_id(compiler);
+        uint32_t raised = new_id(compiler);
+        channels[i] = new_id(compiler);
+
+        EMIT(block, OP_F_ADD, type_float, offset, phase, emit_constant(compiler, (float)i/3.0f));
+        EMIT(block, OP_F_MUL, type_float, angle, offset, emit_constant(compiler, 2.0f*(float)M_PI));
+        EMIT(block, OP_EXT_INST, type_float, wave, compiler->glsl, GLSL_COS, angle);
+        EMIT(block, OP_F_MUL, type_float, half_wave, wave, emit_constant(compiler, 0.5f));
+        EMIT(block, OP_F_ADD, type_float, raised, half_wave, emit_constant(compiler, 0.5f));
+        EMIT(block, OP_F_MUL, type_float, channels[i], raised, weight);
+    }
+
+    uint32_t colour = new_id(compiler);
+    EMIT(block, OP_COMPOSITE_CONSTRUCT, compiler->type_v4float, colour, channels[0], channels[1], channels[2], emit_constant(compiler, 1.0f));
+    return colour;
+}
+
+/*
+    if(inside) { z = pixel; for(n = 0; |z|^2 < bailout && n < max_iterations; n++) z = f(z, c); store colour; }
+    as entry, preheader, loop header, condition, body, continue, merge and end blocks
+*/
+void emit_module(formula_compiler_t *compiler, complex_node_t formula, uint32_t **code, size_t *code_size) {
+    compiler->next_id = 1;
+    emit_types(compiler);
+
+    uint32_t label_entry = new_id(compiler), label_preheader = new_id(compiler), label_header = new_id(compiler);
+    uint32_t label_condition = new_id(compiler), label_body = new_id(compiler), label_continue = new_id(compiler);
+    uint32_t label_merge = new_id(compiler), label_end = new_id(compiler);
+    uint32_t main_function = new_id(compiler);
+
+    word_buffer_t *entry = &compiler->entry;
+    uint32_t invocation = new_id(compiler), x = new_id(compiler), y = new_id(compiler);
+    uint32_t inside_x = new_id(compiler), inside_y = new_id(compiler), inside = new_id(compiler);
+
+    EMIT(entry, OP_LOAD, compiler->type_v3uint, invocation, compiler->invocation_variable);
+    EMIT(entry, OP_COMPOSITE_EXTRACT, compiler->type_uint, x, invocation, 0);
+    EMIT(entry, OP_COMPOSITE_EXTRACT, compiler->type_uint, y, invocation, 1);
+    uint32_t width = load_push(compiler, entry, PUSH_WIDTH);
+    uint32_t height = load_push(compiler, entry, PUSH_HEIGHT);
+    EMIT(entry, OP_U_LESS_THAN, compiler->type_bool, inside_x, x, width);
+    EMIT(entry, OP_U_LESS_THAN, compiler->type_bool, inside_y, y, height);
+    EMIT(entry, OP_LOGICAL_AND, compiler->type_bool, inside, inside_x, inside_y);
+
+    //Same mapping as shader.comp, u*x_max + (1 - u)*x_min
+    word_buffer_t *preheader = &compiler->preheader;
+    uint32_t start[2];
+    uint32_t coordinates[2] = {x, y};
+    uint32_t sizes[2] = {width, height};
+    uint32_t window[2][2] = {{PUSH_X_MIN, PUSH_X_MAX}, {PUSH_Y_MIN, PUSH_Y_MAX}};
+
+    for(uint32_t i = 0; i < 2; i++) {
+        uint32_t coordinate = new_id(compiler), size = new_id(compiler), u = new_id(compiler), v = new_id(compiler);
+        uint32_t high = new_id(compiler), low = new_id(compiler);
+        uint32_t minimum = load_push(compiler, preheader, window[i][0]);
+        uint32_t maximum = load_push(compiler, preheader, window[i][1]);
+        start[i] = new_id(compiler);
+
+        EMIT(preheader, OP_CONVERT_U_TO_F, compiler->type_float, coordinate, coordinates[i]);
+        EMIT(preheader, OP_CONVERT_U_TO_F, compiler->type_float, size, sizes[i]);
+        EMIT(preheader, OP_F_DIV, compiler->type_float, u, coordinate, size);
+        EMIT(preheader, OP_F_SUB, compiler->type_float, v, emit_constant(compiler, 1.0f), u);
+        EMIT(preheader, OP_F_MUL, compiler->type_float, high, u, maximum);
+        EMIT(preheader, OP_F_MUL, compiler->type_float, low, v, minimum);
+        EMIT(preheader, OP_F_ADD, compiler->type_float, start[i], high, low);
+    }
+    uint32_t bailout = load_push(compiler, preheader, PUSH_BAILOUT);
+    uint32_t max_iterations = load_push(compiler, preheader, PUSH_MAX_ITERATIONS);
+
+    uint32_t z_re = new_id(compiler), z_im = new_id(compiler), next_iteration = new_id(compiler);
+    compiler->iteration = new_id(compiler);
+    compiler->nodes[real_leaf(compiler, REAL_Z_RE)].id = z_re;
+    compiler->nodes[real_leaf(compiler, REAL_Z_IM)].id = z_im;
+
+    complex_node_t z = {real_leaf(compiler, REAL_Z_RE), real_leaf(compiler, REAL_Z_IM)};
+    uint32_t below_bailout = new_id(compiler), below_max = new_id(compiler), running = new_id(compiler);
+
+    compiler->current = &compiler->condition;
+    uint32_t norm = emit_node(compiler, complex_norm(compiler, z));
+    EMIT(&compiler->condition, OP_F_ORD_LESS_THAN, compiler->type_bool, below_bailout, norm, bailout);
+    EMIT(&compiler->condition, OP_U_LESS_THAN, compiler->type_bool, below_max, compiler->iteration, max_iterations);
+    EMIT(&compiler->condition, OP_LOGICAL_AND, compiler->type_bool, running, below_bailout, below_max);
+
+    compiler->current = &compiler->body;
+    uint32_t next_re = emit_node(compiler, formula.re);
+    uint32_t next_im = emit_node(compiler, formula.im);
+
+    compiler->current = &compiler->merge;
+    uint32_t colour = emit_colour(compiler, norm, max_iterations);
+    uint32_t origin_x = load_push(compiler, &compiler->merge, PUSH_ORIGIN_X);
+    uint32_t origin_y = load_push(compiler, &compiler->merge, PUSH_ORIGIN_Y);
+    uint32_t texel_x = new_id(compiler), texel_y = new_id(compiler), signed_x = new_id(compiler), signed_y = new_id(compiler);
+    uint32_t texel = new_id(compiler), image = new_id(compiler);
+
+    EMIT(&compiler->merge, OP_I_ADD, compiler->type_uint, texel_x, x, origin_x);
+    EMIT(&compiler->merge, OP_I_ADD, compiler->type_uint, texel_y, y, origin_y);
+    EMIT(&compiler->merge, OP_BITCAST, compiler->type_int, signed_x, texel_x);
+    EMIT(&compiler->merge, OP_BITCAST, compiler->type_int, signed_y, texel_y);
+    EMIT(&compiler->merge, OP_COMPOSITE_CONSTRUCT, compiler->type_v2int, texel, signed_x, signed_y);
+    EMIT(&compiler->merge, OP_LOAD, compiler->type_image, image, compiler->image_variable);
+    EMIT(&compiler->merge, OP_IMAGE_WRITE, image, texel, colour);
+
+    uint32_t zero = uint_constant(compiler, 0);
+    uint32_t one = uint_constant(compiler, 1);
+
+    word_buffer_t function = {0};
+    EMIT(&function, OP_FUNCTION, compiler->type_void, main_function, 0, compiler->type_function);
+
+    EMIT(&function, OP_LABEL, label_entry);
+    emit_words(&function, entry->words, entry->count);
+    EMIT(&function, OP_SELECTION_MERGE, label_end, 0);
+    EMIT(&function, OP_BRANCH_CONDITIONAL, inside, label_preheader, label_end);
+
+    EMIT(&function, OP_LABEL, label_preheader);
+    emit_words(&function, preheader->words, preheader->count);
+    EMIT(&function, OP_BRANCH, label_header);
+
+    EMIT(&function, OP_LABEL, label_header);
+    EMIT(&function, OP_PHI, compiler->type_float, z_re, start[0], label_preheader, next_re, label_continue);
+    EMIT(&function, OP_PHI, compiler->type_float, z_im, start[1], label_preheader, next_im, label_continue);
+    EMIT(&function, OP_PHI, compiler->type_uint, compiler->iteration, zero, label_preheader, next_iteration, label_continue);
+    EMIT(&function, OP_LOOP_MERGE, label_merge, label_continue, 0);
+    EMIT(&function, OP_BRANCH, label_condition);
+
+    EMIT(&function, OP_LABEL, label_condition);
+    emit_words(&function, compiler->condition.words, compiler->condition.count);
+    EMIT(&function, OP_BRANCH_CONDITIONAL, running, label_body, label_merge);
+
+    EMIT(&function, OP_LABEL, label_body);
+    emit_words(&function, compiler->body.words, compiler->body.count);
+    EMIT(&function, OP_BRANCH, label_continue);
+
+    EMIT(&function, OP_LABEL, label_continue);
+    EMIT(&function, OP_I_ADD, compiler->type_uint, next_iteration, compiler->iteration, one);
+    EMIT(&function, OP_BRANCH, label_header);
+
+    EMIT(&function, OP_LABEL, label_merge);
+    emit_words(&function, compiler->merge.words, compiler->merge.count);
+    EMIT(&function, OP_BRANCH, label_end);
+
+    EMIT(&function, OP_LABEL, label_end);
+    emit_instruction(&function, OP_RETURN, 0, NULL);
+    emit_instruction(&function, OP_FUNCTION_END, 0, NULL);
+
+    //The import heads the globals buffer, everything else has to come after the entry point
+    uint32_t import_words = compiler->globals.words[0] >> 16;
+    uint32_t name[8];
+    uint32_t name_count = string_words("main", name);
+    uint32_t entry_point[12] = {5, main_function};//GLCompute
+    memcpy(entry_point + 2, name, name_count*sizeof(uint32_t));
+    entry_point[2 + name_count] = compiler->invocation_variable;
+
+    word_buffer_t module = {0};
+    uint32_t header[5] = {0x07230203, 0x00010000, 0, compiler->next_id, 0};
+    emit_words(&module, header, 5);
+    EMIT(&module, OP_CAPABILITY, 1);//Shader
+    emit_words(&module, compiler->globals.words, import_words);
+    EMIT(&module, OP_MEMORY_MODEL, 0, 1);//Logical GLSL450
+    emit_instruction(&module, OP_ENTRY_POINT, name_count + 3, entry_point);
+    EMIT(&module, OP_EXECUTION_MODE, main_function, 17, 8, 8, 1);//LocalSize, matching shader.comp
+    emit_words(&module, compiler->annotations.words, compiler->annotations.count);
+    emit_words(&module, compiler->globals.words + import_words, compiler->globals.count - import_words);
+    emit_words(&module, function.words, function.count);
+
+    free(function.words);
+    *code = module.words;
+    *code_size = module.count*sizeof(uint32_t);
+}
+
+/*
+    Returns 0 and prints where parsing stopped if the formula is malformed, otherwise code holds a SPIR-V
+    module of code_size bytes that the caller frees
+*/
+uint32_t compile_formula(const char *source, uint32_t **code, size_t *code_size) {
+    formula_compiler_t *compiler = calloc(1, sizeof(formula_compiler_t));
+
+    if(compiler == NULL) {
+        error(1, "Failed to allocate formula compiler\n");
+    }
+
+    compiler->source = source;
+    compiler->cursor = source;
+    real_constant(compiler, 0.0f);
+
+    complex_node_t formula = parse_expression(compiler);
+    skip_space(compiler);
+    if(*compiler->cursor != '\0') {
+        formula_error(compiler, "Unexpected character");
+    }
+
+    uint32_t compiled = compiler->error == NULL;
+    if(compiled) {
+        emit_module(compiler, formula, code, code_size);
+    } else {
+        printf("Formula error: %s\n%s\n%*s^\n", compiler->error, source, (int)compiler->error_offset, "");
+    }
+
+    word_buffer_t *buffers[] = {&compiler->annotations, &compiler->globals, &compiler->entry, &compiler->preheader, &compiler->condition, &compiler->body, &compiler->merge};
+    for(uint32_t i = 0; i < sizeof(buffers)/sizeof(buffers[0]); i++) {
+        free(buffers[i]->words);
+    }
+    free(compiler);
+
+    return compiled;
+}
@@ -0,0 +1,415 @@
+#include "fractal.h"
+
+extern uint32_t frames_in_flight;
+
+void create_compute_layout(VkPipelineLayout *pipeline_layout, VkDevice logical_device, uint32_t layout_count, VkDescriptorSetLayout *layouts, uint32_t push_constant_size) {
+    VkPushConstantRange push_constant_range = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = push_constant_size
+    };
+
+    VkPipelineLayoutCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = layout_count,
+        .pSetLayouts = layouts,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constant_range
+    };
+
+    if(vkCreatePipelineLayout(logical_device, &create_info, NULL, pipeline_layout) != VK_SUCCESS) {
+        error(1, "Failed to create compute pipeline layout");
+    }
+}
+
+void create_compute_pipeline_layout(VkPipelineLayout *pipeline_layout, VkDevice logical_device, VkDescriptorSetLayout layout) {
+    create_compute_layout(pipeline_layout, logical_device, 1, &layout, sizeof(compute_push_constants_t));
+}
+
+void create_compute_pipeline_from_module(VkPipeline *compute_pipeline, VkPipelineLayout pipeline_layout, VkDevice logical_device, VkShaderModule compute_shader) {
+    VkPipelineShaderStageCreateInfo shader_stage_create_info = create_shader_stage(compute_shader, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    VkComputePipelineCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .layout = pipeline_layout,
+        .stage = shader_stage_create_info,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+
+    if(vkCreateComputePipelines(logical_device, VK_NULL_HANDLE, 1, &create_info, NULL, compute_pipeline) != VK_SUCCESS) {
+        error(1, "Failed to create compute pipeline");
+    }
+
+    vkDestroyShaderModule(logical_device, compute_shader, NULL);
+}
+
+void create_compute_pipeline(VkPipeline *compute_pipeline, VkPipelineLayout pipeline_layout, VkDevice logical_device, const char *file_name) {
+    VkShaderModule compute_shader;
+    load_shader_module(&compute_shader, logical_device, file_name);
+    create_compute_pipeline_from_module(compute_pipeline, pipeline_layout, logical_device, compute_shader);
+}
+
+//For shaders generated at runtime, code_size is in bytes
+void create_compute_pipeline_from_code(VkPipeline *compute_pipeline, VkPipelineLayout pipeline_layout, VkDevice logical_device, const uint32_t *code, size_t code_size) {
+    VkShaderModule compute_shader;
+    create_shader_module(&compute_shader, logical_device, code, code_size);
+    create_compute_pipeline_from_module(compute_pipeline, pipeline_layout, logical_device, compute_shader);
+}
+
+
+
+void write_fractal_set(fractal_data_t *fractal_data, descriptor_writer_t *writer, VkDevice logical_device, VkDescriptorSet set, VkImageView target_view, uint32_t frame_index) {
+    write_image(writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, target_view, VK_IMAGE_LAYOUT_GENERAL);
+    write_buffer(writer, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, fractal_data->orbit_buffer.buffer, fractal_data->orbit_buffer_size, 0);
+    write_buffer(writer, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, fractal_data->bla_buffer.buffer, fractal_data->bla_buffer_size, 0);
+    write_buffer(writer, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, fractal_data->stats_buffers[frame_index].buffer, sizeof(fractal_stats_t), 0);
+    write_buffer(writer, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, fractal_data->recompute_buffer.buffer, fractal_data->recompute_buffer_size, 0);
+    update_set(writer, logical_device, set);
+    clear_writes(writer);
+}
+
+/*
+    buffers takes FRACTAL_DEEP_ORBITS and the like. The fractal set binds every buffer in every mode, so
+    those a mode does not use are still created, just big enough for their headers.
+*/
+fractal_data_t initialise_fractal_data(renderer_t *renderer, uint32_t buffers) {
+    uint32_t frames_in_flight = renderer->frame_count;
+
+    image_t *fractal_images = malloc(frames_in_flight*sizeof(image_t));
+    VkImageView *fractal_image_views = malloc(frames_in_flight*sizeof(VkImage));
+
+    VkImageMemoryBarrier2 *begin_barriers = malloc(frames_in_flight*sizeof(VkImageMemoryBarrier2));
+    VkImageMemoryBarrier2 *end_barriers = malloc(frames_in_flight*sizeof(VkImageMemoryBarrier2));
+
+    host_buffer_t *stats_buffers = malloc(frames_in_flight*sizeof(host_buffer_t));
+    uint32_t *timestamps_written = calloc(frames_in_flight, sizeof(uint32_t));
+
+    if(!(fractal_images && fractal_image_views && begin_barriers && end_barriers && stats_buffers && timestamps_written)) {
+        error(1, "Failed to allocate fractal resources\n");
+    }
+
+    uint32_t texture_width = 2048, texture_height = 2048;
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        fractal_images[i] = create_image(renderer, texture_width, texture_height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        fractal_image_views[i] = create_image_view(fractal_images[i].image, renderer->logical_device, 1, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT);
+        
+        /*
+            The slot's last frame has completed by the time it is reused, so the old contents are simply
+            discarded. Writers other than shader.comp add their own stages to copies of these.
+        */
+        begin_barriers[i] = (VkImageMemoryBarrier2){
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .image = fractal_images[i].image,
+            .subresourceRange = (VkImageSubresourceRange){
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .levelCount = 1,
+                .baseMipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+            .srcAccessMask = VK_ACCESS_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        };
+
+        end_barriers[i] = (VkImageMemoryBarrier2){
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .image = fractal_images[i].image,
+            .subresourceRange = (VkImageSubresourceRange){
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .levelCount = 1,
+                .baseMipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        };
+
+        stats_buffers[i] = create_mapped_buffer(renderer, sizeof(fractal_stats_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        memset(stats_buffers[i].mapped_memory, 0, sizeof(fractal_stats_t));
+    }
+
+    uint32_t orbit_capacity = (buffers & FRACTAL_DEEP_ORBITS) ? DEEP_ORBIT_CAPACITY : 0;
+    VkDeviceSize orbit_buffer_size = sizeof(orbit_header_t) + ORBIT_COUNT*orbit_capacity*2*sizeof(float);
+    VkDeviceSize bla_buffer_size = sizeof(bla_header_t) + 2*ORBIT_COUNT*orbit_capacity*sizeof(bla_entry_t);
+
+    buffer_t orbit_buffer = create_device_buffer(renderer, orbit_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    buffer_t bla_buffer = create_device_buffer(renderer, bla_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    VkDeviceSize recompute_capacity = (buffers & FRACTAL_RECOMPUTE_LIST) ? (VkDeviceSize)texture_width*texture_height : 0;
+    VkDeviceSize recompute_buffer_size = sizeof(recompute_header_t) + recompute_capacity*sizeof(uint32_t);
+    buffer_t recompute_buffer = create_device_buffer(renderer, recompute_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(renderer->physical_device, &device_properties);
+
+    VkQueryPool timestamp_pool = VK_NULL_HANDLE;
+    if(device_properties.limits.timestampComputeAndGraphics) {
+        VkQueryPoolCreateInfo query_info = {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2*frames_in_flight
+        };
+
+        if(vkCreateQueryPool(renderer->logical_device, &query_info, NULL, &timestamp_pool) != VK_SUCCESS) {
+            error(1, "Failed to create timestamp query pool\n");
+        }
+    }
+
+    fractal_data_t fractal_data = {
+        .begin_barriers = begin_barriers,
+        .end_barriers = end_barriers,
+        .texture_width = texture_width,
+        .texture_height = texture_height,
+        .fractal_images = fractal_images,
+        .fractal_image_views = fractal_image_views,
+        .orbit_buffer = orbit_buffer,
+        .bla_buffer = bla_buffer,
+        .orbit_buffer_size = orbit_buffer_size,
+        .bla_buffer_size = bla_buffer_size,
+        .recompute_buffer = recompute_buffer,
+        .recompute_buffer_size = recompute_buffer_size,
+        .stats_buffers = stats_buffers,
+        .timestamp_pool = timestamp_pool,
+        .timestamp_period = 1e-9*(double)device_properties.limits.timestampPeriod,
+        .timestamps_written = timestamps_written
+    };
+
+    VkDescriptorPool descriptor_pool = renderer->global_pool;
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    descriptor_writer_t writer = initialise_writer();
+
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkDescriptorSetLayout fractal_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    VkDescriptorSet *fractal_sets = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        allocate_descriptor_set(&fractal_sets[i], renderer->logical_device, descriptor_pool, &fractal_layout, 1);
+
+        write_fractal_set(&fractal_data, &writer, renderer->logical_device, fractal_sets[i], fractal_image_views[i], i);
+    }
+    free_writer(&writer);
+
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+    
+    create_compute_pipeline_layout(&pipeline_layout, renderer->logical_device, fractal_layout);
+    //The counters are reduced per subgroup where arithmetic subgroup operations are available, per workgroup in shared memory otherwise
+    uint32_t subgroup_reduction = compute_subgroup_support(renderer->physical_device, VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, subgroup_reduction ? "bin/shaders/shader_subgroup_compute.spv" : "bin/shaders/shader_compute.spv");
+
+    fractal_data.pipeline = pipeline;
+    fractal_data.layout = pipeline_layout;
+    fractal_data.descriptor_layout = fractal_layout;
+    fractal_data.descriptors = fractal_sets;
+
+    return fractal_data;
+}
+
+/*
+    Uploads both reference orbits and their BLA levels. The buffers are shared by all frames in flight,
+    so the device is drained first; this only happens when the reference changes.
+*/
+void upload_reference_orbits(fractal_data_t *fractal_data, renderer_t *renderer, reference_orbit_t orbits[ORBIT_COUNT], bla_table_t *table) {
+    orbit_header_t header = {
+        .info = {0, orbits[ORBIT_CENTRE].length, orbits[ORBIT_CENTRE].length, orbits[ORBIT_CRITICAL].length},
+        .offset = {(float)orbits[ORBIT_CENTRE].offset[0], (float)orbits[ORBIT_CENTRE].offset[1]},
+        .padding = {0, 0}
+    };
+    VkDeviceSize centre_size = header.info[1]*2*sizeof(float);
+    VkDeviceSize critical_size = header.info[3]*2*sizeof(float);
+    VkDeviceSize orbit_size = sizeof(orbit_header_t) + centre_size + critical_size;
+    VkDeviceSize bla_size = sizeof(bla_header_t) + table->entry_count*sizeof(bla_entry_t);
+
+    if(orbit_size > fractal_data->orbit_buffer_size || bla_size > fractal_data->bla_buffer_size) {
+        error(1, "Reference orbit exceeds buffer capacity\n");
+    }
+
+    char *orbit_data = malloc(orbit_size);
+    char *bla_data = malloc(bla_size);
+
+    if(orbit_data == NULL || bla_data == NULL) {
+        error(1, "Failed to allocate reference orbit staging\n");
+    }
+
+    memcpy(orbit_data, &header, sizeof(orbit_header_t));
+    memcpy(orbit_data + sizeof(orbit_header_t), orbits[ORBIT_CENTRE].points, centre_size);
+    memcpy(orbit_data + sizeof(orbit_header_t) + centre_size, orbits[ORBIT_CRITICAL].points, critical_size);
+
+    memcpy(bla_data, &table->header, sizeof(bla_header_t));
+    memcpy(bla_data + sizeof(bla_header_t), table->entries, table->entry_count*sizeof(bla_entry_t));
+
+    vkDeviceWaitIdle(renderer->logical_device);
+    upload_buffer(renderer, &fractal_data->orbit_buffer, orbit_data, orbit_size);
+    upload_buffer(renderer, &fractal_data->bla_buffer, bla_data, bla_size);
+
+    free(orbit_data);
+    free(bla_data);
+}
+
+/*
+    Must be called after the frame has been waited for, the counters then belong to the previous use of the frame
+*/
+fractal_stats_t collect_fractal_stats(fractal_data_t *fractal_data, uint32_t frame_index) {
+    fractal_stats_t stats;
+    memcpy(&stats, fractal_data->stats_buffers[frame_index].mapped_memory, sizeof(fractal_stats_t));
+    memset(fractal_data->stats_buffers[frame_index].mapped_memory, 0, sizeof(fractal_stats_t));
+
+    return stats;
+}
+
+uint64_t skipped_iterations(fractal_stats_t *stats) {
+    return (uint64_t)stats->skipped_iterations_high << 32 | stats->skipped_iterations_low;
+}
+
+void print_fractal_stats(fractal_stats_t *stats) {
+    uint64_t total = (uint64_t)stats->total_iterations_high << 32 | stats->total_iterations_low;
+    uint64_t paid = ((uint64_t)stats->workgroup_max_sum_high << 32 | stats->workgroup_max_sum_low)*64;
+    uint32_t pixels = stats->escaped_pixels + stats->interior_pixels;
+
+    printf("Iterations: %llu, escaped: %u, interior: %u (%.1f%%), max: %u, workgroups: %u, lane efficiency: %.1f%%\n",
+        (unsigned long long)total, stats->escaped_pixels, stats->interior_pixels,
+        pixels > 0 ? 100.0*stats->interior_pixels/pixels : 0.0, stats->max_iterations, stats->workgroup_count,
+        paid > 0 ? 100.0*(double)total/(double)paid : 0.0);
+}
+
+/*
+    GPU time in seconds of the last dispatch recorded for this frame slot, negative until one has completed.
+    Only valid once the slot has been waited for.
+*/
+double fractal_dispatch_time(fractal_data_t *fractal_data, VkDevice logical_device, uint32_t frame_index) {
+    if(fractal_data->timestamp_pool == VK_NULL_HANDLE || !fractal_data->timestamps_written[frame_index]) {
+        return -1.0;
+    }
+
+    uint64_t timestamps[2];
+    if(vkGetQueryPoolResults(logical_device, fractal_data->timestamp_pool, 2*frame_index, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+        return -1.0;
+    }
+
+    return (double)(timestamps[1] - timestamps[0])*fractal_data->timestamp_period;
+}
+
+/*
+    Replaces shader.comp with a shader compiled from formula, see formula.h. Returns 0 and keeps the current
+    pipeline if the formula does not parse. Must not be called while the pipeline is in use.
+*/
+uint32_t use_fractal_formula(fractal_data_t *fractal_data, VkDevice logical_device, const char *formula) {
+    uint32_t *code;
+    size_t code_size;
+
+    if(!compile_formula(formula, &code, &code_size)) {
+        return 0;
+    }
+
+    vkDestroyPipeline(logical_device, fractal_data->pipeline, NULL);
+    create_compute_pipeline_from_code(&fractal_data->pipeline, fractal_data->layout, logical_device, code, code_size);
+    free(code);
+
+    return 1;
+}
+
+/*
+    Makes a compute pass's writes to buffer, a mapped counter buffer, visible to the host. Waiting for the
+    frame only orders device accesses, the host read still needs this.
+*/
+VkBufferMemoryBarrier2 host_read_barrier(VkBuffer buffer) {
+    return (VkBufferMemoryBarrier2){
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+        .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+}
+
+/*
+    Records the dispatch alone, the image must already be in VK_IMAGE_LAYOUT_GENERAL
+*/
+void dispatch_fractal(fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index) {
+    uint32_t thread_count = 8;
+    VkQueryPool timestamp_pool = fractal_data->timestamp_pool;
+
+    if(timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, timestamp_pool, 2*frame_index, 2);
+        vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index);
+    }
+    
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->layout, 0, 1, &fractal_data->descriptors[frame_index], 0, NULL);
+    vkCmdPushConstants(command_buffer, fractal_data->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(compute_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, push.width/thread_count + (push.width % thread_count != 0), push.height/thread_count + (push.height % thread_count != 0), 1);
+
+    if(timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index + 1);
+        fractal_data->timestamps_written[frame_index] = 1;
+    }
+
+    //Recorded here rather than in update_fractal so the render graph's fractal pass gets it too
+    VkBufferMemoryBarrier2 stats_barrier = host_read_barrier(fractal_data->stats_buffers[frame_index].buffer);
+    pipeline_barrier(command_buffer, 0, NULL, 1, &stats_barrier, 0, NULL);
+}
+
+void update_fractal(fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index) {
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &fractal_data->begin_barriers[frame_index]);
+    dispatch_fractal(fractal_data, command_buffer, push, frame_index);
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &fractal_data->end_barriers[frame_index]);
+}
+
+void destroy_fractal_data(fractal_data_t *fractal_data, VkDevice logical_device) {
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        destroy_image(&fractal_data->fractal_images[i], logical_device);
+        vkDestroyImageView(logical_device, fractal_data->fractal_image_views[i], NULL);
+    }
+
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        destroy_host_buffer(&fractal_data->stats_buffers[i], logical_device);
+    }
+
+    destroy_buffer(&fractal_data->orbit_buffer, logical_device);
+    destroy_buffer(&fractal_data->bla_buffer, logical_device);
+    destroy_buffer(&fractal_data->recompute_buffer, logical_device);
+
+    if(fractal_data->timestamp_pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(logical_device, fractal_data->timestamp_pool, NULL);
+    }
+
+    vkDestroyPipelineLayout(logical_device, fractal_data->layout, NULL);
+    vkDestroyPipeline(logical_device, fractal_data->pipeline, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, fractal_data->descriptor_layout, NULL);
+
+    free(fractal_data->begin_barriers);
+    free(fractal_data->end_barriers);
+    free(fractal_data->descriptors);
+    free(fractal_data->fractal_images);
+    free(fractal_data->fractal_image_views);
+    free(fractal_data->stats_buffers);
+    free(fractal_data->timestamps_written);
+}
@@ -0,0 +1,188 @@
+#include "fractal_buddhabrot.h"
+
+extern uint32_t frames_in_flight;
+
+buddhabrot_t initialise_buddhabrot(renderer_t *renderer, density_target_t *target) {
+    uint32_t frames_in_flight = renderer->frame_count;
+    uint32_t chain_count = 1 << 14;
+
+    VkDeviceSize chain_size = chain_count*4*sizeof(float);
+    buffer_t chain_buffer = create_device_buffer(renderer, chain_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    host_buffer_t *stats_buffers = malloc(frames_in_flight*sizeof(host_buffer_t));
+    VkDescriptorSet *descriptors = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+
+    if(stats_buffers == NULL || descriptors == NULL) {
+        error(1, "Failed to allocate Buddhabrot resources\n");
+    }
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkDescriptorSetLayout buddhabrot_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    descriptor_writer_t writer = initialise_writer();
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        stats_buffers[i] = create_mapped_buffer(renderer, sizeof(buddhabrot_stats_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        memset(stats_buffers[i].mapped_memory, 0, sizeof(buddhabrot_stats_t));
+
+        allocate_descriptor_set(&descriptors[i], renderer->logical_device, renderer->global_pool, &buddhabrot_layout, 1);
+
+        write_buffer(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, target->density_buffer.buffer, target->density_size, 0);
+        write_buffer(&writer, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, chain_buffer.buffer, chain_size, 0);
+        write_buffer(&writer, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stats_buffers[i].buffer, sizeof(buddhabrot_stats_t), 0);
+        update_set(&writer, renderer->logical_device, descriptors[i]);
+        clear_writes(&writer);
+    }
+    free_writer(&writer);
+
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+
+    create_compute_layout(&pipeline_layout, renderer->logical_device, 1, &buddhabrot_layout, sizeof(buddhabrot_push_constants_t));
+    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, "bin/shaders/buddhabrot_compute.spv");
+
+    buddhabrot_t buddhabrot = {
+        .pipeline = pipeline,
+        .layout = pipeline_layout,
+        .descriptor_layout = buddhabrot_layout,
+        .descriptors = descriptors,
+        .chain_buffer = chain_buffer,
+        .chain_size = chain_size,
+        .stats_buffers = stats_buffers,
+        .window = {-2.0f, 1.0f, -1.5f, 1.5f},
+        .chain_count = chain_count,
+        .steps = 4,
+        .max_iterations = 2048,
+        .min_iterations = 16,
+        .weight = 256,
+        .mutation_radius = 0.1f,//Of the window width
+        .large_mutation = 0.2f,
+        .reset = 1,
+        .peak = 0,
+        .proposed = 0,
+        .accepted = 0,
+        .contributing = 0
+    };
+
+    return buddhabrot;
+}
+
+/*
+    Must be called after the frame has been waited for, the counters then belong to the previous use of the frame
+*/
+void collect_buddhabrot_stats(buddhabrot_t *buddhabrot, uint32_t frame_index) {
+    buddhabrot_stats_t *stats = buddhabrot->stats_buffers[frame_index].mapped_memory;
+
+    buddhabrot->peak = stats->peak > buddhabrot->peak ? stats->peak : buddhabrot->peak;
+    buddhabrot->proposed += stats->proposed;
+    buddhabrot->accepted += stats->accepted;
+    buddhabrot->contributing += stats->contributing;
+
+    memset(stats, 0, sizeof(buddhabrot_stats_t));
+}
+
+/*
+    Contributing steps per second is the rate that matters, every one of them deposits weight into the window
+*/
+void print_buddhabrot_stats(buddhabrot_t *buddhabrot, double seconds) {
+    double proposed = buddhabrot->proposed > 0 ? (double)buddhabrot->proposed : 1.0;
+
+    printf("Buddhabrot: %.3g contributing steps/s, %.1f%% accepted, %.1f%% contributing, peak %u\n",
+        (double)buddhabrot->contributing/seconds, 100.0*(double)buddhabrot->accepted/proposed, 100.0*(double)buddhabrot->contributing/proposed, buddhabrot->peak);
+
+    buddhabrot->proposed = 0;
+    buddhabrot->accepted = 0;
+    buddhabrot->contributing = 0;
+}
+
+/*
+    Adds steps Metropolis steps per chain to the density and resolves it into the fractal image for frame_index.
+    The counters keep accumulating until reset is set, which also restarts the chains.
+*/
+void render_buddhabrot(buddhabrot_t *buddhabrot, density_target_t *target, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, uint32_t frame_index) {
+    buddhabrot_push_constants_t push = {
+        .x_min = buddhabrot->window[0],
+        .x_max = buddhabrot->window[1],
+        .y_min = buddhabrot->window[2],
+        .y_max = buddhabrot->window[3],
+        .width = target->width,
+        .height = target->height,
+        .chain_count = buddhabrot->chain_count,
+        .steps = buddhabrot->steps,
+        .max_iterations = buddhabrot->max_iterations,
+        .min_iterations = buddhabrot->min_iterations,
+        .weight = buddhabrot->weight,
+        .mutation_radius = buddhabrot->mutation_radius,
+        .large_mutation = buddhabrot->large_mutation,
+        .padding = {0, 0, 0}
+    };
+
+    //The previous frame's splats and resolve have to be done with the counters before more are added
+    VkBufferMemoryBarrier2 accumulate_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = target->density_buffer.buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+
+    VkBufferMemoryBarrier2 chain_barrier = accumulate_barrier;
+    chain_barrier.buffer = buddhabrot->chain_buffer.buffer;
+
+    if(buddhabrot->reset) {
+        clear_density(target, command_buffer);
+
+        chain_barrier.srcAccessMask = VK_ACCESS_2_NONE;
+        chain_barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        chain_barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        pipeline_barrier(command_buffer, 0, NULL, 1, &chain_barrier, 0, NULL);
+        vkCmdFillBuffer(command_buffer, buddhabrot->chain_buffer.buffer, 0, buddhabrot->chain_size, 0);
+
+        chain_barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        chain_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        chain_barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        chain_barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        pipeline_barrier(command_buffer, 0, NULL, 1, &chain_barrier, 0, NULL);
+
+        buddhabrot->peak = 0;
+        buddhabrot->reset = 0;
+    } else {
+        VkBufferMemoryBarrier2 barriers[2] = {accumulate_barrier, chain_barrier};
+        pipeline_barrier(command_buffer, 0, NULL, 2, barriers, 0, NULL);
+    }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, buddhabrot->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, buddhabrot->layout, 0, 1, &buddhabrot->descriptors[frame_index], 0, NULL);
+    vkCmdPushConstants(command_buffer, buddhabrot->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(buddhabrot_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, buddhabrot->chain_count/BUDDHABROT_THREAD_COUNT + (buddhabrot->chain_count % BUDDHABROT_THREAD_COUNT != 0), 1, 1);
+
+    //The peak read back from these counters sets a later frame's tone map scale
+    VkBufferMemoryBarrier2 stats_barrier = host_read_barrier(buddhabrot->stats_buffers[frame_index].buffer);
+    pipeline_barrier(command_buffer, 0, NULL, 1, &stats_barrier, 0, NULL);
+
+    float peak = buddhabrot->peak > 0 ? (float)(2*buddhabrot->peak) : (float)buddhabrot->weight;
+    resolve_density(target, fractal_data, command_buffer, 1.0f/logf(1.0f + peak), 0.5f, frame_index);
+}
+
+void destroy_buddhabrot(buddhabrot_t *buddhabrot, VkDevice logical_device) {
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        destroy_host_buffer(&buddhabrot->stats_buffers[i], logical_device);
+    }
+    destroy_buffer(&buddhabrot->chain_buffer, logical_device);
+
+    vkDestroyPipelineLayout(logical_device, buddhabrot->layout, NULL);
+    vkDestroyPipeline(logical_device, buddhabrot->pipeline, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, buddhabrot->descriptor_layout, NULL);
+
+    free(buddhabrot->stats_buffers);
+    free(buddhabrot->descriptors);
+}
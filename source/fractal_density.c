@@ -0,0 +1,132 @@
+#include "fractal_density.h"
+
+density_target_t initialise_density_target(renderer_t *renderer, fractal_data_t *fractal_data, uint32_t width, uint32_t height) {
+    uint32_t frames_in_flight = renderer->frame_count;
+
+    width = width < fractal_data->texture_width ? width : fractal_data->texture_width;
+    height = height < fractal_data->texture_height ? height : fractal_data->texture_height;
+
+    VkDeviceSize density_size = (VkDeviceSize)width*height*sizeof(uint32_t);
+    buffer_t density_buffer = create_device_buffer(renderer, density_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkDescriptorSetLayout density_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    VkDescriptorSet *density_sets = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+    if(density_sets == NULL) {
+        error(1, "Failed to allocate density descriptor sets\n");
+    }
+
+    descriptor_writer_t writer = initialise_writer();
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        allocate_descriptor_set(&density_sets[i], renderer->logical_device, renderer->global_pool, &density_layout, 1);
+
+        write_buffer(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, density_buffer.buffer, density_size, 0);
+        write_image(&writer, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, fractal_data->fractal_image_views[i], VK_IMAGE_LAYOUT_GENERAL);
+        update_set(&writer, renderer->logical_device, density_sets[i]);
+        clear_writes(&writer);
+    }
+    free_writer(&writer);
+
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+
+    create_compute_layout(&pipeline_layout, renderer->logical_device, 1, &density_layout, sizeof(density_push_constants_t));
+    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, "bin/shaders/density_compute.spv");
+
+    density_target_t target = {
+        .resolve_pipeline = pipeline,
+        .resolve_layout = pipeline_layout,
+        .descriptor_layout = density_layout,
+        .descriptors = density_sets,
+        .width = width,
+        .height = height,
+        .density_buffer = density_buffer,
+        .density_size = density_size
+    };
+
+    return target;
+}
+
+/*
+    The counters are shared by all frames in flight, so the previous frame's resolve has to finish reading first
+*/
+void clear_density(density_target_t *target, VkCommandBuffer command_buffer) {
+    VkBufferMemoryBarrier2 clear_barriers[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer = target->density_buffer.buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer = target->density_buffer.buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        }
+    };
+
+    pipeline_barrier(command_buffer, 0, NULL, 1, &clear_barriers[0], 0, NULL);
+    vkCmdFillBuffer(command_buffer, target->density_buffer.buffer, 0, target->density_size, 0);
+    pipeline_barrier(command_buffer, 0, NULL, 1, &clear_barriers[1], 0, NULL);
+}
+
+void resolve_density(density_target_t *target, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, float scale, float gamma, uint32_t frame_index) {
+    density_push_constants_t push = {
+        .width = target->width,
+        .height = target->height,
+        .scale = scale,
+        .gamma = gamma
+    };
+
+    VkBufferMemoryBarrier2 splat_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = target->density_buffer.buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+
+    pipeline_barrier(command_buffer, 0, NULL, 1, &splat_barrier, 1, &fractal_data->begin_barriers[frame_index]);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, target->resolve_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, target->resolve_layout, 0, 1, &target->descriptors[frame_index], 0, NULL);
+    vkCmdPushConstants(command_buffer, target->resolve_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(density_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, target->width/DENSITY_THREAD_COUNT + (target->width % DENSITY_THREAD_COUNT != 0), target->height/DENSITY_THREAD_COUNT + (target->height % DENSITY_THREAD_COUNT != 0), 1);
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &fractal_data->end_barriers[frame_index]);
+}
+
+void destroy_density_target(density_target_t *target, VkDevice logical_device) {
+    destroy_buffer(&target->density_buffer, logical_device);
+
+    vkDestroyPipelineLayout(logical_device, target->resolve_layout, NULL);
+    vkDestroyPipeline(logical_device, target->resolve_pipeline, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, target->descriptor_layout, NULL);
+
+    free(target->descriptors);
+}
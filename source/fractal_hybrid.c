@@ -0,0 +1,299 @@
+#include "fractal_hybrid.h"
+#include "vulkan_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define HYBRID_TOLERANCE 1e-10f//TOL in shader.comp
+#define HYBRID_TILE_TEXELS (HYBRID_TILE_SIZE*HYBRID_TILE_SIZE)
+
+static float unit_wave(float x) {
+    return (1.0f - cosf((float)M_PI*x))*0.5f;
+}
+
+/*
+    d() of shader.comp in the same single precision, so CPU and GPU tiles meet without a seam
+*/
+static float distance_estimate(float z_re, float z_im, compute_push_constants_t *push) {
+    float c_re = push->C[0], c_im = push->C[1];
+    float d_squared = 1.0f;
+    float m_squared = z_re*z_re + z_im*z_im;
+    float saved_re = z_re, saved_im = z_im;
+    uint32_t next_save = 8;
+    uint32_t i;
+
+    for(i = 0; i < push->max_iterations && m_squared < push->bailout; i++) {
+        d_squared *= 4.0f*m_squared;
+        float a = z_re*z_re, b = z_im*z_im;
+        z_im = 2.0f*z_re*z_im + c_im;
+        z_re = (a - b) + c_re;
+        m_squared = a + b;
+
+        if(push->interior_check != 0) {
+            float difference_re = z_re - saved_re, difference_im = z_im - saved_im;
+
+            if(difference_re*difference_re + difference_im*difference_im < HYBRID_TOLERANCE) {
+                i = push->max_iterations;
+                break;
+            }
+
+            if(i == next_save) {
+                saved_re = z_re;
+                saved_im = z_im;
+                next_save *= 2;
+            }
+        }
+    }
+
+    if(i == push->max_iterations) {
+        return 0.0f;
+    }
+
+    return sqrtf(m_squared/d_squared)*0.5f*logf(m_squared);
+}
+
+//color_mag through hsv_to_rgb outside, color_gradient inside, as in shader.comp
+static void shade(float texel[4], float z_re, float z_im, float estimate, float t) {
+    if(estimate > 0.0f) {
+        float w_re = cosf(0.25f*t), w_im = sinf(0.25f*t);
+        float r_re = w_re*z_re - w_im*z_im, r_im = w_re*z_im + w_im*z_re;
+        float h = -sqrtf(r_re*r_re + r_im*r_im) + t - logf(estimate)/8.0f;
+        float f = h - floorf(h);
+        float colour[3] = {unit_wave(f), 0.75f*(1.0f - unit_wave(f + 0.5f)), unit_wave(f + 1.0f)};
+
+        for(uint32_t k = 0; k < 3; k++) {
+            texel[k] = 0.95f*(0.95f*(colour[k]*colour[k] - 1.0f) + 1.0f);
+        }
+    } else {
+        float z[3] = {z_re, z_im, z_re};
+
+        for(uint32_t k = 0; k < 3; k++) {
+            texel[k] = 0.5f + 0.5f*cosf(2.0f*(float)M_PI*(0.25f*t + 0.125f*(z[k] + (float)k)));
+        }
+    }
+    texel[3] = 1.0f;
+}
+
+void hybrid_tile_task(void *argument) {
+    hybrid_job_t *job = argument;
+    compute_push_constants_t *push = &job->push;
+    float *ring = job->hybrid->ring.mapped_memory;
+
+    for(uint32_t tile = atomic_fetch_add(&job->next_tile, 1); tile < job->tile_count; tile = atomic_fetch_add(&job->next_tile, 1)) {
+        uint32_t x_0 = (tile % job->columns)*HYBRID_TILE_SIZE;
+        uint32_t y_0 = (tile / job->columns)*HYBRID_TILE_SIZE;
+        uint32_t x_1 = x_0 + HYBRID_TILE_SIZE < push->width ? x_0 + HYBRID_TILE_SIZE : push->width;
+        uint32_t y_1 = y_0 + HYBRID_TILE_SIZE < push->height ? y_0 + HYBRID_TILE_SIZE : push->height;
+        uint32_t slot = (job->ring_base + tile - job->first_tile) % HYBRID_RING_TILES;
+        float *texels = ring + (size_t)slot*HYBRID_TILE_TEXELS*4;
+
+        for(uint32_t y = y_0; y < y_1; y++) {
+            float v = (float)y/(float)push->height;
+            float z_im = v*push->y_max + (1.0f - v)*push->y_min;
+
+            for(uint32_t x = x_0; x < x_1; x++) {
+                float u = (float)x/(float)push->width;
+                float z_re = u*push->x_max + (1.0f - u)*push->x_min;
+
+                shade(&texels[((y - y_0)*HYBRID_TILE_SIZE + (x - x_0))*4], z_re, z_im, distance_estimate(z_re, z_im, push), push->t);
+            }
+        }
+    }
+}
+
+void initialise_hybrid_renderer(hybrid_renderer_t *hybrid, renderer_t *renderer, uint32_t thread_count) {
+    uint32_t frames_in_flight = renderer->frame_count;
+
+    hybrid->thread_count = thread_count;
+    hybrid->frame_count = frames_in_flight;
+    initialise_thread_pool(&hybrid->pool, thread_count, thread_count);
+
+    hybrid->ring = create_mapped_buffer(renderer, (VkDeviceSize)HYBRID_RING_TILES*HYBRID_TILE_TEXELS*4*sizeof(float), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    hybrid->ring_head = 0;
+    hybrid->ring_free = HYBRID_RING_TILES;
+    hybrid->ring_used = calloc(frames_in_flight, sizeof(uint32_t));
+    hybrid->regions = malloc(HYBRID_RING_TILES*sizeof(VkBufferImageCopy));
+
+    hybrid->gpu_pixels = calloc(frames_in_flight, sizeof(uint32_t));
+    hybrid->gpu_rate = 0.0;
+    hybrid->cpu_rate = 0.0;
+    hybrid->gpu_share = 0.5;
+
+    hybrid->gpu_total = 0;
+    hybrid->cpu_total = 0;
+
+    if(hybrid->ring_used == NULL || hybrid->regions == NULL || hybrid->gpu_pixels == NULL) {
+        error(1, "Failed to allocate hybrid renderer\n");
+    }
+}
+
+static void update_rate(double *rate, double sample) {
+    *rate = *rate == 0.0 ? sample : *rate + HYBRID_SMOOTHING*(sample - *rate);
+}
+
+static double elapsed_since(struct timespec *start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)(now.tv_sec - start->tv_sec) + 1e-9*(double)(now.tv_nsec - start->tv_nsec);
+}
+
+/*
+    Must be called after the frame has been waited for. The workers run while the GPU half is recorded
+    and are waited for before their tiles are copied, so the command buffer is complete when this returns.
+    The CPU's share of this frame therefore overlaps only with earlier frames still running on the GPU.
+*/
+void render_hybrid_frame(hybrid_renderer_t *hybrid, fractal_data_t *fractal_data, VkDevice logical_device, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index) {
+    uint32_t thread_count = 8;
+    VkQueryPool timestamp_pool = fractal_data->timestamp_pool;
+
+    //Whatever the slot held last time round has retired
+    hybrid->ring_free += hybrid->ring_used[frame_index];
+    hybrid->ring_used[frame_index] = 0;
+
+    if(hybrid->gpu_pixels[frame_index] > 0) {
+        double gpu_time = fractal_dispatch_time(fractal_data, logical_device, frame_index);
+
+        if(gpu_time > 0.0) {
+            update_rate(&hybrid->gpu_rate, (double)hybrid->gpu_pixels[frame_index]/gpu_time);
+        }
+        hybrid->gpu_pixels[frame_index] = 0;
+    }
+
+    if(hybrid->gpu_rate > 0.0 && hybrid->cpu_rate > 0.0) {
+        if(hybrid->frame_count > 1) {
+            hybrid->gpu_share = hybrid->gpu_rate/(hybrid->gpu_rate + hybrid->cpu_rate);
+        } else {
+            hybrid->gpu_share = hybrid->gpu_rate >= hybrid->cpu_rate ? 1.0 : 0.0;
+        }
+    }
+
+    uint32_t columns = push.width/HYBRID_TILE_SIZE + (push.width % HYBRID_TILE_SIZE != 0);
+    uint32_t rows = push.height/HYBRID_TILE_SIZE + (push.height % HYBRID_TILE_SIZE != 0);
+    uint32_t gpu_rows = (uint32_t)(hybrid->gpu_share*(double)rows + 0.5);
+    gpu_rows = rows > 1 ? bound(gpu_rows, 1, rows - 1) : rows;
+
+    uint32_t cpu_rows = rows - gpu_rows;
+    if(cpu_rows*columns > hybrid->ring_free) {
+        cpu_rows = hybrid->ring_free/columns;
+        gpu_rows = rows - cpu_rows;
+    }
+    uint32_t cpu_tiles = cpu_rows*columns;
+    uint32_t gpu_height = gpu_rows*HYBRID_TILE_SIZE < push.height ? gpu_rows*HYBRID_TILE_SIZE : push.height;
+
+    hybrid_job_t *job = &hybrid->job;
+    job->hybrid = hybrid;
+    job->push = push;
+    job->columns = columns;
+    job->first_tile = gpu_rows*columns;
+    job->tile_count = rows*columns;
+    job->ring_base = hybrid->ring_head;
+    atomic_store(&job->next_tile, job->first_tile);
+
+    struct timespec cpu_start;
+    timespec_get(&cpu_start, TIME_UTC);
+
+    if(cpu_tiles > 0) {
+        for(uint32_t i = 0; i < hybrid->thread_count; i++) {
+            submit_task(&hybrid->pool, hybrid_tile_task, job);
+        }
+    }
+
+    //The image is written by the GPU band's dispatch and the copies of the CPU's tiles
+    VkImageMemoryBarrier2 begin_barrier = fractal_data->begin_barriers[frame_index];
+    begin_barrier.dstStageMask |= VK_PIPELINE_STAGE_2_COPY_BIT;
+    begin_barrier.dstAccessMask |= VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    VkImageMemoryBarrier2 end_barrier = fractal_data->end_barriers[frame_index];
+    end_barrier.srcStageMask |= VK_PIPELINE_STAGE_2_COPY_BIT;
+    end_barrier.srcAccessMask |= VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &begin_barrier);
+
+    if(gpu_rows > 0) {
+        compute_push_constants_t band = push;
+        band.height = gpu_height;
+        band.y_max = push.y_min + (push.y_max - push.y_min)*(float)gpu_height/(float)push.height;
+        band.origin[0] = 0;
+        band.origin[1] = 0;
+
+        if(timestamp_pool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(command_buffer, timestamp_pool, 2*frame_index, 2);
+            vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index);
+        }
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->layout, 0, 1, &fractal_data->descriptors[frame_index], 0, NULL);
+        vkCmdPushConstants(command_buffer, fractal_data->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(compute_push_constants_t), &band);
+        vkCmdDispatch(command_buffer, band.width/thread_count + (band.width % thread_count != 0), band.height/thread_count + (band.height % thread_count != 0), 1);
+
+        if(timestamp_pool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index + 1);
+            fractal_data->timestamps_written[frame_index] = 1;
+        }
+
+        hybrid->gpu_pixels[frame_index] = band.width*band.height;
+        hybrid->gpu_total += band.width*band.height;
+    }
+
+    if(cpu_tiles > 0) {
+        wait_for_tasks(&hybrid->pool);
+
+        uint32_t cpu_pixels = push.width*(push.height - gpu_height);
+        update_rate(&hybrid->cpu_rate, (double)cpu_pixels/elapsed_since(&cpu_start));
+        hybrid->cpu_total += cpu_pixels;
+
+        for(uint32_t i = 0; i < cpu_tiles; i++) {
+            uint32_t tile = job->first_tile + i;
+            uint32_t x_0 = (tile % columns)*HYBRID_TILE_SIZE;
+            uint32_t y_0 = (tile / columns)*HYBRID_TILE_SIZE;
+            uint32_t slot = (job->ring_base + i) % HYBRID_RING_TILES;
+
+            hybrid->regions[i] = (VkBufferImageCopy){
+                .bufferOffset = (VkDeviceSize)slot*HYBRID_TILE_TEXELS*4*sizeof(float),
+                .bufferRowLength = HYBRID_TILE_SIZE,
+                .bufferImageHeight = HYBRID_TILE_SIZE,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                },
+                .imageOffset = {(int32_t)x_0, (int32_t)y_0, 0},
+                .imageExtent = {
+                    x_0 + HYBRID_TILE_SIZE < push.width ? HYBRID_TILE_SIZE : push.width - x_0,
+                    y_0 + HYBRID_TILE_SIZE < push.height ? HYBRID_TILE_SIZE : push.height - y_0,
+                    1
+                }
+            };
+        }
+
+        vkCmdCopyBufferToImage(command_buffer, hybrid->ring.buffer, fractal_data->fractal_images[frame_index].image, VK_IMAGE_LAYOUT_GENERAL, cpu_tiles, hybrid->regions);
+
+        hybrid->ring_head = (hybrid->ring_head + cpu_tiles) % HYBRID_RING_TILES;
+        hybrid->ring_free -= cpu_tiles;
+        hybrid->ring_used[frame_index] = cpu_tiles;
+    }
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &end_barrier);
+}
+
+void print_hybrid_stats(hybrid_renderer_t *hybrid) {
+    uint64_t total = hybrid->gpu_total + hybrid->cpu_total;
+
+    printf("Hybrid: GPU %.3g px/s, CPU %.3g px/s on %u threads, GPU share %.0f%% of rows, %.0f%% of pixels since last report\n",
+        hybrid->gpu_rate, hybrid->cpu_rate, hybrid->thread_count, 100.0*hybrid->gpu_share, total > 0 ? 100.0*(double)hybrid->gpu_total/(double)total : 0.0);
+
+    hybrid->gpu_total = 0;
+    hybrid->cpu_total = 0;
+}
+
+void destroy_hybrid_renderer(hybrid_renderer_t *hybrid, VkDevice logical_device) {
+    wait_for_tasks(&hybrid->pool);
+    destroy_thread_pool(&hybrid->pool);
+
+    destroy_host_buffer(&hybrid->ring, logical_device);
+    free(hybrid->ring_used);
+    free(hybrid->regions);
+    free(hybrid->gpu_pixels);
+}
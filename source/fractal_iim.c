@@ -0,0 +1,71 @@
+#include "fractal_iim.h"
+
+iim_preview_t initialise_iim_preview(renderer_t *renderer, density_target_t *target) {
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkDescriptorSetLayout iim_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    VkDescriptorSet iim_set;
+    allocate_descriptor_set(&iim_set, renderer->logical_device, renderer->global_pool, &iim_layout, 1);
+
+    descriptor_writer_t writer = initialise_writer();
+    write_buffer(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, target->density_buffer.buffer, target->density_size, 0);
+    update_set(&writer, renderer->logical_device, iim_set);
+    free_writer(&writer);
+
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+
+    create_compute_layout(&pipeline_layout, renderer->logical_device, 1, &iim_layout, sizeof(iim_push_constants_t));
+    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, "bin/shaders/iim_compute.spv");
+
+    iim_preview_t preview = {
+        .pipeline = pipeline,
+        .layout = pipeline_layout,
+        .descriptor_layout = iim_layout,
+        .descriptor = iim_set,
+        .cell_cap = 8,
+        .seed_depth = 12,
+        .max_depth = 40,
+        .splat_budget = 512
+    };
+
+    return preview;
+}
+
+/*
+    Clears the counters, splats the preimages over the [-1, 1]^2 window of the animated mode and resolves
+    them into the fractal image for frame_index
+*/
+void render_iim_preview(iim_preview_t *preview, density_target_t *target, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, complex float c, uint32_t frame_index) {
+    iim_push_constants_t push = {
+        .c = {crealf(c), cimagf(c)},
+        .x_min = -1.0f,
+        .x_max =  1.0f,
+        .y_min = -1.0f,
+        .y_max =  1.0f,
+        .width = target->width,
+        .height = target->height,
+        .cell_cap = preview->cell_cap,
+        .seed_depth = preview->seed_depth,
+        .max_depth = preview->max_depth,
+        .splat_budget = preview->splat_budget
+    };
+    uint32_t invocation_count = 1u << preview->seed_depth;
+
+    clear_density(target, command_buffer);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, preview->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, preview->layout, 0, 1, &preview->descriptor, 0, NULL);
+    vkCmdPushConstants(command_buffer, preview->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(iim_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, invocation_count/IIM_THREAD_COUNT + (invocation_count % IIM_THREAD_COUNT != 0), 1, 1);
+
+    resolve_density(target, fractal_data, command_buffer, 1.0f/logf(1.0f + (float)preview->cell_cap), 0.5f, frame_index);
+}
+
+void destroy_iim_preview(iim_preview_t *preview, VkDevice logical_device) {
+    vkDestroyPipelineLayout(logical_device, preview->layout, NULL);
+    vkDestroyPipeline(logical_device, preview->pipeline, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, preview->descriptor_layout, NULL);
+}
@@ -0,0 +1,132 @@
+#include "fractal_orbit.h"
+#include "vulkan_utils.h"
+
+reference_orbit_t create_reference_orbit(uint32_t capacity) {
+    float *points = malloc(2*capacity*sizeof(float));
+
+    if(points == NULL) {
+        error(1, "Failed to allocate reference orbit\n");
+    }
+
+    return (reference_orbit_t){
+        .capacity = capacity,
+        .length = 0,
+        .offset = {0, 0},
+        .points = points
+    };
+}
+
+void destroy_reference_orbit(reference_orbit_t *orbit) {
+    free(orbit->points);
+    orbit->points = NULL;
+    orbit->length = 0;
+}
+
+uint32_t compute_reference_orbit(reference_orbit_t *orbit, double complex z_0, double complex c, double bailout) {
+    double complex z = z_0;
+    uint32_t i;
+
+    for(i = 0; i < orbit->capacity; i++) {
+        orbit->points[2*i] = (float)creal(z);
+        orbit->points[2*i + 1] = (float)cimag(z);
+
+        if(creal(z)*creal(z) + cimag(z)*cimag(z) > bailout) {
+            i++;
+            break;
+        }
+
+        z = z*z + c;
+    }
+
+    orbit->length = i;
+    return i;
+}
+
+bla_table_t create_bla_table(uint32_t orbit_capacity) {
+    uint32_t capacity = 2*ORBIT_COUNT*orbit_capacity;
+    bla_entry_t *entries = malloc(capacity*sizeof(bla_entry_t));
+
+    if(entries == NULL) {
+        error(1, "Failed to allocate BLA table\n");
+    }
+
+    bla_table_t table = {
+        .capacity = capacity,
+        .entry_count = 0,
+        .entries = entries
+    };
+
+    clear_bla_table(&table);
+    return table;
+}
+
+void destroy_bla_table(bla_table_t *table) {
+    free(table->entries);
+    table->entries = NULL;
+}
+
+void clear_bla_table(bla_table_t *table) {
+    memset(&table->header, 0, sizeof(bla_header_t));
+    table->entry_count = 0;
+}
+
+/*
+    For the Julia map a step is delta -> 2*Z*delta + delta^2, which is linear while |delta| < epsilon*|2*Z|.
+    Merging x followed by y gives a = a_y*a_x with radius min(r_x, r_y/|a_x|).
+*/
+void build_bla_levels(bla_table_t *table, uint32_t orbit_index, reference_orbit_t *orbit, double epsilon) {
+    if(orbit->length < 2) {
+        return;
+    }
+
+    uint32_t count = orbit->length - 1;
+    double complex *a = malloc(count*sizeof(double complex));
+    double *radius = malloc(count*sizeof(double));
+
+    if(a == NULL || radius == NULL) {
+        error(1, "Failed to allocate BLA scratch\n");
+    }
+
+    for(uint32_t m = 0; m < count; m++) {
+        double complex Z = orbit->points[2*m] + orbit->points[2*m + 1]*I;
+        a[m] = 2.0*Z;
+        radius[m] = epsilon*cabs(a[m]);
+    }
+
+    for(uint32_t level = 0; level < BLA_MAX_LEVELS && count > 0; level++) {
+        if(table->entry_count + count > table->capacity) {
+            error(1, "BLA table capacity exceeded\n");
+        }
+
+        bla_level_t *bla_level = &table->header.levels[orbit_index][level];
+        bla_level->offset = table->entry_count;
+        bla_level->count = count;
+
+        for(uint32_t j = 0; j < count; j++) {
+            double magnitude = cabs(a[j]);
+            uint32_t valid = magnitude < BLA_MAX_MULTIPLIER;
+
+            table->entries[table->entry_count++] = (bla_entry_t){
+                .a = {(float)creal(a[j]), (float)cimag(a[j])},
+                .radius_squared = valid ? (float)(radius[j]*radius[j]) : 0.0f,
+                .length = 1u << level
+            };
+        }
+
+        if(level + 1 > table->header.level_count) {
+            table->header.level_count = level + 1;
+        }
+
+        count >>= 1;
+        for(uint32_t j = 0; j < count; j++) {
+            double complex a_x = a[2*j], a_y = a[2*j + 1];
+            double r_x = radius[2*j], r_y = radius[2*j + 1]/fmax(cabs(a_x), 1e-300);
+
+            a[j] = a_y*a_x;
+            radius[j] = fmin(r_x, r_y);
+        }
+    }
+
+    free(a);
+    free(radius);
+}
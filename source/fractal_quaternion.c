@@ -0,0 +1,265 @@
+#include "fractal_quaternion.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+extern uint32_t frames_in_flight;
+
+quaternion_julia_t initialise_quaternion_julia(renderer_t *renderer, fractal_data_t *fractal_data) {
+    uint32_t frames_in_flight = renderer->frame_count;
+    uint32_t cone_width = fractal_data->texture_width/QUATERNION_CONE_FACTOR + 1;
+    uint32_t cone_height = fractal_data->texture_height/QUATERNION_CONE_FACTOR + 1;
+
+    VkDeviceSize grid_size = (VkDeviceSize)QUATERNION_GRID_SIZE*QUATERNION_GRID_SIZE*QUATERNION_GRID_SIZE*sizeof(float);
+    VkDeviceSize cone_size = (VkDeviceSize)cone_width*cone_height*sizeof(float);
+    buffer_t grid_buffer = create_device_buffer(renderer, grid_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    buffer_t cone_buffer = create_device_buffer(renderer, cone_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+    host_buffer_t *stats_buffers = malloc(frames_in_flight*sizeof(host_buffer_t));
+    VkDescriptorSet *descriptors = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+
+    if(stats_buffers == NULL || descriptors == NULL) {
+        error(1, "Failed to allocate quaternion Julia resources\n");
+    }
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkDescriptorSetLayout quaternion_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    descriptor_writer_t writer = initialise_writer();
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        stats_buffers[i] = create_mapped_buffer(renderer, sizeof(quaternion_stats_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        memset(stats_buffers[i].mapped_memory, 0, sizeof(quaternion_stats_t));
+
+        allocate_descriptor_set(&descriptors[i], renderer->logical_device, renderer->global_pool, &quaternion_layout, 1);
+
+        write_image(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, fractal_data->fractal_image_views[i], VK_IMAGE_LAYOUT_GENERAL);
+        write_buffer(&writer, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, grid_buffer.buffer, grid_size, 0);
+        write_buffer(&writer, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, cone_buffer.buffer, cone_size, 0);
+        write_buffer(&writer, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stats_buffers[i].buffer, sizeof(quaternion_stats_t), 0);
+        update_set(&writer, renderer->logical_device, descriptors[i]);
+        clear_writes(&writer);
+    }
+    free_writer(&writer);
+
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+
+    create_compute_layout(&pipeline_layout, renderer->logical_device, 1, &quaternion_layout, sizeof(quaternion_push_constants_t));
+    uint32_t subgroup_reduction = compute_subgroup_support(renderer->physical_device, VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, subgroup_reduction ? "bin/shaders/quaternion_subgroup_compute.spv" : "bin/shaders/quaternion_compute.spv");
+
+    quaternion_julia_t julia = {
+        .pipeline = pipeline,
+        .layout = pipeline_layout,
+        .descriptor_layout = quaternion_layout,
+        .descriptors = descriptors,
+        .grid_buffer = grid_buffer,
+        .cone_buffer = cone_buffer,
+        .grid_size = grid_size,
+        .cone_size = cone_size,
+        .stats_buffers = stats_buffers,
+        .max_steps = 256,
+        .max_iterations = 12,
+        .epsilon = 1.0f,//In pixel footprints
+        .bound_radius = 2.0f,
+        .march_steps = 0,
+        .grid_steps = 0,
+        .cone_steps = 0,
+        .pixels = 0,
+        .hits = 0,
+        .gpu_time = 0.0,
+        .frames = 0
+    };
+
+    return julia;
+}
+
+static uint64_t wide_counter(uint32_t low, uint32_t high) {
+    return (uint64_t)high << 32 | low;
+}
+
+/*
+    Must be called after the frame has been waited for, the counters then belong to the previous use of the frame
+*/
+void collect_quaternion_stats(quaternion_julia_t *julia, fractal_data_t *fractal_data, VkDevice logical_device, uint32_t frame_index) {
+    quaternion_stats_t *stats = julia->stats_buffers[frame_index].mapped_memory;
+    double gpu_time = fractal_dispatch_time(fractal_data, logical_device, frame_index);
+
+    if(stats->pixels == 0) {
+        return;
+    }
+
+    julia->march_steps += wide_counter(stats->march_steps_low, stats->march_steps_high);
+    julia->grid_steps += wide_counter(stats->grid_steps_low, stats->grid_steps_high);
+    julia->cone_steps += wide_counter(stats->cone_steps_low, stats->cone_steps_high);
+    julia->pixels += stats->pixels;
+    julia->hits += stats->hits;
+
+    if(gpu_time > 0.0) {
+        julia->gpu_time += gpu_time;
+        julia->frames++;
+    }
+
+    memset(stats, 0, sizeof(quaternion_stats_t));
+}
+
+/*
+    Cone steps are spread over the pixels of their square, so the two per-pixel figures add up to the cost of a pixel
+*/
+void print_quaternion_stats(quaternion_julia_t *julia) {
+    double pixels = julia->pixels > 0 ? (double)julia->pixels : 1.0;
+    double frames = julia->frames > 0 ? (double)julia->frames : 1.0;
+
+    printf("Quaternion Julia: %.2f march + %.2f cone steps/pixel, %.1f%% of march steps from the grid, %.1f%% hits, %.3f ms/frame\n",
+        (double)julia->march_steps/pixels, (double)julia->cone_steps/pixels, julia->march_steps > 0 ? 100.0*(double)julia->grid_steps/(double)julia->march_steps : 0.0,
+        100.0*(double)julia->hits/pixels, 1e3*julia->gpu_time/frames);
+
+    julia->march_steps = 0;
+    julia->grid_steps = 0;
+    julia->cone_steps = 0;
+    julia->pixels = 0;
+    julia->hits = 0;
+    julia->gpu_time = 0.0;
+    julia->frames = 0;
+}
+
+/*
+    The camera circles the set once every 16π of t, looking at the origin with a 60 degree field of view
+*/
+static void quaternion_camera(quaternion_push_constants_t *push, float t) {
+    float distance = 3.0f;
+    float pixel = 2.0f*tanf((float)M_PI/6.0f)/(float)push->height;
+    float eye[3] = {distance*cosf(0.125f*t), 0.75f*sinf(0.0625f*t), distance*sinf(0.125f*t)};
+    float length = sqrtf(eye[0]*eye[0] + eye[1]*eye[1] + eye[2]*eye[2]);
+    float forward[3] = {-eye[0]/length, -eye[1]/length, -eye[2]/length};
+
+    //right = forward x (0, 1, 0), up = right x forward
+    float right_length = sqrtf(forward[0]*forward[0] + forward[2]*forward[2]);
+    float right[3] = {-forward[2]/right_length, 0.0f, forward[0]/right_length};
+    float up[3] = {
+        right[1]*forward[2] - right[2]*forward[1],
+        right[2]*forward[0] - right[0]*forward[2],
+        right[0]*forward[1] - right[1]*forward[0]
+    };
+
+    for(uint32_t i = 0; i < 3; i++) {
+        push->eye[i] = eye[i];
+        push->forward[i] = forward[i];
+        push->right[i] = pixel*right[i];
+        push->up[i] = pixel*up[i];
+    }
+}
+
+/*
+    The grid and the cone distances are shared by all frames in flight, so the previous frame's march has to
+    finish reading them before they are rewritten
+*/
+void render_quaternion_julia(quaternion_julia_t *julia, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, float c[4], float t, uint32_t width, uint32_t height, uint32_t frame_index) {
+    VkQueryPool timestamp_pool = fractal_data->timestamp_pool;
+    uint32_t grid_size = QUATERNION_GRID_SIZE;
+    uint32_t cone_width = width/QUATERNION_CONE_FACTOR + (width % QUATERNION_CONE_FACTOR != 0);
+    uint32_t cone_height = height/QUATERNION_CONE_FACTOR + (height % QUATERNION_CONE_FACTOR != 0);
+
+    quaternion_push_constants_t push = {
+        .c = {c[0], c[1], c[2], c[3]},
+        .width = width,
+        .height = height,
+        .pass = QUATERNION_PASS_GRID,
+        .max_steps = julia->max_steps,
+        .max_iterations = julia->max_iterations,
+        .epsilon = julia->epsilon,
+        .bound_radius = julia->bound_radius,
+        .grid_size = grid_size,
+        .cone_factor = QUATERNION_CONE_FACTOR,
+        .t = t
+    };
+    quaternion_camera(&push, t);
+
+    VkBufferMemoryBarrier2 buffer_barriers[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer = julia->grid_buffer.buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer = julia->cone_buffer.buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        }
+    };
+
+    pipeline_barrier(command_buffer, 0, NULL, 2, buffer_barriers, 1, &fractal_data->begin_barriers[frame_index]);
+
+    if(timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, timestamp_pool, 2*frame_index, 2);
+        vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index);
+    }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, julia->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, julia->layout, 0, 1, &julia->descriptors[frame_index], 0, NULL);
+
+    //One invocation per cell, the cells of a layer side by side along y
+    vkCmdPushConstants(command_buffer, julia->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(quaternion_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, grid_size/QUATERNION_THREAD_COUNT, grid_size*grid_size/QUATERNION_THREAD_COUNT, 1);
+
+    buffer_barriers[0].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    buffer_barriers[0].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+    pipeline_barrier(command_buffer, 0, NULL, 1, &buffer_barriers[0], 0, NULL);
+
+    push.pass = QUATERNION_PASS_CONE;
+    vkCmdPushConstants(command_buffer, julia->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(quaternion_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, cone_width/QUATERNION_THREAD_COUNT + (cone_width % QUATERNION_THREAD_COUNT != 0), cone_height/QUATERNION_THREAD_COUNT + (cone_height % QUATERNION_THREAD_COUNT != 0), 1);
+
+    buffer_barriers[1].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    buffer_barriers[1].dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+    pipeline_barrier(command_buffer, 0, NULL, 1, &buffer_barriers[1], 0, NULL);
+
+    push.pass = QUATERNION_PASS_MARCH;
+    vkCmdPushConstants(command_buffer, julia->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(quaternion_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, width/QUATERNION_THREAD_COUNT + (width % QUATERNION_THREAD_COUNT != 0), height/QUATERNION_THREAD_COUNT + (height % QUATERNION_THREAD_COUNT != 0), 1);
+
+    if(timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index + 1);
+        fractal_data->timestamps_written[frame_index] = 1;
+    }
+
+    VkBufferMemoryBarrier2 stats_barrier = host_read_barrier(julia->stats_buffers[frame_index].buffer);
+    pipeline_barrier(command_buffer, 0, NULL, 1, &stats_barrier, 1, &fractal_data->end_barriers[frame_index]);
+}
+
+void destroy_quaternion_julia(quaternion_julia_t *julia, VkDevice logical_device) {
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        destroy_host_buffer(&julia->stats_buffers[i], logical_device);
+    }
+    destroy_buffer(&julia->grid_buffer, logical_device);
+    destroy_buffer(&julia->cone_buffer, logical_device);
+
+    vkDestroyPipelineLayout(logical_device, julia->layout, NULL);
+    vkDestroyPipeline(logical_device, julia->pipeline, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, julia->descriptor_layout, NULL);
+
+    free(julia->stats_buffers);
+    free(julia->descriptors);
+}
@@ -0,0 +1,250 @@
+#include "fractal_reprojection.h"
+
+extern uint32_t frames_in_flight;
+
+reprojection_t initialise_reprojection(renderer_t *renderer, fractal_data_t *fractal_data) {
+    uint32_t frames_in_flight = renderer->frame_count;
+    VkDeviceSize offset_size = (VkDeviceSize)fractal_data->texture_width*fractal_data->texture_height*2*sizeof(float);
+
+    buffer_t *offset_buffers = malloc(frames_in_flight*sizeof(buffer_t));
+    host_buffer_t *stats_buffers = malloc(frames_in_flight*sizeof(host_buffer_t));
+    VkDescriptorSet *descriptors = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+
+    if(offset_buffers == NULL || stats_buffers == NULL || descriptors == NULL) {
+        error(1, "Failed to allocate reprojection resources\n");
+    }
+
+    //The slot before a frame's own would be the one it writes
+    if(frames_in_flight < 2) {
+        error(1, "Reprojection needs at least two frames in flight, use a pacing mode other than low latency\n");
+    }
+
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        offset_buffers[i] = create_device_buffer(renderer, offset_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        stats_buffers[i] = create_mapped_buffer(renderer, sizeof(reprojection_stats_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        memset(stats_buffers[i].mapped_memory, 0, sizeof(reprojection_stats_t));
+    }
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkDescriptorSetLayout reprojection_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    //Each frame reads the image and offsets of the slot before it
+    descriptor_writer_t writer = initialise_writer();
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        uint32_t previous = (i + frames_in_flight - 1) % frames_in_flight;
+
+        allocate_descriptor_set(&descriptors[i], renderer->logical_device, renderer->global_pool, &reprojection_layout, 1);
+
+        write_image(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, fractal_data->fractal_image_views[i], VK_IMAGE_LAYOUT_GENERAL);
+        write_image(&writer, 1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, fractal_data->fractal_image_views[previous], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        write_buffer(&writer, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, offset_buffers[previous].buffer, offset_size, 0);
+        write_buffer(&writer, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, offset_buffers[i].buffer, offset_size, 0);
+        write_buffer(&writer, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, fractal_data->recompute_buffer.buffer, fractal_data->recompute_buffer_size, 0);
+        write_buffer(&writer, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stats_buffers[i].buffer, sizeof(reprojection_stats_t), 0);
+        update_set(&writer, renderer->logical_device, descriptors[i]);
+        clear_writes(&writer);
+    }
+    free_writer(&writer);
+
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+
+    create_compute_layout(&pipeline_layout, renderer->logical_device, 1, &reprojection_layout, sizeof(reprojection_push_constants_t));
+    uint32_t subgroup_reduction = compute_subgroup_support(renderer->physical_device, VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT);
+    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, subgroup_reduction ? "bin/shaders/reprojection_subgroup_compute.spv" : "bin/shaders/reprojection_compute.spv");
+
+    reprojection_t reprojection = {
+        .pipeline = pipeline,
+        .layout = pipeline_layout,
+        .descriptor_layout = reprojection_layout,
+        .descriptors = descriptors,
+        .offset_buffers = offset_buffers,
+        .offset_size = offset_size,
+        .stats_buffers = stats_buffers,
+        .previous = {0},
+        .valid = 0,
+        .reused = 0,
+        .recomputed = 0,
+        .gpu_time = 0.0,
+        .frames = 0
+    };
+
+    return reprojection;
+}
+
+/*
+    Must be called after the frame has been waited for, the counters then belong to the previous use of the frame
+*/
+void collect_reprojection_stats(reprojection_t *reprojection, fractal_data_t *fractal_data, VkDevice logical_device, uint32_t frame_index) {
+    reprojection_stats_t *stats = reprojection->stats_buffers[frame_index].mapped_memory;
+    double gpu_time = fractal_dispatch_time(fractal_data, logical_device, frame_index);
+
+    if(stats->reused + stats->recomputed == 0) {
+        return;
+    }
+
+    reprojection->reused += stats->reused;
+    reprojection->recomputed += stats->recomputed;
+
+    if(gpu_time > 0.0) {
+        reprojection->gpu_time += gpu_time;
+        reprojection->frames++;
+    }
+
+    memset(stats, 0, sizeof(reprojection_stats_t));
+}
+
+void print_reprojection_stats(reprojection_t *reprojection) {
+    uint64_t total = reprojection->reused + reprojection->recomputed;
+    double frames = reprojection->frames > 0 ? (double)reprojection->frames : 1.0;
+
+    printf("Reprojection: %.1f%% of texels reused, %.3f ms/frame\n",
+        total > 0 ? 100.0*(double)reprojection->reused/(double)total : 0.0, 1e3*reprojection->gpu_time/frames);
+
+    reprojection->reused = 0;
+    reprojection->recomputed = 0;
+    reprojection->gpu_time = 0.0;
+    reprojection->frames = 0;
+}
+
+/*
+    Anything but the window moving changes every texel, so the previous field is only offered when the rest
+    of push matches the last frame's
+*/
+static uint32_t same_field(compute_push_constants_t *a, compute_push_constants_t *b) {
+    return a->mode == FRACTAL_MODE_WINDOW && b->mode == FRACTAL_MODE_WINDOW
+        && a->C[0] == b->C[0] && a->C[1] == b->C[1] && a->t == b->t
+        && a->max_iterations == b->max_iterations && a->bailout == b->bailout
+        && a->interior_check == b->interior_check && a->instrumentation == b->instrumentation;
+}
+
+/*
+    Replaces update_fractal for window mode pushes. The frame reads the slot before it, which the next frame
+    may not overwrite until this one is done with it, hence the compute stage on the begin barrier.
+*/
+void update_fractal_reprojected(reprojection_t *reprojection, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index) {
+    VkQueryPool timestamp_pool = fractal_data->timestamp_pool;
+    compute_push_constants_t *previous = &reprojection->previous;
+
+    push.origin[0] = 0;
+    push.origin[1] = 0;
+
+    reprojection_push_constants_t reprojection_push = {
+        .x_min = push.x_min,
+        .x_max = push.x_max,
+        .y_min = push.y_min,
+        .y_max = push.y_max,
+        .previous_x_min = previous->x_min,
+        .previous_x_max = previous->x_max,
+        .previous_y_min = previous->y_min,
+        .previous_y_max = previous->y_max,
+        .width = push.width,
+        .height = push.height,
+        .previous_width = previous->width,
+        .previous_height = previous->height,
+        .valid = reprojection->valid && same_field(&push, previous),
+        .tolerance = REPROJECTION_TOLERANCE
+    };
+
+    recompute_header_t header = {
+        .dispatch = {0, 1, 1},
+        .count = 0
+    };
+
+    //The previous frame's indirect dispatch has to have read the header before it is reset
+    VkBufferMemoryBarrier2 header_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = fractal_data->recompute_buffer.buffer,
+        .offset = 0,
+        .size = sizeof(recompute_header_t),
+        .srcStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_NONE,
+        .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+    pipeline_barrier(command_buffer, 0, NULL, 1, &header_barrier, 0, NULL);
+    vkCmdUpdateBuffer(command_buffer, fractal_data->recompute_buffer.buffer, 0, sizeof(recompute_header_t), &header);
+
+    /*
+        The reset header and the list written by the last frame's reprojection, and the previous slot's image
+        and offsets written by the last frame's list dispatch, are all read or appended to here
+    */
+    VkMemoryBarrier2 begin_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        .pNext = NULL
+    };
+    pipeline_barrier(command_buffer, 1, &begin_barrier, 0, NULL, 1, &fractal_data->begin_barriers[frame_index]);
+
+    if(timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, timestamp_pool, 2*frame_index, 2);
+        vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index);
+    }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, reprojection->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, reprojection->layout, 0, 1, &reprojection->descriptors[frame_index], 0, NULL);
+    vkCmdPushConstants(command_buffer, reprojection->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(reprojection_push_constants_t), &reprojection_push);
+    vkCmdDispatch(command_buffer, push.width/REPROJECTION_THREAD_COUNT + (push.width % REPROJECTION_THREAD_COUNT != 0), push.height/REPROJECTION_THREAD_COUNT + (push.height % REPROJECTION_THREAD_COUNT != 0), 1);
+
+    VkBufferMemoryBarrier2 list_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = fractal_data->recompute_buffer.buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+    pipeline_barrier(command_buffer, 0, NULL, 1, &list_barrier, 0, NULL);
+
+    compute_push_constants_t list_push = push;
+    list_push.mode = FRACTAL_MODE_LIST;
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->layout, 0, 1, &fractal_data->descriptors[frame_index], 0, NULL);
+    vkCmdPushConstants(command_buffer, fractal_data->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(compute_push_constants_t), &list_push);
+    vkCmdDispatchIndirect(command_buffer, fractal_data->recompute_buffer.buffer, 0);
+
+    if(timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timestamp_pool, 2*frame_index + 1);
+        fractal_data->timestamps_written[frame_index] = 1;
+    }
+
+    VkBufferMemoryBarrier2 stats_barrier = host_read_barrier(reprojection->stats_buffers[frame_index].buffer);
+    pipeline_barrier(command_buffer, 0, NULL, 1, &stats_barrier, 1, &fractal_data->end_barriers[frame_index]);
+
+    reprojection->previous = push;
+    reprojection->valid = push.mode == FRACTAL_MODE_WINDOW;
+}
+
+void destroy_reprojection(reprojection_t *reprojection, VkDevice logical_device) {
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        destroy_buffer(&reprojection->offset_buffers[i], logical_device);
+        destroy_host_buffer(&reprojection->stats_buffers[i], logical_device);
+    }
+
+    vkDestroyPipelineLayout(logical_device, reprojection->layout, NULL);
+    vkDestroyPipeline(logical_device, reprojection->pipeline, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, reprojection->descriptor_layout, NULL);
+
+    free(reprojection->offset_buffers);
+    free(reprojection->stats_buffers);
+    free(reprojection->descriptors);
+}
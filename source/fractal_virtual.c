@@ -0,0 +1,539 @@
+#include "fractal_virtual.h"
+
+extern uint32_t frames_in_flight;
+
+#define VT_THREAD_COUNT 8
+
+static uint32_t page_hash(uint32_t level, uint32_t x, uint32_t y) {
+    return (x*73856093u ^ y*19349663u ^ level*83492791u) & (VT_TABLE_SIZE - 1);
+}
+
+static uint32_t find_page(virtual_texture_t *texture, uint32_t level, uint32_t x, uint32_t y) {
+    for(uint32_t i = page_hash(level, x, y);; i = (i + 1) & (VT_TABLE_SIZE - 1)) {
+        vt_page_t *entry = &texture->table[i];
+
+        if(entry->level == VT_EMPTY) {
+            return VT_EMPTY;
+        }
+
+        if(entry->level == level && entry->x == x && entry->y == y) {
+            return entry->slot;
+        }
+    }
+}
+
+/*
+    Linear probing has no cheap removal, the table is small enough to rebuild whenever a slot changes owner
+*/
+static void rebuild_page_table(virtual_texture_t *texture) {
+    memset(texture->table, 0xFF, sizeof(texture->table));
+
+    for(uint32_t slot = 0; slot < VT_SLOT_COUNT; slot++) {
+        vt_page_t page = texture->slots[slot];
+        if(page.level == VT_EMPTY || texture->slot_pending[slot]) {
+            continue;
+        }
+
+        uint32_t i = page_hash(page.level, page.x, page.y);
+        while(texture->table[i].level != VT_EMPTY) {
+            i = (i + 1) & (VT_TABLE_SIZE - 1);
+        }
+
+        texture->table[i] = page;
+        texture->table[i].slot = slot;
+    }
+}
+
+/*
+    A free slot if there is one, otherwise the least recently used page that was not seen in the latest feedback.
+    The level 0 page is the fallback for every fragment and is never evicted, nor are slots waiting on a cache read.
+*/
+static uint32_t acquire_slot(virtual_texture_t *texture) {
+    uint32_t victim = VT_EMPTY;
+
+    for(uint32_t slot = 0; slot < VT_SLOT_COUNT; slot++) {
+        if(texture->slots[slot].level == VT_EMPTY) {
+            return slot;
+        }
+
+        if(texture->slots[slot].level == 0 || texture->slot_pending[slot] || texture->last_used[slot] >= texture->frame) {
+            continue;
+        }
+
+        if(victim == VT_EMPTY || texture->last_used[slot] < texture->last_used[victim]) {
+            victim = slot;
+        }
+    }
+
+    return victim;
+}
+
+VkSampler create_atlas_sampler(VkDevice logical_device) {
+    VkSampler sampler;
+    VkSamplerCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+    };
+
+    if(vkCreateSampler(logical_device, &create_info, NULL, &sampler) != VK_SUCCESS) {
+        error(1, "Failed to create atlas sampler");
+    }
+
+    return sampler;
+}
+
+void initialise_virtual_texture(virtual_texture_t *texture, renderer_t *renderer, fractal_data_t *fractal_data, complex float c, tile_cache_t *cache) {
+    uint32_t frames_in_flight = renderer->frame_count;
+    uint32_t atlas_size = VT_ATLAS_PAGES*VT_PAGE_SIZE;
+
+    VkPhysicalDeviceFeatures device_features;
+    vkGetPhysicalDeviceFeatures(renderer->physical_device, &device_features);
+    if(!device_features.fragmentStoresAndAtomics) {
+        error(1, "Virtual texture feedback needs fragmentStoresAndAtomics\n");
+    }
+
+    image_t atlas = create_image(renderer, atlas_size, atlas_size, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkImageView atlas_view = create_image_view(atlas.image, renderer->logical_device, 1, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    host_buffer_t *page_tables = malloc(frames_in_flight*sizeof(host_buffer_t));
+    host_buffer_t *feedback = malloc(frames_in_flight*sizeof(host_buffer_t));
+    VkDescriptorSet *descriptors = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+    host_buffer_t *readback = malloc(frames_in_flight*sizeof(host_buffer_t));
+    uint64_t *written_hashes = malloc(frames_in_flight*VT_PAGES_PER_FRAME*sizeof(uint64_t));
+    uint32_t *written_counts = calloc(frames_in_flight, sizeof(uint32_t));
+
+    if(!(page_tables && feedback && descriptors && readback && written_hashes && written_counts)) {
+        error(1, "Failed to allocate virtual texture resources\n");
+    }
+
+    VkSampler sampler = create_atlas_sampler(renderer->logical_device);
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+    add_binding(&layout_builder, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
+    add_binding(&layout_builder, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
+    VkDescriptorSetLayout virtual_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    descriptor_writer_t writer = initialise_writer();
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        page_tables[i] = create_mapped_buffer(renderer, VT_TABLE_SIZE*sizeof(vt_page_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        feedback[i] = create_mapped_buffer(renderer, sizeof(vt_feedback_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        memset(page_tables[i].mapped_memory, 0xFF, VT_TABLE_SIZE*sizeof(vt_page_t));
+        memset(feedback[i].mapped_memory, 0, sizeof(vt_feedback_t));
+        readback[i] = create_mapped_buffer(renderer, VT_PAGES_PER_FRAME*VT_PAGE_BYTES, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+        allocate_descriptor_set(&descriptors[i], renderer->logical_device, renderer->global_pool, &virtual_layout, 1);
+
+        write_image(&writer, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, atlas_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        write_sampler(&writer, 1, sampler);
+        write_buffer(&writer, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, page_tables[i].buffer, VT_TABLE_SIZE*sizeof(vt_page_t), 0);
+        write_buffer(&writer, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, feedback[i].buffer, sizeof(vt_feedback_t), 0);
+        update_set(&writer, renderer->logical_device, descriptors[i]);
+        clear_writes(&writer);
+    }
+
+    VkDescriptorSet atlas_descriptor;
+    allocate_descriptor_set(&atlas_descriptor, renderer->logical_device, renderer->global_pool, &fractal_data->descriptor_layout, 1);
+    write_fractal_set(fractal_data, &writer, renderer->logical_device, atlas_descriptor, atlas_view, 0);
+    free_writer(&writer);
+
+    *texture = (virtual_texture_t){
+        .descriptor_layout = virtual_layout,
+        .descriptors = descriptors,
+        .atlas_descriptor = atlas_descriptor,
+        .sampler = sampler,
+        .atlas = atlas,
+        .atlas_view = atlas_view,
+        .atlas_ready = 0,
+        .page_tables = page_tables,
+        .feedback = feedback,
+        .frame = 0,
+        .c = c,
+        .cache = cache,
+        .staging = create_mapped_buffer(renderer, VT_STAGING_PAGES*VT_PAGE_BYTES, VK_BUFFER_USAGE_TRANSFER_SRC_BIT),
+        .readback = readback,
+        .written_hashes = written_hashes,
+        .written_counts = written_counts,
+        .base_iterations = 256,
+        .level_iterations = 64,
+        .max_iterations = 1024
+    };
+
+    memset(texture->table, 0xFF, sizeof(texture->table));
+    memset(texture->slots, 0xFF, sizeof(texture->slots));
+    memset(texture->slot_pending, 0, sizeof(texture->slot_pending));
+    memset(texture->last_used, 0, sizeof(texture->last_used));
+
+    for(uint32_t i = 0; i < VT_STAGING_PAGES; i++) {
+        atomic_init(&texture->staging_pages[i].state, TILE_READ_IDLE);
+        texture->staging_pages[i].release_frame = 0;
+    }
+}
+
+/*
+    Texel j of a slot sits at page coordinate (j - VT_PAGE_BORDER + 0.5)/VT_PAGE_PAYLOAD, which shader.comp
+    reaches as x_min + (x_max - x_min)*j/VT_PAGE_SIZE
+*/
+static compute_push_constants_t page_push_constants(virtual_texture_t *texture, vt_page_t page) {
+    float page_width = 2.0f/(float)(1u << page.level);
+    float texel_width = page_width/(float)VT_PAGE_PAYLOAD;
+    float x_min = -1.0f + page_width*(float)page.x + texel_width*(0.5f - (float)VT_PAGE_BORDER);
+    float y_min = -1.0f + page_width*(float)page.y + texel_width*(0.5f - (float)VT_PAGE_BORDER);
+    uint32_t iterations = texture->base_iterations + texture->level_iterations*page.level;
+
+    compute_push_constants_t push = {
+        .x_min = x_min,
+        .x_max = x_min + texel_width*(float)VT_PAGE_SIZE,
+        .y_min = y_min,
+        .y_max = y_min + texel_width*(float)VT_PAGE_SIZE,
+        .z = texture->c,
+        .t = 0,
+        .mode = FRACTAL_MODE_WINDOW,
+        .max_iterations = iterations < texture->max_iterations ? iterations : texture->max_iterations,
+        .bailout = 1e15f,
+        .width = VT_PAGE_SIZE,
+        .height = VT_PAGE_SIZE,
+        .interior_check = 1,
+        .instrumentation = 0,
+        .origin = {(page.slot % VT_ATLAS_PAGES)*VT_PAGE_SIZE, (page.slot / VT_ATLAS_PAGES)*VT_PAGE_SIZE}
+    };
+
+    return push;
+}
+
+//Everything that decides the texels of a page, the slot it lands in does not
+static uint64_t page_hash_key(compute_push_constants_t *push) {
+    tile_key_t key = {
+        .formula = push->mode,
+        .c = {push->C[0], push->C[1]},
+        .window = {push->x_min, push->x_max, push->y_min, push->y_max},
+        .width = push->width,
+        .height = push->height,
+        .max_iterations = push->max_iterations,
+        .bailout = push->bailout
+    };
+
+    return tile_hash(&key);
+}
+
+static uint32_t page_pending(virtual_texture_t *texture, vt_page_t page) {
+    for(uint32_t i = 0; i < VT_STAGING_PAGES; i++) {
+        vt_staging_t *staging = &texture->staging_pages[i];
+
+        if(atomic_load(&staging->state) == TILE_READ_PENDING && staging->page.level == page.level && staging->page.x == page.x && staging->page.y == page.y) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+//A staging page is free once its read was consumed and the frame that copied it out has retired
+static uint32_t acquire_staging(virtual_texture_t *texture) {
+    for(uint32_t i = 0; i < VT_STAGING_PAGES; i++) {
+        vt_staging_t *staging = &texture->staging_pages[i];
+
+        if(atomic_load(&staging->state) == TILE_READ_IDLE && staging->release_frame <= texture->frame) {
+            return i;
+        }
+    }
+
+    return VT_EMPTY;
+}
+
+/*
+    Must be called after the frame has been waited for, the feedback and read back pages then belong to the
+    previous use of the frame. Loads up to VT_PAGES_PER_FRAME of the requested pages, coarsest first. Pages in the
+    tile cache are read by its I/O thread and uploaded on a later frame, the rest are computed and written back to
+    the cache. Returns how many pages were computed or uploaded.
+*/
+uint32_t update_virtual_texture(virtual_texture_t *texture, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, uint32_t frame_index) {
+    vt_feedback_t *feedback = texture->feedback[frame_index].mapped_memory;
+    float *staging_memory = texture->staging.mapped_memory;
+    float *readback_memory = texture->readback[frame_index].mapped_memory;
+    uint64_t *written_hashes = &texture->written_hashes[frame_index*VT_PAGES_PER_FRAME];
+    vt_page_t candidates[VT_PAGES_PER_FRAME];
+    vt_page_t computed[VT_PAGES_PER_FRAME];
+    uint32_t uploaded[VT_STAGING_PAGES];
+    uint32_t candidate_count = 0, computed_count = 0, uploaded_count = 0, changed = 0;
+
+    texture->frame++;
+
+    for(uint32_t i = 0; i < texture->written_counts[frame_index]; i++) {
+        store_tile(texture->cache, written_hashes[i], readback_memory + i*4*VT_PAGE_TEXELS, VT_PAGE_TEXELS);
+    }
+    texture->written_counts[frame_index] = 0;
+
+    for(uint32_t slot = 0; slot < VT_SLOT_COUNT; slot++) {
+        if(feedback->slot_used[slot]) {
+            texture->last_used[slot] = texture->frame;
+        }
+    }
+
+    for(uint32_t i = 0; i < VT_STAGING_PAGES; i++) {
+        vt_staging_t *staging = &texture->staging_pages[i];
+        uint32_t state = atomic_load(&staging->state);
+        uint32_t slot = staging->page.slot;
+
+        if(state == TILE_READ_DONE) {
+            texture->slot_pending[slot] = 0;
+            texture->last_used[slot] = texture->frame;
+            staging->release_frame = texture->frame + frames_in_flight;
+            uploaded[uploaded_count++] = i;
+            changed = 1;
+        } else if(state == TILE_READ_FAILED) {
+            texture->slot_pending[slot] = 0;
+            texture->slots[slot].level = VT_EMPTY;
+        }
+
+        if(state == TILE_READ_DONE || state == TILE_READ_FAILED) {
+            atomic_store(&staging->state, TILE_READ_IDLE);
+        }
+    }
+
+    if(changed) {
+        rebuild_page_table(texture);
+    }
+
+    if(find_page(texture, 0, 0, 0) == VT_EMPTY && !page_pending(texture, (vt_page_t){0, 0, 0, VT_EMPTY})) {
+        candidates[candidate_count++] = (vt_page_t){0, 0, 0, VT_EMPTY};
+    }
+
+    uint32_t request_count = feedback->request_count < VT_REQUEST_CAPACITY ? feedback->request_count : VT_REQUEST_CAPACITY;
+    for(uint32_t i = 0; i < request_count; i++) {
+        vt_page_t request = feedback->requests[i];
+
+        if(request.level > VT_MAX_LEVEL || request.x >= (1u << request.level) || request.y >= (1u << request.level)) {
+            continue;
+        }
+
+        if(find_page(texture, request.level, request.x, request.y) != VT_EMPTY || page_pending(texture, request)) {
+            continue;
+        }
+
+        uint32_t coarsest = 0, duplicate = 0;
+        for(uint32_t j = 0; j < candidate_count; j++) {
+            duplicate |= candidates[j].level == request.level && candidates[j].x == request.x && candidates[j].y == request.y;
+            coarsest = candidates[j].level > candidates[coarsest].level ? j : coarsest;
+        }
+
+        if(duplicate) {
+            continue;
+        }
+
+        if(candidate_count < VT_PAGES_PER_FRAME) {
+            candidates[candidate_count++] = request;
+        } else if(request.level < candidates[coarsest].level) {
+            candidates[coarsest] = request;
+        }
+    }
+
+    memset(feedback, 0, sizeof(vt_feedback_t));
+
+    for(uint32_t i = 0; i < candidate_count; i++) {
+        uint32_t slot = acquire_slot(texture);
+        if(slot == VT_EMPTY) {
+            break;
+        }
+
+        vt_page_t page = candidates[i];
+        page.slot = slot;
+        texture->slots[slot] = page;
+        texture->last_used[slot] = texture->frame;
+
+        compute_push_constants_t push = page_push_constants(texture, page);
+        uint64_t hash = texture->cache ? page_hash_key(&push) : 0;
+        uint32_t staging = texture->cache && tile_cached(texture->cache, hash) ? acquire_staging(texture) : VT_EMPTY;
+
+        if(staging != VT_EMPTY) {
+            texture->slot_pending[slot] = 1;
+            texture->staging_pages[staging].page = page;
+            read_tile(texture->cache, hash, staging_memory + staging*4*VT_PAGE_TEXELS, VT_PAGE_TEXELS, &texture->staging_pages[staging].state);
+            continue;
+        }
+
+        written_hashes[computed_count] = hash;
+        computed[computed_count++] = page;
+        changed = 1;
+    }
+
+    if(texture->cache) {
+        texture->written_counts[frame_index] = computed_count;
+    }
+
+    if(changed) {
+        rebuild_page_table(texture);
+    }
+    memcpy(texture->page_tables[frame_index].mapped_memory, texture->table, sizeof(texture->table));
+
+    if(computed_count == 0 && uploaded_count == 0 && texture->atlas_ready) {
+        return 0;
+    }
+
+    VkImageMemoryBarrier2 begin_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image = texture->atlas.image,
+        .subresourceRange = (VkImageSubresourceRange){
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = 1,
+            .baseMipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_NONE,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_COPY_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .oldLayout = texture->atlas_ready ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .pNext = NULL
+    };
+
+    VkImageMemoryBarrier2 readback_barrier = begin_barrier;
+    readback_barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    readback_barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    readback_barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    readback_barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+    readback_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkImageMemoryBarrier2 end_barrier = begin_barrier;
+    end_barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_COPY_BIT;
+    end_barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    end_barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    end_barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    end_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    end_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkBufferMemoryBarrier2 host_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = texture->readback[frame_index].buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+        .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+
+    //The atlas is shared by all frames in flight, earlier frames have to be done sampling the evicted slots
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &begin_barrier);
+
+    if(computed_count > 0) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->layout, 0, 1, &texture->atlas_descriptor, 0, NULL);
+    }
+
+    for(uint32_t i = 0; i < computed_count; i++) {
+        compute_push_constants_t push = page_push_constants(texture, computed[i]);
+
+        vkCmdPushConstants(command_buffer, fractal_data->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(compute_push_constants_t), &push);
+        vkCmdDispatch(command_buffer, VT_PAGE_SIZE/VT_THREAD_COUNT, VT_PAGE_SIZE/VT_THREAD_COUNT, 1);
+    }
+
+    for(uint32_t i = 0; i < uploaded_count; i++) {
+        uint32_t slot = texture->staging_pages[uploaded[i]].page.slot;
+        VkBufferImageCopy region = {
+            .bufferOffset = uploaded[i]*VT_PAGE_BYTES,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .imageOffset = {(int32_t)((slot % VT_ATLAS_PAGES)*VT_PAGE_SIZE), (int32_t)((slot / VT_ATLAS_PAGES)*VT_PAGE_SIZE), 0},
+            .imageExtent = {VT_PAGE_SIZE, VT_PAGE_SIZE, 1}
+        };
+
+        vkCmdCopyBufferToImage(command_buffer, texture->staging.buffer, texture->atlas.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+    }
+
+    if(texture->cache && computed_count > 0) {
+        pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &readback_barrier);
+
+        for(uint32_t i = 0; i < computed_count; i++) {
+            VkBufferImageCopy region = {
+                .bufferOffset = i*VT_PAGE_BYTES,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                },
+                .imageOffset = {(int32_t)((computed[i].slot % VT_ATLAS_PAGES)*VT_PAGE_SIZE), (int32_t)((computed[i].slot / VT_ATLAS_PAGES)*VT_PAGE_SIZE), 0},
+                .imageExtent = {VT_PAGE_SIZE, VT_PAGE_SIZE, 1}
+            };
+
+            vkCmdCopyImageToBuffer(command_buffer, texture->atlas.image, VK_IMAGE_LAYOUT_GENERAL, texture->readback[frame_index].buffer, 1, &region);
+        }
+
+        pipeline_barrier(command_buffer, 0, NULL, 1, &host_barrier, 0, NULL);
+    }
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &end_barrier);
+    texture->atlas_ready = 1;
+
+    return computed_count + uploaded_count;
+}
+
+/*
+    Makes the feedback written by this frame's fragments visible to update_virtual_texture, call after the render pass
+*/
+void finish_virtual_texture(virtual_texture_t *texture, VkCommandBuffer command_buffer, uint32_t frame_index) {
+    VkBufferMemoryBarrier2 feedback_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = texture->feedback[frame_index].buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+        .srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+        .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+
+    pipeline_barrier(command_buffer, 0, NULL, 1, &feedback_barrier, 0, NULL);
+}
+
+void destroy_virtual_texture(virtual_texture_t *texture, VkDevice logical_device) {
+    //Reads still in flight decode into the staging buffer
+    if(texture->cache) {
+        wait_for_tasks(&texture->cache->io_thread);
+    }
+
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        destroy_host_buffer(&texture->page_tables[i], logical_device);
+        destroy_host_buffer(&texture->feedback[i], logical_device);
+        destroy_host_buffer(&texture->readback[i], logical_device);
+    }
+    destroy_host_buffer(&texture->staging, logical_device);
+
+    vkDestroyImageView(logical_device, texture->atlas_view, NULL);
+    destroy_image(&texture->atlas, logical_device);
+
+    vkDestroySampler(logical_device, texture->sampler, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, texture->descriptor_layout, NULL);
+
+    free(texture->page_tables);
+    free(texture->feedback);
+    free(texture->descriptors);
+    free(texture->readback);
+    free(texture->written_hashes);
+    free(texture->written_counts);
+}
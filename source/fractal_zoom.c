@@ -0,0 +1,186 @@
+#include "fractal_zoom.h"
+
+#define ZOOM_THREAD_COUNT 8
+
+VkSampler create_strip_sampler(VkDevice logical_device) {
+    VkSampler sampler;
+    VkSamplerCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,//Angle wraps around
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+    };
+
+    if(vkCreateSampler(logical_device, &create_info, NULL, &sampler) != VK_SUCCESS) {
+        error(1, "Failed to create strip sampler");
+    }
+
+    return sampler;
+}
+
+fractal_zoom_t initialise_fractal_zoom(renderer_t *renderer, fractal_data_t *fractal_data, complex float centre, float log_radius_start, float log_radius_end, uint32_t strip_width, uint32_t rows_per_unit) {
+    uint32_t frames_in_flight = renderer->frame_count;
+
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(renderer->physical_device, &device_properties);
+    uint32_t max_dimension = device_properties.limits.maxImageDimension2D;
+
+    float log_radius_min = log_radius_end - logf(0.5f*(float)fractal_data->texture_width);
+    float log_radius_max = log_radius_start + 0.5f*logf(2.0f);
+
+    uint32_t strip_height = (uint32_t)ceilf((log_radius_max - log_radius_min)*(float)rows_per_unit);
+    strip_height = bound(strip_height, ZOOM_THREAD_COUNT, max_dimension);
+    strip_width = bound(strip_width, ZOOM_THREAD_COUNT, max_dimension);
+    strip_height -= strip_height % ZOOM_THREAD_COUNT;
+    strip_width -= strip_width % ZOOM_THREAD_COUNT;
+
+    image_t strip_image = create_image(renderer, strip_width, strip_height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkImageView strip_image_view = create_image_view(strip_image.image, renderer->logical_device, 1, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    VkImageSubresourceRange subresource_range = {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .levelCount = 1,
+        .baseMipLevel = 0,
+        .baseArrayLayer = 0,
+        .layerCount = 1
+    };
+
+    VkImageMemoryBarrier2 begin_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image = strip_image.image,
+        .subresourceRange = subresource_range,
+        .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .srcAccessMask = VK_ACCESS_2_NONE,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .pNext = NULL
+    };
+
+    VkImageMemoryBarrier2 end_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image = strip_image.image,
+        .subresourceRange = subresource_range,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .pNext = NULL
+    };
+
+    VkSampler sampler = create_strip_sampler(renderer->logical_device);
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    descriptor_writer_t writer = initialise_writer();
+
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+    VkDescriptorSetLayout zoom_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    VkDescriptorSet strip_set;
+    allocate_descriptor_set(&strip_set, renderer->logical_device, renderer->global_pool, &fractal_data->descriptor_layout, 1);
+    write_fractal_set(fractal_data, &writer, renderer->logical_device, strip_set, strip_image_view, 0);
+
+    VkDescriptorSet *zoom_sets = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+    if(zoom_sets == NULL) {
+        error(1, "Failed to allocate zoom descriptor sets\n");
+    }
+
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        allocate_descriptor_set(&zoom_sets[i], renderer->logical_device, renderer->global_pool, &zoom_layout, 1);
+
+        write_image(&writer, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, strip_image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        write_sampler(&writer, 1, sampler);
+        write_image(&writer, 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, fractal_data->fractal_image_views[i], VK_IMAGE_LAYOUT_GENERAL);
+        update_set(&writer, renderer->logical_device, zoom_sets[i]);
+        clear_writes(&writer);
+    }
+    free_writer(&writer);
+
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+
+    create_compute_layout(&pipeline_layout, renderer->logical_device, 1, &zoom_layout, sizeof(zoom_push_constants_t));
+    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, "bin/shaders/zoom_compute.spv");
+
+    fractal_zoom_t zoom = {
+        .pipeline = pipeline,
+        .layout = pipeline_layout,
+        .descriptor_layout = zoom_layout,
+        .descriptors = zoom_sets,
+        .strip_descriptor = strip_set,
+        .sampler = sampler,
+        .begin_barrier = begin_barrier,
+        .end_barrier = end_barrier,
+        .strip_width = strip_width,
+        .strip_height = strip_height,
+        .strip_image = strip_image,
+        .strip_image_view = strip_image_view,
+        .centre = {crealf(centre), cimagf(centre)},
+        .log_radius_min = log_radius_min,
+        .log_radius_max = log_radius_max,
+        .strip_ready = 0
+    };
+
+    return zoom;
+}
+
+void render_zoom_strip(fractal_zoom_t *zoom, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push) {
+    push.mode = FRACTAL_MODE_EXP_MAP;
+    push.centre[0] = zoom->centre[0];
+    push.centre[1] = zoom->centre[1];
+    push.log_radius_min = zoom->log_radius_min;
+    push.log_radius_max = zoom->log_radius_max;
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &zoom->begin_barrier);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->layout, 0, 1, &zoom->strip_descriptor, 0, NULL);
+    vkCmdPushConstants(command_buffer, fractal_data->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(compute_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, zoom->strip_width/ZOOM_THREAD_COUNT, zoom->strip_height/ZOOM_THREAD_COUNT, 1);
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &zoom->end_barrier);
+
+    zoom->strip_ready = 1;
+}
+
+void update_zoom_frame(fractal_zoom_t *zoom, fractal_data_t *fractal_data, VkCommandBuffer command_buffer, float log_radius, uint32_t frame_index) {
+    zoom_push_constants_t push = {
+        .log_radius = log_radius,
+        .log_radius_min = zoom->log_radius_min,
+        .log_radius_max = zoom->log_radius_max,
+        .padding = 0
+    };
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &fractal_data->begin_barriers[frame_index]);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, zoom->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, zoom->layout, 0, 1, &zoom->descriptors[frame_index], 0, NULL);
+    vkCmdPushConstants(command_buffer, zoom->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(zoom_push_constants_t), &push);
+    vkCmdDispatch(command_buffer, fractal_data->texture_width/ZOOM_THREAD_COUNT + (fractal_data->texture_width % ZOOM_THREAD_COUNT != 0), fractal_data->texture_height/ZOOM_THREAD_COUNT + (fractal_data->texture_height % ZOOM_THREAD_COUNT != 0), 1);
+
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &fractal_data->end_barriers[frame_index]);
+}
+
+void destroy_fractal_zoom(fractal_zoom_t *zoom, VkDevice logical_device) {
+    vkDestroyImageView(logical_device, zoom->strip_image_view, NULL);
+    destroy_image(&zoom->strip_image, logical_device);
+
+    vkDestroySampler(logical_device, zoom->sampler, NULL);
+    vkDestroyPipelineLayout(logical_device, zoom->layout, NULL);
+    vkDestroyPipeline(logical_device, zoom->pipeline, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, zoom->descriptor_layout, NULL);
+
+    free(zoom->descriptors);
+}
@@ -0,0 +1,89 @@
+#include "frame_budget.h"
+
+const quality_level_t quality_levels[] = {
+    {1024, 1.0f,        1e15f},
+    {1024, 0.70710678f, 1e15f},
+    {512,  0.70710678f, 1e10f},
+    {512,  0.5f,        1e10f},
+    {256,  0.5f,        1e8f},
+    {256,  0.35355339f, 1e8f},
+    {128,  0.35355339f, 1e6f},
+    {128,  0.25f,       1e6f},
+    {64,   0.25f,       1e4f}
+};
+
+const uint32_t quality_level_count = sizeof(quality_levels)/sizeof(quality_level_t);
+
+frame_budget_t initialise_frame_budget(double target_time) {
+    return (frame_budget_t){
+        .target_time = target_time,
+        .smoothed_time = 0,
+        .level = 0,
+        .cooldown = 0,
+        .frames_under = 0,
+        .has_sample = 0
+    };
+}
+
+/*
+    Rungs roughly halve the cost, so the model is rescaled rather than discarded
+*/
+void change_level(frame_budget_t *budget, uint32_t level) {
+    budget->smoothed_time *= pow(2.0, (double)budget->level - (double)level);
+    budget->level = level;
+    budget->cooldown = BUDGET_COOLDOWN_FRAMES;
+    budget->frames_under = 0;
+}
+
+/*
+    dispatch_time is the measured GPU time in seconds of the frame that just completed, negative if unavailable.
+    measured_cost is the predicted cost of that frame and next_cost the prediction for the frame about to be recorded,
+    both 1 when there is no prediction.
+*/
+void update_frame_budget(frame_budget_t *budget, double dispatch_time, float measured_cost, float next_cost) {
+    if(dispatch_time >= 0 && budget->cooldown == 0) {
+        double unit_time = dispatch_time/fmax(measured_cost, BUDGET_MIN_COST);
+
+        if(budget->has_sample) {
+            budget->smoothed_time += BUDGET_SMOOTHING*(unit_time - budget->smoothed_time);
+        } else {
+            budget->smoothed_time = unit_time;
+            budget->has_sample = 1;
+        }
+    } else if(budget->cooldown > 0) {
+        budget->cooldown--;
+    }
+
+    if(!budget->has_sample) {
+        return;
+    }
+
+    double ratio = budget->smoothed_time*fmax(next_cost, BUDGET_MIN_COST)/budget->target_time;
+
+    if(ratio > BUDGET_HIGH_WATERMARK && budget->level + 1 < quality_level_count) {
+        uint32_t steps = (uint32_t)ceil(log2(ratio));
+        uint32_t level = budget->level + (steps > 0 ? steps : 1);
+
+        change_level(budget, level < quality_level_count ? level : quality_level_count - 1);
+    } else if(ratio < BUDGET_LOW_WATERMARK && budget->level > 0 && budget->cooldown == 0) {
+        if(++budget->frames_under >= BUDGET_RAISE_FRAMES) {
+            change_level(budget, budget->level - 1);
+        }
+    } else {
+        budget->frames_under = 0;
+    }
+}
+
+quality_level_t current_quality(frame_budget_t *budget) {
+    return quality_levels[budget->level];
+}
+
+/*
+    Rounded down to whole workgroups of the compute shader
+*/
+uint32_t scaled_resolution(quality_level_t *quality, uint32_t texture_size) {
+    uint32_t size = (uint32_t)((float)texture_size*quality->resolution_scale);
+    size -= size % 8;
+
+    return size < 8 ? 8 : size;
+}
@@ -0,0 +1,111 @@
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "frame_pacing.h"
+#include "vulkan_utils.h"
+
+const char *pacing_mode_names[] = {"low latency", "throughput", "target fps"};
+
+uint32_t pacing_frames_in_flight(pacing_mode_t mode) {
+    switch(mode) {
+        case PACING_LOW_LATENCY:
+            return PACING_LOW_LATENCY_FRAMES;
+        case PACING_TARGET_FPS:
+            return PACING_TARGET_FPS_FRAMES;
+        default:
+            return PACING_THROUGHPUT_FRAMES;
+    }
+}
+
+frame_pacing_t initialise_frame_pacing(pacing_mode_t mode, double target_fps) {
+    frame_pacing_t pacing = {
+        .mode = mode,
+        .frame_count = pacing_frames_in_flight(mode),
+        .frame_period = mode == PACING_TARGET_FPS && target_fps > 0.0 ? 1.0/target_fps : 0.0,
+        .next_start = 0.0,
+        .latency_sum = 0.0,
+        .latency_max = 0.0,
+        .latency_count = 0
+    };
+
+    pacing.input_times = calloc(pacing.frame_count, sizeof(double));
+    if(pacing.input_times == NULL) {
+        error(1, "Failed to allocate frame pacing\n");
+    }
+
+    return pacing;
+}
+
+//Seconds on a monotonic clock
+double pacing_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + 1e-9*(double)now.tv_nsec;
+}
+
+/*
+    Sleeps until the frame's start time, nanosleep is repeated when woken early rather than spinning out the
+    remainder. A frame that starts late moves the schedule instead of being followed by a burst of catch-up frames.
+*/
+void wait_for_frame_start(frame_pacing_t *pacing) {
+    if(pacing->frame_period == 0.0) {
+        return;
+    }
+
+    double now = pacing_time();
+    if(pacing->next_start == 0.0 || now > pacing->next_start + pacing->frame_period) {
+        pacing->next_start = now;
+    }
+
+    for(double remaining = pacing->next_start - now; remaining > 0.0; remaining = pacing->next_start - pacing_time()) {
+        struct timespec duration = {
+            .tv_sec = (time_t)remaining,
+            .tv_nsec = (long)(1e9*(remaining - (double)(time_t)remaining))
+        };
+        nanosleep(&duration, NULL);
+    }
+
+    pacing->next_start += pacing->frame_period;
+}
+
+/*
+    Call once the frame's input and animation parameters have been read, after begin_frame
+*/
+void sample_frame_input(frame_pacing_t *pacing, uint32_t frame_index) {
+    pacing->input_times[frame_index] = pacing_time();
+}
+
+/*
+    Call as soon as the slot's last submission is known to have completed
+*/
+void complete_frame(frame_pacing_t *pacing, uint32_t frame_index) {
+    if(pacing->input_times[frame_index] == 0.0) {
+        return;
+    }
+
+    double latency = pacing_time() - pacing->input_times[frame_index];
+    pacing->input_times[frame_index] = 0.0;
+
+    pacing->latency_sum += latency;
+    pacing->latency_max = latency > pacing->latency_max ? latency : pacing->latency_max;
+    pacing->latency_count++;
+}
+
+//Prints the latency since the last call and starts over
+void print_frame_pacing_stats(frame_pacing_t *pacing) {
+    if(pacing->latency_count == 0) {
+        return;
+    }
+
+    printf("Pacing (%s, %u in flight): %u frames, input to completion %.2f ms mean, %.2f ms max\n",
+        pacing_mode_names[pacing->mode], pacing->frame_count, pacing->latency_count,
+        1e3*pacing->latency_sum/(double)pacing->latency_count, 1e3*pacing->latency_max);
+
+    pacing->latency_sum = 0.0;
+    pacing->latency_max = 0.0;
+    pacing->latency_count = 0;
+}
+
+void destroy_frame_pacing(frame_pacing_t *pacing) {
+    free(pacing->input_times);
+}
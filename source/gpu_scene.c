@@ -0,0 +1,172 @@
+#include "gpu_scene.h"
+
+//Whether the device has the optional features create_logical_device enables for the GPU scene when present
+uint32_t gpu_scene_supported(VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceVulkan12Features vulkan_12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+    };
+    VkPhysicalDeviceFeatures2 features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan_12_features
+    };
+    vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+    return features.features.drawIndirectFirstInstance && vulkan_12_features.drawIndirectCount;
+}
+
+void initialise_gpu_scene(gpu_scene_t *scene, renderer_t *renderer, gpu_object_t *objects, uint32_t object_count) {
+    uint32_t frames_in_flight = renderer->frame_count;
+    VkDeviceSize object_size = object_count*sizeof(gpu_object_t);
+    VkDeviceSize command_size = object_count*sizeof(VkDrawIndexedIndirectCommand);
+
+    scene->object_count = object_count;
+    scene->frame_count = frames_in_flight;
+
+    //Sized to the objects exactly, the cull shader takes their number from its length
+    scene->object_buffer = create_device_buffer(renderer, object_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    upload_buffer(renderer, &scene->object_buffer, objects, object_size);
+
+    scene->command_buffers = malloc(frames_in_flight*sizeof(buffer_t));
+    scene->count_buffers = malloc(frames_in_flight*sizeof(buffer_t));
+    scene->cull_descriptors = malloc(frames_in_flight*sizeof(VkDescriptorSet));
+
+    if(scene->command_buffers == NULL || scene->count_buffers == NULL || scene->cull_descriptors == NULL) {
+        error(1, "Failed to allocate GPU scene\n");
+    }
+
+    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    add_binding(&layout_builder, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+    scene->cull_layout = build_layout(&layout_builder, renderer->logical_device);
+    clear_bindings(&layout_builder);
+    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    scene->object_layout = build_layout(&layout_builder, renderer->logical_device);
+    free_layout_builder(&layout_builder);
+
+    descriptor_writer_t writer = initialise_writer();
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        scene->command_buffers[i] = create_device_buffer(renderer, command_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+        scene->count_buffers[i] = create_device_buffer(renderer, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+        allocate_descriptor_set(&scene->cull_descriptors[i], renderer->logical_device, renderer->global_pool, &scene->cull_layout, 1);
+        write_buffer(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, scene->object_buffer.buffer, object_size, 0);
+        write_buffer(&writer, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, scene->command_buffers[i].buffer, command_size, 0);
+        write_buffer(&writer, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, scene->count_buffers[i].buffer, sizeof(uint32_t), 0);
+        update_set(&writer, renderer->logical_device, scene->cull_descriptors[i]);
+        clear_writes(&writer);
+    }
+
+    allocate_descriptor_set(&scene->object_descriptor, renderer->logical_device, renderer->global_pool, &scene->object_layout, 1);
+    write_buffer(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, scene->object_buffer.buffer, object_size, 0);
+    update_set(&writer, renderer->logical_device, scene->object_descriptor);
+    free_writer(&writer);
+
+    create_compute_layout(&scene->cull_pipeline_layout, renderer->logical_device, 1, &scene->cull_layout, sizeof(gpu_cull_push_t));
+    create_compute_pipeline(&scene->cull_pipeline, scene->cull_pipeline_layout, renderer->logical_device, "bin/shaders/cull_compute.spv");
+}
+
+/*
+    Must be recorded outside of rendering. The slot's commands were last read by its previous frame, which
+    has been waited for, so only the count reset has to be ordered before the cull.
+*/
+void cull_gpu_scene(gpu_scene_t *scene, VkCommandBuffer command_buffer, transformation_t model, transformation_t view_projection, uint32_t frame_index) {
+    gpu_cull_push_t push = {
+        .model = model,
+        .view_projection = view_projection
+    };
+
+    VkBufferMemoryBarrier2 reset_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .buffer = scene->count_buffers[frame_index].buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+        .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+
+    vkCmdFillBuffer(command_buffer, scene->count_buffers[frame_index].buffer, 0, sizeof(uint32_t), 0);
+    pipeline_barrier(command_buffer, 0, NULL, 1, &reset_barrier, 0, NULL);
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, scene->cull_pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, scene->cull_pipeline_layout, 0, 1, &scene->cull_descriptors[frame_index], 0, NULL);
+    vkCmdPushConstants(command_buffer, scene->cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(gpu_cull_push_t), &push);
+    vkCmdDispatch(command_buffer, scene->object_count/GPU_SCENE_THREAD_COUNT + (scene->object_count % GPU_SCENE_THREAD_COUNT != 0), 1, 1);
+
+    VkBufferMemoryBarrier2 draw_barriers[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer = scene->command_buffers[frame_index].buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+            .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .buffer = scene->count_buffers[frame_index].buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+            .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        }
+    };
+
+    pipeline_barrier(command_buffer, 0, NULL, 2, draw_barriers, 0, NULL);
+}
+
+/*
+    Draws what the cull pass of the same frame kept, inside the scene's rendering. mesh gives the pipeline,
+    which must come from build_indirect_mesh_pipeline, the material, the vertex and index buffers every
+    object indexes into and the shared push constants. Each command's first instance is its object's
+    index, which indirect.vert reads its model with.
+*/
+void draw_gpu_scene(gpu_scene_t *scene, VkCommandBuffer command_buffer, render_object_t *mesh, VkDescriptorSet global_descriptor, uint32_t frame_index) {
+    material_t *material = mesh->material_instance;
+    material_pipeline_t *material_pipeline = material->material_pipeline;
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->layout, 0, 1, &global_descriptor, 0, NULL);
+    if(material->descriptor != VK_NULL_HANDLE) {
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->layout, 1, 1, &material->descriptor, 0, NULL);
+    }
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->layout, 2, 1, &scene->object_descriptor, 0, NULL);
+    vkCmdPushConstants(command_buffer, material_pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_data_t), &mesh->push_constant);
+
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, mesh->vertex_buffer, offsets);
+    vkCmdBindIndexBuffer(command_buffer, mesh->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+    vkCmdDrawIndexedIndirectCount(command_buffer, scene->command_buffers[frame_index].buffer, 0, scene->count_buffers[frame_index].buffer, 0, scene->object_count, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void destroy_gpu_scene(gpu_scene_t *scene, VkDevice logical_device) {
+    destroy_buffer(&scene->object_buffer, logical_device);
+    for(uint32_t i = 0; i < scene->frame_count; i++) {
+        destroy_buffer(&scene->command_buffers[i], logical_device);
+        destroy_buffer(&scene->count_buffers[i], logical_device);
+    }
+
+    vkDestroyPipeline(logical_device, scene->cull_pipeline, NULL);
+    vkDestroyPipelineLayout(logical_device, scene->cull_pipeline_layout, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, scene->cull_layout, NULL);
+    vkDestroyDescriptorSetLayout(logical_device, scene->object_layout, NULL);
+
+    free(scene->command_buffers);
+    free(scene->count_buffers);
+    free(scene->cull_descriptors);
+}
@@ -12,11 +12,26 @@
 #include <complex.h>
 #include <time.h>
 #include "renderer.h"
+#include "fractal.h"
+#include "fractal_zoom.h"
+#include "orbit_engine.h"
+#include "frame_budget.h"
+#include "cost_map.h"
+#include "fractal_iim.h"
+#include "fractal_buddhabrot.h"
+#include "fractal_virtual.h"
+#include "fractal_hybrid.h"
+#include "fractal_quaternion.h"
+#include "fractal_reprojection.h"
+#include "parallel_recorder.h"
+#include "draw_list.h"
+#include "gpu_scene.h"
+#include "render_graph.h"
 #include "window.h"
 #include "graphics_matrices.h"
 #include <unistd.h>
 
-extern const uint32_t frames_in_flight;
+extern uint32_t frames_in_flight;
 extern const uint32_t enable_validation_layers;
 extern const uint32_t HEIGHT;
 extern const uint32_t WIDTH;
@@ -27,31 +42,25 @@ uint32_t octahedral_rotation(uint32_t m, uint32_t axis) {
     return rot_group[axis % 3][m % 8];
 }
 
-typedef struct compute_push_constants_t {
-    float x_min, x_max, y_min, y_max;
-    union {
-        complex float z;
-        float C[2];
-    };
-    float t;
-    uint32_t padding;
-} compute_push_constants_t;
-
-typedef struct fractal_data_t {
-    VkPipeline pipeline;
-    VkPipelineLayout layout;
-
-    VkImageMemoryBarrier *begin_barriers, *end_barriers;
-
-    VkDescriptorSetLayout descriptor_layout;
-    VkDescriptorSet *descriptors;
-
-    uint32_t texture_width, texture_height;
-    image_t *fractal_images;
-    VkImageView *fractal_image_views;
-
-    compute_push_constants_t push_data;
-} fractal_data_t;
+typedef enum render_mode_t {
+    RENDER_MODE_ANIMATED,
+    RENDER_MODE_ZOOM,
+    RENDER_MODE_DEEP,
+    RENDER_MODE_PREVIEW,
+    RENDER_MODE_PROCEDURAL,
+    RENDER_MODE_VIRTUAL,
+    RENDER_MODE_BUDDHABROT,
+    RENDER_MODE_HYBRID,
+    RENDER_MODE_QUATERNION,
+    RENDER_MODE_EXPLORE
+} render_mode_t;
+
+const render_mode_t render_mode = RENDER_MODE_ANIMATED;
+const uint32_t fractal_instrumentation = 0;//FRACTAL_INSTRUMENT_* flags, counters are printed once per second
+const char *fractal_formula = NULL;//Iteration compiled at startup for the animated mode in place of shader.comp, e.g. "z^3 + c"
+const uint32_t scene_copies = 1;//Copies of the mesh in the scene, side by side
+const uint32_t record_threads = 0;//Draws are recorded inline when 0, otherwise split over this many threads into secondary buffers
+const uint32_t gpu_driven_scene = 0;//The copies are culled and drawn indirectly on the GPU, with no work per copy on the CPU
 
 typedef struct mesh_t {
     uint32_t vertex_count;
@@ -62,46 +71,6 @@ typedef struct mesh_t {
 
 
 
-void create_compute_pipeline_layout(VkPipelineLayout *pipeline_layout, VkDevice logical_device, VkDescriptorSetLayout layout) {
-    VkPushConstantRange push_constant_range = {
-        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-        .offset = 0,
-        .size = sizeof(compute_push_constants_t)
-    };
-
-    VkPipelineLayoutCreateInfo create_info = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 1,
-        .pSetLayouts = &layout,
-        .pushConstantRangeCount = 1,
-        .pPushConstantRanges = &push_constant_range
-    };
-
-    if(vkCreatePipelineLayout(logical_device, &create_info, NULL, pipeline_layout) != VK_SUCCESS) {
-        error(1, "Failed to create compute pipeline layout");
-    }
-}
-
-void create_compute_pipeline(VkPipeline *compute_pipeline, VkPipelineLayout pipeline_layout, VkDevice logical_device, const char *file_name) {
-    VkShaderModule compute_shader;
-    load_shader_module(&compute_shader, logical_device, file_name);
-    VkPipelineShaderStageCreateInfo shader_stage_create_info = create_shader_stage(compute_shader, VK_SHADER_STAGE_COMPUTE_BIT);
-
-    VkComputePipelineCreateInfo create_info = {
-        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-        .layout = pipeline_layout,
-        .stage = shader_stage_create_info,
-        .basePipelineHandle = VK_NULL_HANDLE,
-        .basePipelineIndex = -1
-    };
-
-    if(vkCreateComputePipelines(logical_device, VK_NULL_HANDLE, 1, &create_info, NULL, compute_pipeline) != VK_SUCCESS) {
-        error(1, "Failed to create compute pipeline");
-    }
-
-    vkDestroyShaderModule(logical_device, compute_shader, NULL);
-}
-
 mesh_t create_cube_mesh() {
     uint32_t vertex_count = 8;
     uint32_t index_count = 36;
@@ -291,128 +260,91 @@ mesh_t create_square_mesh() {
     return mesh;
 }
 
-fractal_data_t initialise_fractal_data(renderer_t *renderer) {
-    uint32_t frames_in_flight = renderer->frame_count;
-
-    image_t *fractal_images = malloc(frames_in_flight*sizeof(image_t));
-    VkImageView *fractal_image_views = malloc(frames_in_flight*sizeof(VkImage));
-
-    VkImageMemoryBarrier *begin_barriers = malloc(frames_in_flight*sizeof(VkImageMemoryBarrier));
-    VkImageMemoryBarrier *end_barriers = malloc(frames_in_flight*sizeof(VkImageMemoryBarrier));
-
-    uint32_t texture_width = 2048, texture_height = 2048;
-    for(uint32_t i = 0; i < frames_in_flight; i++) {
-        fractal_images[i] = create_image(renderer, texture_width, texture_height, 1, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        fractal_image_views[i] = create_image_view(fractal_images[i].image, renderer->logical_device, 1, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT);
-        
-        begin_barriers[i] = (VkImageMemoryBarrier){
-            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .image = fractal_images[i].image,
-            .subresourceRange = (VkImageSubresourceRange){
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .levelCount = 1,
-                .baseMipLevel = 0,
-                .baseArrayLayer = 0,
-                .layerCount = 1
-            },
-            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
-            .dstAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
-            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
-            .pNext = NULL
-        };
-
-        end_barriers[i] = (VkImageMemoryBarrier){
-            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .image = fractal_images[i].image,
-            .subresourceRange = (VkImageSubresourceRange){
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .levelCount = 1,
-                .baseMipLevel = 0,
-                .baseArrayLayer = 0,
-                .layerCount = 1
-            },
-            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
-            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-            .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
-            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            .pNext = NULL
-        };
-    }
+void update_scene(host_buffer_t scene_buffer, double t) {
 
-    VkDescriptorPool descriptor_pool = renderer->global_pool;
+}
 
-    descriptor_layout_builder_t layout_builder = initialise_layout_builder();
-    descriptor_writer_t writer = initialise_writer();
+typedef struct fractal_pass_t {
+    fractal_data_t *fractal_data;
+    compute_push_constants_t push;
+} fractal_pass_t;
+
+/*
+    What the scene pass draws into which swapchain image, refreshed every frame before it is recorded
+*/
+typedef struct scene_pass_t {
+    renderer_t *renderer;
+    VkClearValue *clear_values;
+    uint32_t image_index;
+
+    draw_list_t *draw_list;//Sorted before the pass is recorded
+    VkDescriptorSet global_descriptor;
+    parallel_recorder_t *recorder;//Draws are recorded inline without one
+
+    gpu_scene_t *gpu_scene;//Drawn in place of the draw list when set
+    render_object_t *mesh;//Pipeline, buffers and shared model of the GPU scene's objects
+    transformation_t view_projection;
+
+    double record_time;
+    uint32_t recorded_frames;
+} scene_pass_t;
+
+void record_fractal_pass(VkCommandBuffer command_buffer, void *data, uint32_t frame_index) {
+    fractal_pass_t *pass = data;
+    dispatch_fractal(pass->fractal_data, command_buffer, pass->push, frame_index);
+}
 
-    add_binding(&layout_builder, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
-    VkDescriptorSetLayout fractal_layout = build_layout(&layout_builder, renderer->logical_device);
-    free_layout_builder(&layout_builder);
+void record_scene_pass(VkCommandBuffer command_buffer, void *data, uint32_t frame_index) {
+    scene_pass_t *pass = data;
+    renderer_t *renderer = pass->renderer;
 
-    VkDescriptorSet *fractal_sets = malloc(frames_in_flight*sizeof(VkDescriptorSet));
-    for(uint32_t i = 0; i < frames_in_flight; i++) {
-        allocate_descriptor_set(&fractal_sets[i], renderer->logical_device, descriptor_pool, &fractal_layout, 1);
+    struct timespec record_start;
+    timespec_get(&record_start, TIME_UTC);
 
-        write_image(&writer, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, fractal_image_views[i], VK_IMAGE_LAYOUT_GENERAL);
-        update_set(&writer, renderer->logical_device, fractal_sets[i]);
-        clear_writes(&writer);
+    draw_list_t *draw_list = pass->draw_list;
+    draw_stats_t draw_stats = {0};
+    if(pass->gpu_scene != NULL) {
+        cull_gpu_scene(pass->gpu_scene, command_buffer, pass->mesh->push_constant.model, pass->view_projection, frame_index);
     }
-    free_writer(&writer);
 
-    VkPipeline pipeline;
-    VkPipelineLayout pipeline_layout;
-    
-    create_compute_pipeline_layout(&pipeline_layout, renderer->logical_device, fractal_layout);
-    create_compute_pipeline(&pipeline, pipeline_layout, renderer->logical_device, "bin/shaders/shader_compute.spv");
-
-    fractal_data_t fractal_data = {
-        .pipeline = pipeline,
-        .layout = pipeline_layout,
-        .begin_barriers = begin_barriers,
-        .end_barriers = end_barriers,
-        .texture_width = texture_width,
-        .texture_height = texture_height,
-        .fractal_images = fractal_images,
-        .fractal_image_views = fractal_image_views,
-        .descriptor_layout = fractal_layout,
-        .descriptors = fractal_sets,
-    };
-
-    return fractal_data;
-}
-
-void update_fractal(fractal_data_t *fractal_data, VkCommandBuffer command_buffer, compute_push_constants_t push, uint32_t frame_index) {
-    uint32_t thread_count = 8;
-    
-    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &fractal_data->begin_barriers[frame_index]);
-    
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->pipeline);
-    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, fractal_data->layout, 0, 1, &fractal_data->descriptors[frame_index], 0, NULL);
-    vkCmdPushConstants(command_buffer, fractal_data->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(compute_push_constants_t), &push);
-    vkCmdDispatch(command_buffer, fractal_data->texture_width/thread_count + (fractal_data->texture_width % thread_count != 0), fractal_data->texture_height/thread_count + (fractal_data->texture_height % thread_count != 0), 1);
-    
-    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &fractal_data->end_barriers[frame_index]);
-}
+    if(pass->recorder != NULL && pass->gpu_scene == NULL) {
+        begin_scene_rendering(renderer, command_buffer, pass->image_index, pass->clear_values, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        record_draws_parallel(pass->recorder, renderer, command_buffer, pass->image_index, draw_list->sorted, draw_list->count, pass->global_descriptor, frame_index, &draw_stats);
+    } else {
+        begin_scene_rendering(renderer, command_buffer, pass->image_index, pass->clear_values, VK_SUBPASS_CONTENTS_INLINE);
 
-void update_scene(host_buffer_t scene_buffer, double t) {
+        VkViewport viewport = {
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = renderer->extent.width,
+            .height = renderer->extent.height,
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f
+        };
+        VkRect2D scissor = {
+            .offset = {0, 0},
+            .extent = renderer->extent
+        };
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-}
+        if(pass->gpu_scene != NULL) {
+            draw_gpu_scene(pass->gpu_scene, command_buffer, pass->mesh, pass->global_descriptor, frame_index);
+        } else {
+            record_draws(command_buffer, draw_list->sorted, draw_list->count, pass->global_descriptor, &draw_stats);
+        }
+    }
 
-void destroy_fractal_data(fractal_data_t *fractal_data, VkDevice logical_device) {
-    for(uint32_t i = 0; i < frames_in_flight; i++) {
-        destroy_image(&fractal_data->fractal_images[i], logical_device);
-        vkDestroyImageView(logical_device, fractal_data->fractal_image_views[i], NULL);
+    if(pass->gpu_scene == NULL) {
+        add_draw_stats(draw_list, &draw_stats);
     }
 
-    vkDestroyPipelineLayout(logical_device, fractal_data->layout, NULL);
-    vkDestroyPipeline(logical_device, fractal_data->pipeline, NULL);
-    vkDestroyDescriptorSetLayout(logical_device, fractal_data->descriptor_layout, NULL);
+    struct timespec record_end;
+    timespec_get(&record_end, TIME_UTC);
+    pass->record_time += (double)(record_end.tv_sec - record_start.tv_sec) + 1e-9*(double)(record_end.tv_nsec - record_start.tv_nsec);
+    pass->recorded_frames++;
 
-    free(fractal_data->begin_barriers);
-    free(fractal_data->end_barriers);
-    free(fractal_data->descriptors);
-    free(fractal_data->fractal_images);
-    free(fractal_data->fractal_image_views);
+    end_scene_rendering(renderer, command_buffer, pass->image_index);
 }
 
 void run_fractal(engine_t *engine) {
@@ -433,12 +365,6 @@ void run_fractal(engine_t *engine) {
     VkDescriptorSetLayout material_layout = build_layout(&layout_builder, renderer->logical_device);
     free_layout_builder(&layout_builder);
 
-    material_pipeline_t textured_pipeline = build_textured_mesh_pipeline(renderer->logical_device, renderer->render_pass, &scene_layout, &material_layout, renderer->extent);
-    material_t fractal_material = {
-        .descriptor = material_sets[0],
-        .material_pipeline = &textured_pipeline
-    };
-
     VkDescriptorPool descriptor_pool;
 
     VkDescriptorPoolSize image_pool_size = {
@@ -453,7 +379,7 @@ void run_fractal(engine_t *engine) {
 
     VkDescriptorPoolSize sampler_pool_size = {
         .type = VK_DESCRIPTOR_TYPE_SAMPLER,
-        .descriptorCount = frames_in_flight
+        .descriptorCount = 64
     };
 
     VkDescriptorPoolSize buffer_pool_size = {
@@ -461,10 +387,15 @@ void run_fractal(engine_t *engine) {
         .descriptorCount = 64
     };
 
-    VkDescriptorPoolSize pool_sizes[4] = {image_pool_size, texture_pool_size, sampler_pool_size, buffer_pool_size};
+    VkDescriptorPoolSize storage_pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 64
+    };
 
-    create_descriptor_pool(&descriptor_pool, renderer->logical_device, pool_sizes, 4, 256);
-    create_descriptor_pool(&renderer->global_pool, renderer->logical_device, pool_sizes, 4, 256);
+    VkDescriptorPoolSize pool_sizes[5] = {image_pool_size, texture_pool_size, sampler_pool_size, buffer_pool_size, storage_pool_size};
+
+    create_descriptor_pool(&descriptor_pool, renderer->logical_device, pool_sizes, 5, 256);
+    create_descriptor_pool(&renderer->global_pool, renderer->logical_device, pool_sizes, 5, 256);
 
     for(uint32_t i = 0; i < frames_in_flight; i++) {
         allocate_descriptor_set(&global_sets[i], renderer->logical_device, descriptor_pool, &scene_layout, 1);
@@ -474,11 +405,159 @@ void run_fractal(engine_t *engine) {
     vertex_t vertices[4];
     uint16_t indices[6];
 
-    fractal_data_t fractal_data = initialise_fractal_data(renderer);
+    fractal_data_t fractal_data = {0};
+    if(render_mode != RENDER_MODE_PROCEDURAL) {
+        uint32_t fractal_buffers = render_mode == RENDER_MODE_DEEP ? FRACTAL_DEEP_ORBITS : render_mode == RENDER_MODE_EXPLORE ? FRACTAL_RECOMPUTE_LIST : 0;
+        fractal_data = initialise_fractal_data(renderer, fractal_buffers);
+    }
+    if(render_mode == RENDER_MODE_ANIMATED && fractal_formula != NULL) {
+        use_fractal_formula(&fractal_data, renderer->logical_device, fractal_formula);
+    }
+
+    /*
+        Zoom into the Misiurewicz point c = i of its own Julia set, 9 e-folds deep at zoom_rate e-folds per second
+    */
+    complex float zoom_c = I;
+    float zoom_depth = 9.0f;
+    float zoom_rate = 0.25f;
+    fractal_zoom_t zoom;
+    if(render_mode == RENDER_MODE_ZOOM) {
+        zoom = initialise_fractal_zoom(renderer, &fractal_data, zoom_c, 0.0f, -zoom_depth, 2048, 128);
+    }
+
+    /*
+        Deep zoom into the same point, perturbed around a reference orbit through the centre and the critical orbit
+    */
+    mp_complex_t deep_centre = {mp_from_decimal("0.0"), mp_from_decimal("1.0")};
+    mp_complex_t deep_c = {mp_from_decimal("0.0"), mp_from_decimal("1.0")};
+    float deep_depth = 30.0f;
+    uint32_t deep_iterations = 1 << 17;
+    uint32_t deep_ready = 0;
+    uint64_t deep_skipped = 0;
+    orbit_engine_t orbit_engine;
+    /*
+        Boundary preview of the animated c by inverse iteration, for scrubbing c without paying for d()
+    */
+    density_target_t density_target;
+    iim_preview_t iim_preview;
+    if(render_mode == RENDER_MODE_PREVIEW || render_mode == RENDER_MODE_BUDDHABROT) {
+        density_target = initialise_density_target(renderer, &fractal_data, 1024, 1024);
+    }
+    if(render_mode == RENDER_MODE_PREVIEW) {
+        iim_preview = initialise_iim_preview(renderer, &density_target);
+    }
+
+    /*
+        Buddhabrot over re [-2, 1], im [-1.5, 1.5], refined progressively for as long as the window is open
+    */
+    buddhabrot_t buddhabrot;
+    if(render_mode == RENDER_MODE_BUDDHABROT) {
+        buddhabrot = initialise_buddhabrot(renderer, &density_target);
+    }
+
+    /*
+        Virtual texture of a fixed Julia set, its pages are computed as the camera asks for them
+    */
+    complex float virtual_c = -0.8f + 0.156f*I;
+    virtual_texture_t virtual_texture;
+    tile_cache_t tile_cache;
+    if(render_mode == RENDER_MODE_VIRTUAL) {
+        open_tile_cache(&tile_cache, "bin/tile_cache.idx", "bin/tile_cache.bin");
+        initialise_virtual_texture(&virtual_texture, renderer, &fractal_data, virtual_c, &tile_cache);
+    }
+
+    /*
+        The animated Julia set split between the GPU and a worker per hardware thread
+    */
+    hybrid_renderer_t hybrid;
+    if(render_mode == RENDER_MODE_HYBRID) {
+        initialise_hybrid_renderer(&hybrid, renderer, hardware_thread_count());
+    }
+
+    /*
+        Ray-marched quaternion Julia set, c follows the animated c in its complex plane
+    */
+    quaternion_julia_t quaternion_julia;
+    if(render_mode == RENDER_MODE_QUATERNION) {
+        quaternion_julia = initialise_quaternion_julia(renderer, &fractal_data);
+    }
+
+    /*
+        Pans and zooms over the Julia set of a fixed c, reusing the previous frame wherever it still fits
+    */
+    complex float explore_c = -0.8f + 0.156f*I;
+    reprojection_t reprojection;
+    if(render_mode == RENDER_MODE_EXPLORE) {
+        reprojection = initialise_reprojection(renderer, &fractal_data);
+    }
+
+    if(render_mode == RENDER_MODE_DEEP) {
+        initialise_orbit_engine(&orbit_engine, 4, 5, DEEP_ORBIT_CAPACITY, 1e15, pow(2.0, -24));
+        request_reference_orbits(&orbit_engine, deep_centre, expf(-deep_depth), deep_c);
+    }
 
     mesh_t model = create_donut_mesh(1.25, 1.0, 128, 128);
     //mesh_t model = create_square_mesh();
 
+    /*
+        The copies laid out on the GPU once, every one of them bounded by the sphere around the mesh's origin
+    */
+    uint32_t scene_columns = (uint32_t)ceil(sqrt((double)scene_copies));
+    uint32_t use_gpu_scene = gpu_driven_scene && gpu_scene_supported(renderer->physical_device);
+    if(gpu_driven_scene && !use_gpu_scene) {
+        printf("GPU scene needs drawIndirectFirstInstance and drawIndirectCount, falling back to the draw list\n");
+    }
+
+    gpu_scene_t gpu_scene;
+    if(use_gpu_scene) {
+        float radius = 0.0f;
+        for(uint32_t i = 0; i < model.vertex_count; i++) {
+            vector3_t p = {model.vertices[i].position.x, model.vertices[i].position.y, model.vertices[i].position.z};
+            radius = fmaxf(radius, sqrtf(p.x*p.x + p.y*p.y + p.z*p.z));
+        }
+
+        gpu_object_t *gpu_objects = malloc(scene_copies*sizeof(gpu_object_t));
+        if(gpu_objects == NULL) {
+            error(1, "Failed to allocate scene\n");
+        }
+        for(uint32_t i = 0; i < scene_copies; i++) {
+            vector3_t offset = {4.0f*(float)(i % scene_columns), 4.0f*(float)(i / scene_columns), 0.0f};
+
+            gpu_objects[i] = (gpu_object_t){
+                .model = translation_matrix(offset),
+                .sphere = {0.0f, 0.0f, 0.0f, radius},
+                .index_count = model.index_count,
+                .first_index = 0,
+                .vertex_offset = 0
+            };
+        }
+
+        initialise_gpu_scene(&gpu_scene, renderer, gpu_objects, scene_copies);
+        free(gpu_objects);
+    }
+
+    /*
+        The procedural material evaluates the Julia set per fragment, so it has no material set
+    */
+    material_pipeline_t textured_pipeline;
+    if(use_gpu_scene) {
+        //Set 1 is left unused by the procedural material
+        VkDescriptorSetLayout indirect_layouts[3] = {scene_layout, render_mode == RENDER_MODE_VIRTUAL ? virtual_texture.descriptor_layout : material_layout, gpu_scene.object_layout};
+        const char *fragment_file = render_mode == RENDER_MODE_PROCEDURAL ? "bin/shaders/julia_fragment.spv" : render_mode == RENDER_MODE_VIRTUAL ? "bin/shaders/virtual_fragment.spv" : "bin/shaders/shader_fragment.spv";
+        textured_pipeline = build_indirect_mesh_pipeline(renderer->logical_device, scene_render_target(renderer), 3, indirect_layouts, renderer->extent, fragment_file);
+    } else if(render_mode == RENDER_MODE_PROCEDURAL) {
+        textured_pipeline = build_procedural_mesh_pipeline(renderer->logical_device, scene_render_target(renderer), &scene_layout, renderer->extent);
+    } else if(render_mode == RENDER_MODE_VIRTUAL) {
+        VkDescriptorSetLayout virtual_layouts[2] = {scene_layout, virtual_texture.descriptor_layout};
+        textured_pipeline = build_mesh_pipeline(renderer->logical_device, scene_render_target(renderer), 2, virtual_layouts, renderer->extent, "bin/shaders/virtual_fragment.spv");
+    } else {
+        textured_pipeline = build_textured_mesh_pipeline(renderer->logical_device, scene_render_target(renderer), &scene_layout, &material_layout, renderer->extent);
+    }
+    material_t fractal_material = {
+        .descriptor = VK_NULL_HANDLE,
+        .material_pipeline = &textured_pipeline
+    };
+
     VkCommandBuffer init_command_buffer[2];
     create_primary_command_buffer(init_command_buffer, renderer->logical_device, renderer->command_pool, 2);
 
@@ -498,6 +577,7 @@ void run_fractal(engine_t *engine) {
     scene_data_t scene_data = {
         .view = camera_matrix(eye, object, up),
         .projection = perspective_matrix(M_PI_2, aspect_ratio, 0.01f, 100.0f),
+        .texture_scale = {1.0f, 1.0f}
     };
 
     //scene_data.view = identity_matrix();
@@ -511,12 +591,14 @@ void run_fractal(engine_t *engine) {
     VkSampler sampler = create_linear_sampler(renderer->logical_device);
     descriptor_writer_t writer = initialise_writer();
     for(uint32_t i = 0; i < frames_in_flight; i++) {
-        VkImageView image_view = fractal_data.fractal_image_views[i];
+        if(render_mode != RENDER_MODE_PROCEDURAL) {
+            VkImageView image_view = fractal_data.fractal_image_views[i];
 
-        write_image(&writer, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        write_sampler(&writer, 1, sampler);
-        update_set(&writer, renderer->logical_device, material_sets[i]);
-        clear_writes(&writer);
+            write_image(&writer, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            write_sampler(&writer, 1, sampler);
+            update_set(&writer, renderer->logical_device, material_sets[i]);
+            clear_writes(&writer);
+        }
 
         write_buffer(&writer, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, scene_buffer[i].buffer, sizeof(scene_data_t), 0);
         update_set(&writer, renderer->logical_device, global_sets[i]);
@@ -537,8 +619,69 @@ void run_fractal(engine_t *engine) {
         .material_instance = &fractal_material
     };
 
+    draw_list_t draw_list;
+    initialise_draw_list(&draw_list, use_gpu_scene ? 1 : scene_copies);
+
+    parallel_recorder_t recorder;
+    if(record_threads > 0) {
+        initialise_parallel_recorder(&recorder, renderer, record_threads);
+    }
+
+    scene_pass_t scene_pass = {
+        .renderer = renderer,
+        .draw_list = &draw_list,
+        .recorder = record_threads > 0 ? &recorder : NULL,
+        .gpu_scene = use_gpu_scene ? &gpu_scene : NULL,
+        .mesh = &mesh
+    };
+
+    /*
+        The modes that only dispatch shader.comp run as a graph of the fractal pass and the scene sampling it,
+        which derives the barriers update_fractal otherwise records by hand. Neither pass has an intermediate
+        of its own yet, so nothing is transient and the graph's aliasing goes unused here. The density and the
+        reprojection offsets, the nearest candidates, both carry over from frame to frame.
+    */
+    uint32_t use_frame_graph = render_mode == RENDER_MODE_ANIMATED || render_mode == RENDER_MODE_DEEP;
+    fractal_pass_t fractal_pass = {
+        .fractal_data = &fractal_data
+    };
+    render_graph_t frame_graph;
+    if(use_frame_graph) {
+        initialise_render_graph(&frame_graph, frames_in_flight);
+
+        //Rewritten every frame, so the last frame's contents need not survive
+        uint32_t fractal_image = import_graph_image(&frame_graph, "fractal", VK_IMAGE_ASPECT_COLOR_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+        for(uint32_t i = 0; i < frames_in_flight; i++) {
+            set_graph_image(&frame_graph, fractal_image, fractal_data.fractal_images[i].image, i);
+        }
+
+        uint32_t pass = add_graph_pass(&frame_graph, "fractal", record_fractal_pass, &fractal_pass, 0);
+        use_graph_resource(&frame_graph, pass, fractal_image, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+
+        pass = add_graph_pass(&frame_graph, "scene", record_scene_pass, &scene_pass, GRAPH_PASS_SIDE_EFFECTS);
+        use_graph_resource(&frame_graph, pass, fractal_image, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        compile_render_graph(&frame_graph, renderer);
+        print_render_graph_stats(&frame_graph);
+    }
 
 
+
+    /*
+        Half of a 60 Hz frame for the fractal dispatch
+    */
+    frame_budget_t frame_budget = initialise_frame_budget(0.008);
+
+    float frame_costs[frames_in_flight];
+    for(uint32_t i = 0; i < frames_in_flight; i++) {
+        frame_costs[i] = 1.0f;
+    }
+
+    cost_map_t cost_map = {0};
+    if(render_mode == RENDER_MODE_ANIMATED) {
+        cost_map = load_cost_map("bin/cost_map.bin", 4);
+    }
+
     double t = 0, d_t;
     clock_t time_start = clock();
     frame_t *current_frame;
@@ -550,27 +693,82 @@ void run_fractal(engine_t *engine) {
         .depthStencil = {1.0f, 0.0f}
     };
     VkClearValue clear_values[2] = {clear_color, clear_depth};
+    scene_pass.clear_values = clear_values;
     while(!window_should_close(engine->window)) {
-        window_update();
-
         current_frame = &renderer->frames[frame_index];
         uint32_t image_index = begin_frame(engine, frame_index);
 
+        //Input and the animation time are read only once the frame may start, so they are as fresh as the pacing allows
+        window_update();
+
+        fractal_stats_t stats = {0};
+        if(render_mode == RENDER_MODE_DEEP || (fractal_instrumentation != 0 && render_mode != RENDER_MODE_PROCEDURAL)) {
+            stats = collect_fractal_stats(&fractal_data, frame_index);
+            deep_skipped += skipped_iterations(&stats);
+        }
+        if(render_mode == RENDER_MODE_BUDDHABROT) {
+            collect_buddhabrot_stats(&buddhabrot, frame_index);
+        }
+        if(render_mode == RENDER_MODE_QUATERNION) {
+            collect_quaternion_stats(&quaternion_julia, &fractal_data, renderer->logical_device, frame_index);
+        }
+        if(render_mode == RENDER_MODE_EXPLORE) {
+            collect_reprojection_stats(&reprojection, &fractal_data, renderer->logical_device, frame_index);
+        }
+
         d_t = (double)(clock() - time_start)/CLOCKS_PER_SEC - t;
         t += d_t;
+        uint32_t new_second = (uint64_t)t != (uint64_t)(t - d_t);
+        sample_frame_input(&renderer->pacing, frame_index);
+
+        if(new_second) {
+            print_frame_pacing_stats(&renderer->pacing);
+        }
+
+        if((fractal_instrumentation & FRACTAL_INSTRUMENT_COUNTERS) && new_second) {
+            print_fractal_stats(&stats);
+        }
         double s = 0.125*t;
         double theta = .125*s;
 
+        complex float z = 0.5*((cos(theta) - cos(4.00*theta)*0.5) + (sin(theta) - sin(4.00*theta)*0.5)*I);
+        z *= 1.25f;
+
+        /*
+            Only the animated fractal is budgeted, the zoom strip and the deep path run at full quality.
+            The slot's stored cost belongs to the frame whose dispatch time is read back here.
+        */
+        cost_sample_t prediction = {1.0f, 0.0f};
+        if(render_mode == RENDER_MODE_ANIMATED) {
+            prediction = predict_cost(&cost_map, z);
+            update_frame_budget(&frame_budget, fractal_dispatch_time(&fractal_data, renderer->logical_device, frame_index), frame_costs[frame_index], prediction.cost);
+            frame_costs[frame_index] = prediction.cost;
+        }
+        quality_level_t quality = current_quality(&frame_budget);
+        uint32_t fractal_width = scaled_resolution(&quality, fractal_data.texture_width);
+        uint32_t fractal_height = scaled_resolution(&quality, fractal_data.texture_height);
+
+        if(render_mode == RENDER_MODE_PREVIEW || render_mode == RENDER_MODE_BUDDHABROT) {
+            fractal_width = density_target.width;
+            fractal_height = density_target.height;
+        }
+
+        float texture_scale[2] = {1.0f, 1.0f};
+        if(render_mode != RENDER_MODE_ZOOM && render_mode != RENDER_MODE_PROCEDURAL) {
+            texture_scale[0] = (float)fractal_width/(float)fractal_data.texture_width;
+            texture_scale[1] = (float)fractal_height/(float)fractal_data.texture_height;
+        }
+
         aspect_ratio = (float)renderer->extent.width/(float)renderer->extent.height;
         scene_data = (scene_data_t){
             .view = camera_matrix(eye, object, (vector3_t){0, sin(s), cos(s)}),
             .projection = perspective_matrix(M_PI*(0.5), aspect_ratio, 0.01f, 10.0f),
+            .texture_scale = {texture_scale[0], texture_scale[1]},
+            .julia_c = {crealf(z), cimagf(z)},
+            .julia_iterations = 256
         };
         memcpy(scene_buffer[frame_index].mapped_memory, &scene_data, sizeof(scene_data_t));
 
-
-        complex float z = 0.5*((cos(theta) - cos(4.00*theta)*0.5) + (sin(theta) - sin(4.00*theta)*0.5)*I);
-        z *= 1.25f;
         compute_push_constants_t push = {
             .x_min = -1.f,
             .x_max =  1.f,
@@ -578,51 +776,131 @@ void run_fractal(engine_t *engine) {
             .y_max =  1.f,
             .z = z,
             .t = s,
-            .padding = 0
+            .mode = FRACTAL_MODE_WINDOW,
+            .max_iterations = quality.max_iterations,
+            .bailout = quality.bailout,
+            .width = fractal_width,
+            .height = fractal_height,
+            .interior_check = prediction.interior > COST_MAP_INTERIOR_THRESHOLD,
+            .instrumentation = fractal_instrumentation
         };
 
-        fractal_material.descriptor = material_sets[frame_index];
-        update_fractal(&fractal_data, current_frame->command_buffer, push, frame_index);
+        fractal_material.descriptor = render_mode == RENDER_MODE_PROCEDURAL ? VK_NULL_HANDLE : material_sets[frame_index];
+        if(render_mode == RENDER_MODE_PROCEDURAL) {
+            //Nothing to precompute, the material shades the Julia set directly
+        } else if(render_mode == RENDER_MODE_VIRTUAL) {
+            fractal_material.descriptor = virtual_texture.descriptors[frame_index];
+            update_virtual_texture(&virtual_texture, &fractal_data, current_frame->command_buffer, frame_index);
+        } else if(render_mode == RENDER_MODE_ZOOM) {
+            if(!zoom.strip_ready) {
+                push.z = zoom_c;
+                push.t = 0;
+                render_zoom_strip(&zoom, &fractal_data, current_frame->command_buffer, push);
+            }
 
-        vector3_t axis = {cos(2.0*s)-sin(2.0*s), sin(2.0*s)-cos(2.0*s), cos(2.0*s)};
-        
-        VkRenderPassBeginInfo render_pass_info = {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass = renderer->render_pass,
-            .framebuffer = renderer->framebuffers[image_index],
-            .renderArea = {
-                .offset = {0, 0},
-                .extent = renderer->extent
-            },
-            .clearValueCount = 2,
-            .pClearValues = &clear_values,
-            .pNext = NULL
-        };
+            update_zoom_frame(&zoom, &fractal_data, current_frame->command_buffer, -fmodf(zoom_rate*t, zoom_depth), frame_index);
+        } else if(render_mode == RENDER_MODE_PREVIEW) {
+            render_iim_preview(&iim_preview, &density_target, &fractal_data, current_frame->command_buffer, z, frame_index);
+        } else if(render_mode == RENDER_MODE_BUDDHABROT) {
+            render_buddhabrot(&buddhabrot, &density_target, &fractal_data, current_frame->command_buffer, frame_index);
 
-        vkCmdBeginRenderPass(current_frame->command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+            if(new_second) {
+                print_buddhabrot_stats(&buddhabrot, 1.0);
+            }
+        } else if(render_mode == RENDER_MODE_HYBRID) {
+            render_hybrid_frame(&hybrid, &fractal_data, renderer->logical_device, current_frame->command_buffer, push, frame_index);
 
-        VkViewport viewport = {
-            .x = 0.0f,
-            .y = 0.0f,
-            .width = renderer->extent.width,
-            .height = renderer->extent.height,
-            .minDepth = 0.0f,
-            .maxDepth = 1.0f
-        };
-        VkRect2D scissor = {
-            .offset = {0, 0},
-            .extent = renderer->extent
-        };
-        vkCmdSetViewport(current_frame->command_buffer, 0, 1, &viewport);
-        vkCmdSetScissor(current_frame->command_buffer, 0, 1, &scissor);
+            if(new_second) {
+                print_hybrid_stats(&hybrid);
+            }
+        } else if(render_mode == RENDER_MODE_QUATERNION) {
+            float quaternion_c[4] = {crealf(z), cimagf(z), 0.15f, 0.0f};
+            render_quaternion_julia(&quaternion_julia, &fractal_data, current_frame->command_buffer, quaternion_c, s, fractal_width, fractal_height, frame_index);
+
+            if(new_second) {
+                print_quaternion_stats(&quaternion_julia);
+            }
+        } else if(render_mode == RENDER_MODE_EXPLORE) {
+            complex float centre = 0.4f*(cosf(0.1f*t) + sinf(0.13f*t)*I);
+            float radius = 1.25f*expf(-2.0f*(0.5f - 0.5f*cosf(0.2f*t)));
+
+            push.x_min = crealf(centre) - radius;
+            push.x_max = crealf(centre) + radius;
+            push.y_min = cimagf(centre) - radius;
+            push.y_max = cimagf(centre) + radius;
+            push.z = explore_c;
+            push.t = 0;
+            update_fractal_reprojected(&reprojection, &fractal_data, current_frame->command_buffer, push, frame_index);
+
+            if(new_second) {
+                print_reprojection_stats(&reprojection);
+            }
+        } else if(render_mode == RENDER_MODE_DEEP) {
+            reference_orbit_t orbits[ORBIT_COUNT];
+            if(collect_reference_orbits(&orbit_engine, orbits)) {
+                upload_reference_orbits(&fractal_data, renderer, orbits, &orbit_engine.table);
+                deep_ready = 1;
+            }
+
+            if(deep_ready) {
+                float radius = expf(-fmodf(zoom_rate*t, deep_depth));
+
+                push.x_min = -radius;
+                push.x_max =  radius;
+                push.y_min = -radius;
+                push.y_max =  radius;
+                push.z = zoom_c;
+                push.t = 0;
+                push.mode = FRACTAL_MODE_DEEP;
+                push.max_iterations = deep_iterations;
+            }
+            fractal_pass.push = push;
+
+            if(new_second) {
+                printf("Skipped iterations: %llu\n", (unsigned long long)deep_skipped);
+                deep_skipped = 0;
+            }
+        } else {
+            fractal_pass.push = push;
+        }
+
+        vector3_t axis = {cos(2.0*s)-sin(2.0*s), sin(2.0*s)-cos(2.0*s), cos(2.0*s)};
 
         mesh.push_constant.model = transform(rotation_matrix((vector3_t){0.0, 0.0, 1.0}, 0.5*s), rotation_matrix((vector3_t){0.0, 1.0, 0.0}, M_PI*0.2));
         mesh.push_constant.t = s;
         //mesh.push_constant.model = identity_matrix();
 
-        draw_mesh(current_frame, &mesh, global_sets[frame_index]);
+        reset_draw_list(&draw_list);
+        for(uint32_t i = 0; i < scene_copies && !use_gpu_scene; i++) {
+            vector3_t offset = {4.0f*(float)(i % scene_columns), 4.0f*(float)(i / scene_columns), 0.0f};
+            vector3_t to_eye = {offset.x - eye.x, offset.y - eye.y, offset.z - eye.z};
+
+            render_object_t copy = mesh;
+            copy.push_constant.model = transform(translation_matrix(offset), mesh.push_constant.model);
+            push_draw(&draw_list, &copy, sqrtf(to_eye.x*to_eye.x + to_eye.y*to_eye.y + to_eye.z*to_eye.z));
+        }
+        sort_draw_list(&draw_list);
+        scene_pass.view_projection = transform(scene_data.projection, scene_data.view);//As the shaders compose them
 
-        vkCmdEndRenderPass(current_frame->command_buffer);
+        scene_pass.image_index = image_index;
+        scene_pass.global_descriptor = global_sets[frame_index];
+
+        if(use_frame_graph) {
+            execute_render_graph(&frame_graph, current_frame->command_buffer, frame_index);
+        } else {
+            record_scene_pass(current_frame->command_buffer, &scene_pass, frame_index);
+        }
+
+        if(new_second && scene_copies > 1) {
+            printf("Recording: %.3f ms/frame for %u draws on %u threads\n", 1e3*scene_pass.record_time/(double)scene_pass.recorded_frames, scene_copies, record_threads > 0 ? record_threads : 1);
+            scene_pass.record_time = 0.0;
+            scene_pass.recorded_frames = 0;
+            print_draw_list_stats(&draw_list);
+        }
+
+        if(render_mode == RENDER_MODE_VIRTUAL) {
+            finish_virtual_texture(&virtual_texture, current_frame->command_buffer, frame_index);
+        }
 
         end_frame(engine, frame_index, image_index);
         frame_index = (frame_index + 1) % frames_in_flight;
@@ -630,6 +908,17 @@ void run_fractal(engine_t *engine) {
 
     vkDeviceWaitIdle(renderer->logical_device);
 
+    if(use_frame_graph) {
+        destroy_render_graph(&frame_graph, renderer->logical_device);
+    }
+    if(record_threads > 0) {
+        destroy_parallel_recorder(&recorder, renderer->logical_device);
+    }
+    destroy_draw_list(&draw_list);
+    if(use_gpu_scene) {
+        destroy_gpu_scene(&gpu_scene, renderer->logical_device);
+    }
+
     destroy_buffer(&vertex_buffer, renderer->logical_device);
     destroy_buffer(&index_buffer, renderer->logical_device);
     for(uint32_t i = 0; i < renderer->frame_count; i++) {
@@ -643,7 +932,40 @@ void run_fractal(engine_t *engine) {
     vkDestroyDescriptorPool(renderer->logical_device, renderer->global_pool, NULL);
     vkDestroyDescriptorPool(renderer->logical_device, descriptor_pool, NULL);
     vkDestroySampler(renderer->logical_device, sampler, NULL);
-    destroy_fractal_data(&fractal_data, renderer->logical_device);
+    if(render_mode == RENDER_MODE_ZOOM) {
+        destroy_fractal_zoom(&zoom, renderer->logical_device);
+    }
+    if(render_mode == RENDER_MODE_DEEP) {
+        destroy_orbit_engine(&orbit_engine);
+    }
+    if(render_mode == RENDER_MODE_PREVIEW) {
+        destroy_iim_preview(&iim_preview, renderer->logical_device);
+    }
+    if(render_mode == RENDER_MODE_BUDDHABROT) {
+        destroy_buddhabrot(&buddhabrot, renderer->logical_device);
+    }
+    if(render_mode == RENDER_MODE_HYBRID) {
+        destroy_hybrid_renderer(&hybrid, renderer->logical_device);
+    }
+    if(render_mode == RENDER_MODE_QUATERNION) {
+        destroy_quaternion_julia(&quaternion_julia, renderer->logical_device);
+    }
+    if(render_mode == RENDER_MODE_EXPLORE) {
+        destroy_reprojection(&reprojection, renderer->logical_device);
+    }
+    if(render_mode == RENDER_MODE_PREVIEW || render_mode == RENDER_MODE_BUDDHABROT) {
+        destroy_density_target(&density_target, renderer->logical_device);
+    }
+    if(render_mode == RENDER_MODE_VIRTUAL) {
+        destroy_virtual_texture(&virtual_texture, renderer->logical_device);
+        close_tile_cache(&tile_cache);
+    }
+    if(render_mode == RENDER_MODE_ANIMATED) {
+        destroy_cost_map(&cost_map);
+    }
+    if(render_mode != RENDER_MODE_PROCEDURAL) {
+        destroy_fractal_data(&fractal_data, renderer->logical_device);
+    }
 }
 
 int main(int argc, const char * argv[]) {
@@ -1,8 +1,35 @@
 #include "material.h"
 
-material_pipeline_t build_textured_mesh_pipeline(VkDevice logical_device, VkRenderPass render_pass, VkDescriptorSetLayout *scene_layout, VkDescriptorSetLayout *material_layout, VkExtent2D extent) {
-    material_pipeline_t material_pipeline;
+material_pipeline_t build_textured_mesh_pipeline(VkDevice logical_device, render_target_t target, VkDescriptorSetLayout *scene_layout, VkDescriptorSetLayout *material_layout, VkExtent2D extent) {
     VkDescriptorSetLayout layouts[2] = {*scene_layout, *material_layout};
+    return build_mesh_pipeline(logical_device, target, 2, layouts, extent, "bin/shaders/shader_fragment.spv");
+}
+
+/*
+    The Julia set is evaluated per fragment from the scene data, so the pipeline only needs the scene set
+*/
+material_pipeline_t build_procedural_mesh_pipeline(VkDevice logical_device, render_target_t target, VkDescriptorSetLayout *scene_layout, VkExtent2D extent) {
+    return build_mesh_pipeline(logical_device, target, 1, scene_layout, extent, "bin/shaders/julia_fragment.spv");
+}
+
+material_pipeline_t build_mesh_pipeline(VkDevice logical_device, render_target_t target, uint32_t layout_count, VkDescriptorSetLayout *layouts, VkExtent2D extent, const char *fragment_file) {
+    return build_material_pipeline(logical_device, target, layout_count, layouts, extent, "bin/shaders/shader_vertex.spv", fragment_file);
+}
+
+/*
+    For meshes drawn from a GPU scene, the objects' models are read from set 2, after the scene and
+    material sets, and the push constants carry the model every object shares
+*/
+material_pipeline_t build_indirect_mesh_pipeline(VkDevice logical_device, render_target_t target, uint32_t layout_count, VkDescriptorSetLayout *layouts, VkExtent2D extent, const char *fragment_file) {
+    if(layout_count != 3) {
+        error(1, "Indirect mesh pipelines take the scene, material and object set layouts\n");
+    }
+
+    return build_material_pipeline(logical_device, target, layout_count, layouts, extent, "bin/shaders/indirect_vertex.spv", fragment_file);
+}
+
+material_pipeline_t build_material_pipeline(VkDevice logical_device, render_target_t target, uint32_t layout_count, VkDescriptorSetLayout *layouts, VkExtent2D extent, const char *vertex_file, const char *fragment_file) {
+    material_pipeline_t material_pipeline;
 
     VkPushConstantRange push_constant_range = {
         .offset = 0,
@@ -12,7 +39,7 @@ material_pipeline_t build_textured_mesh_pipeline(VkDevice logical_device, VkRend
 
     VkPipelineLayoutCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 2,
+        .setLayoutCount = layout_count,
         .pSetLayouts = layouts,
         .pushConstantRangeCount = 1,
         .pPushConstantRanges = &push_constant_range
@@ -24,8 +51,8 @@ material_pipeline_t build_textured_mesh_pipeline(VkDevice logical_device, VkRend
 
     VkShaderModule vertex_shader;
     VkShaderModule fragment_shader;
-    load_shader_module(&vertex_shader, logical_device, "bin/shaders/shader_vertex.spv");
-    load_shader_module(&fragment_shader, logical_device, "bin/shaders/shader_fragment.spv");
+    load_shader_module(&vertex_shader, logical_device, vertex_file);
+    load_shader_module(&fragment_shader, logical_device, fragment_file);
 
     uint32_t stage_count = 2;
     VkPipelineShaderStageCreateInfo vert_shader_stage_info = {
@@ -123,7 +150,7 @@ material_pipeline_t build_textured_mesh_pipeline(VkDevice logical_device, VkRend
     details.viewport.scissorCount = 1;
     details.viewport.pScissors = &scissor;
 
-    material_pipeline.pipeline = create_graphics_pipeline(logical_device, material_pipeline.layout, render_pass, &details);
+    material_pipeline.pipeline = create_graphics_pipeline(logical_device, material_pipeline.layout, target, &details);
 
     vkDestroyShaderModule(logical_device, vertex_shader, NULL);
     vkDestroyShaderModule(logical_device, fragment_shader, NULL);
@@ -0,0 +1,152 @@
+#include "multiprecision.h"
+
+mp_t mp_zero() {
+    mp_t x;
+    memset(x.limbs, 0, sizeof(x.limbs));
+    return x;
+}
+
+uint32_t mp_is_negative(mp_t *x) {
+    return x->limbs[MP_LIMBS - 1] >> 31;
+}
+
+mp_t mp_negate(mp_t *x) {
+    mp_t result;
+    uint64_t carry = 1;
+
+    for(uint32_t i = 0; i < MP_LIMBS; i++) {
+        carry += (uint32_t)~x->limbs[i];
+        result.limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+
+    return result;
+}
+
+mp_t mp_add(mp_t *a, mp_t *b) {
+    mp_t result;
+    uint64_t carry = 0;
+
+    for(uint32_t i = 0; i < MP_LIMBS; i++) {
+        carry += (uint64_t)a->limbs[i] + b->limbs[i];
+        result.limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+
+    return result;
+}
+
+mp_t mp_sub(mp_t *a, mp_t *b) {
+    mp_t negative_b = mp_negate(b);
+    return mp_add(a, &negative_b);
+}
+
+/*
+    Exact for |x| < 2^31, every bit of the double lands in the fraction limbs
+*/
+mp_t mp_from_double(double x) {
+    mp_t result = mp_zero();
+    double magnitude = fabs(x);
+    double integer_part = floor(magnitude);
+    double fraction = magnitude - integer_part;
+
+    result.limbs[MP_LIMBS - 1] = (uint32_t)integer_part;
+    for(int32_t i = MP_FRACTION_LIMBS - 1; i >= 0 && fraction > 0; i--) {
+        fraction *= 4294967296.0;
+        double limb = floor(fraction);
+        result.limbs[i] = (uint32_t)limb;
+        fraction -= limb;
+    }
+
+    return x < 0 ? mp_negate(&result) : result;
+}
+
+double mp_to_double(mp_t *x) {
+    uint32_t negative = mp_is_negative(x);
+    mp_t magnitude = negative ? mp_negate(x) : *x;
+
+    double result = 0;
+    double scale = 1;
+    for(int32_t i = MP_LIMBS - 1; i >= MP_LIMBS - 4; i--) {
+        result += scale*(double)magnitude.limbs[i];
+        scale *= 1.0/4294967296.0;
+    }
+
+    return negative ? -result : result;
+}
+
+/*
+    Digits after the decimal point are folded in from the last one, value = (digit + value)/10,
+    so the fraction is exact to the last limb however many digits are given
+*/
+mp_t mp_from_decimal(const char *string) {
+    mp_t result = mp_zero();
+    uint32_t negative = 0;
+    uint32_t integer_part = 0;
+
+    while(*string == ' ' || *string == '+' || *string == '-') {
+        negative ^= *string == '-';
+        string++;
+    }
+
+    while(*string >= '0' && *string <= '9') {
+        integer_part = 10*integer_part + (uint32_t)(*string - '0');
+        string++;
+    }
+
+    if(*string == '.') {
+        const char *first = ++string;
+        while(*string >= '0' && *string <= '9') {
+            string++;
+        }
+
+        for(const char *digit = string - 1; digit >= first; digit--) {
+            uint64_t remainder = (uint64_t)(*digit - '0');
+
+            for(int32_t i = MP_FRACTION_LIMBS - 1; i >= 0; i--) {
+                uint64_t value = remainder << 32 | result.limbs[i];
+                result.limbs[i] = (uint32_t)(value/10);
+                remainder = value % 10;
+            }
+        }
+    }
+
+    result.limbs[MP_LIMBS - 1] = integer_part;
+    return negative ? mp_negate(&result) : result;
+}
+
+/*
+    Schoolbook product of the magnitudes. The low and high halves of each partial product go to separate
+    64-bit column sums, which cannot overflow for MP_LIMBS < 2^32, so the inner loop has no carry chain.
+*/
+mp_t mp_mul(mp_t *a, mp_t *b) {
+    uint32_t negative = mp_is_negative(a) ^ mp_is_negative(b);
+    mp_t x = mp_is_negative(a) ? mp_negate(a) : *a;
+    mp_t y = mp_is_negative(b) ? mp_negate(b) : *b;
+
+    uint64_t low[2*MP_LIMBS] = {0};
+    uint64_t high[2*MP_LIMBS + 1] = {0};
+
+    for(uint32_t i = 0; i < MP_LIMBS; i++) {
+        uint64_t x_i = x.limbs[i];
+
+        for(uint32_t j = 0; j < MP_LIMBS; j++) {
+            uint64_t product = x_i*y.limbs[j];
+            low[i + j] += product & 0xffffffff;
+            high[i + j + 1] += product >> 32;
+        }
+    }
+
+    mp_t result;
+    uint64_t carry = 0;
+    for(uint32_t k = 0; k < MP_FRACTION_LIMBS + MP_LIMBS; k++) {
+        carry += low[k] + high[k];
+
+        if(k >= MP_FRACTION_LIMBS) {
+            result.limbs[k - MP_FRACTION_LIMBS] = (uint32_t)carry;
+        }
+        carry >>= 32;
+    }
+
+    return negative ? mp_negate(&result) : result;
+}
@@ -0,0 +1,164 @@
+#include "orbit_engine.h"
+#include "vulkan_utils.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+    z -> z^2 + c with re' = re^2 - im^2 + c_re and im' = 2*re*im + c_im, three products per iteration
+*/
+uint32_t compute_mp_reference_orbit(reference_orbit_t *orbit, mp_complex_t z_0, mp_complex_t c, double bailout) {
+    mp_complex_t z = z_0;
+    bailout = fmin(bailout, MP_ORBIT_BAILOUT);
+    uint32_t i;
+
+    for(i = 0; i < orbit->capacity; i++) {
+        double re = mp_to_double(&z.re);
+        double im = mp_to_double(&z.im);
+
+        orbit->points[2*i] = (float)re;
+        orbit->points[2*i + 1] = (float)im;
+
+        if(re*re + im*im > bailout) {
+            i++;
+            break;
+        }
+
+        mp_t re_squared = mp_mul(&z.re, &z.re);
+        mp_t im_squared = mp_mul(&z.im, &z.im);
+        mp_t cross = mp_mul(&z.re, &z.im);
+
+        mp_t difference = mp_sub(&re_squared, &im_squared);
+        mp_t twice_cross = mp_add(&cross, &cross);
+
+        z.re = mp_add(&difference, &c.re);
+        z.im = mp_add(&twice_cross, &c.im);
+    }
+
+    orbit->length = i;
+    return i;
+}
+
+void finish_reference_orbits(orbit_engine_t *engine) {
+    uint32_t best = 0;
+    for(uint32_t i = 1; i < engine->candidate_count; i++) {
+        if(engine->tasks[i].orbit.length > engine->tasks[best].orbit.length) {
+            best = i;
+        }
+    }
+    engine->best = best;
+
+    clear_bla_table(&engine->table);
+    build_bla_levels(&engine->table, ORBIT_CENTRE, &engine->tasks[best].orbit, engine->epsilon);
+    build_bla_levels(&engine->table, ORBIT_CRITICAL, &engine->tasks[engine->candidate_count].orbit, engine->epsilon);
+
+    atomic_store(&engine->ready, 1);
+}
+
+void orbit_task(void *argument) {
+    orbit_task_t *task = argument;
+    orbit_engine_t *engine = task->engine;
+
+    compute_mp_reference_orbit(&task->orbit, task->z_0, engine->c, engine->bailout);
+
+    if(atomic_fetch_sub(&engine->pending, 1) == 1) {
+        finish_reference_orbits(engine);
+    }
+}
+
+void initialise_orbit_engine(orbit_engine_t *engine, uint32_t thread_count, uint32_t candidate_count, uint32_t orbit_capacity, double bailout, double epsilon) {
+    engine->candidate_count = candidate_count;
+    engine->tasks = malloc((candidate_count + 1)*sizeof(orbit_task_t));
+
+    if(engine->tasks == NULL) {
+        error(1, "Failed to allocate orbit tasks\n");
+    }
+
+    for(uint32_t i = 0; i < candidate_count + 1; i++) {
+        engine->tasks[i] = (orbit_task_t){
+            .engine = engine,
+            .z_0 = {mp_zero(), mp_zero()},
+            .orbit = create_reference_orbit(orbit_capacity)
+        };
+    }
+
+    engine->best = 0;
+    engine->c = (mp_complex_t){mp_zero(), mp_zero()};
+    engine->bailout = bailout;
+    engine->epsilon = epsilon;
+    engine->table = create_bla_table(orbit_capacity);
+
+    atomic_init(&engine->pending, 0);
+    atomic_init(&engine->ready, 0);
+
+    initialise_thread_pool(&engine->pool, thread_count, candidate_count + 1);
+}
+
+/*
+    Candidate 0 is the centre itself, the rest lie on a circle of half the view radius.
+    Returns 0 without doing anything while a previous request is still running.
+*/
+uint32_t request_reference_orbits(orbit_engine_t *engine, mp_complex_t centre, double radius, mp_complex_t c) {
+    if(atomic_load(&engine->pending) > 0) {
+        return 0;
+    }
+
+    engine->c = c;
+    atomic_store(&engine->ready, 0);
+    atomic_store(&engine->pending, engine->candidate_count + 1);
+
+    for(uint32_t i = 0; i < engine->candidate_count; i++) {
+        orbit_task_t *task = &engine->tasks[i];
+        double offset[2] = {0, 0};
+
+        if(i > 0) {
+            double theta = 2.0*M_PI*(double)(i - 1)/(double)(engine->candidate_count - 1);
+            offset[0] = 0.5*radius*cos(theta);
+            offset[1] = 0.5*radius*sin(theta);
+        }
+
+        mp_t offset_re = mp_from_double(offset[0]);
+        mp_t offset_im = mp_from_double(offset[1]);
+
+        task->orbit.offset[0] = offset[0];
+        task->orbit.offset[1] = offset[1];
+        task->z_0.re = mp_add(&centre.re, &offset_re);
+        task->z_0.im = mp_add(&centre.im, &offset_im);
+    }
+
+    orbit_task_t *critical = &engine->tasks[engine->candidate_count];
+    critical->z_0 = (mp_complex_t){mp_zero(), mp_zero()};
+
+    for(uint32_t i = 0; i < engine->candidate_count + 1; i++) {
+        submit_task(&engine->pool, orbit_task, &engine->tasks[i]);
+    }
+
+    return 1;
+}
+
+/*
+    Returns 1 once per finished request. The orbits and engine->table stay valid until the next request.
+*/
+uint32_t collect_reference_orbits(orbit_engine_t *engine, reference_orbit_t orbits[ORBIT_COUNT]) {
+    if(!atomic_exchange(&engine->ready, 0)) {
+        return 0;
+    }
+
+    orbits[ORBIT_CENTRE] = engine->tasks[engine->best].orbit;
+    orbits[ORBIT_CRITICAL] = engine->tasks[engine->candidate_count].orbit;
+
+    return 1;
+}
+
+void destroy_orbit_engine(orbit_engine_t *engine) {
+    wait_for_tasks(&engine->pool);
+    destroy_thread_pool(&engine->pool);
+
+    for(uint32_t i = 0; i < engine->candidate_count + 1; i++) {
+        destroy_reference_orbit(&engine->tasks[i].orbit);
+    }
+
+    destroy_bla_table(&engine->table);
+    free(engine->tasks);
+}
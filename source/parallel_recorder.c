@@ -0,0 +1,116 @@
+#include "parallel_recorder.h"
+
+void initialise_parallel_recorder(parallel_recorder_t *recorder, renderer_t *renderer, uint32_t thread_count) {
+    uint32_t allocator_count = renderer->frame_count*thread_count;
+
+    recorder->thread_count = thread_count;
+    recorder->frame_count = renderer->frame_count;
+    initialise_thread_pool(&recorder->pool, thread_count, thread_count);
+
+    recorder->command_allocators = malloc(allocator_count*sizeof(command_allocator_t));
+    recorder->command_buffers = malloc(thread_count*sizeof(VkCommandBuffer));
+    recorder->jobs = malloc(thread_count*sizeof(recording_job_t));
+
+    if(recorder->command_allocators == NULL || recorder->command_buffers == NULL || recorder->jobs == NULL) {
+        error(1, "Failed to allocate parallel recorder\n");
+    }
+
+    for(uint32_t i = 0; i < allocator_count; i++) {
+        create_command_allocator(&recorder->command_allocators[i], renderer->logical_device, renderer->graphics_family);
+    }
+}
+
+void record_job(void *argument) {
+    recording_job_t *job = argument;
+
+    if(job->render_pass != VK_NULL_HANDLE) {
+        begin_secondary_command_buffer(job->command_buffer, job->render_pass, 0, job->framebuffer);
+    } else {
+        begin_secondary_rendering_buffer(job->command_buffer, job->color_format, job->depth_format);
+    }
+
+    //Dynamic state is not inherited from the primary
+    vkCmdSetViewport(job->command_buffer, 0, 1, &job->viewport);
+    vkCmdSetScissor(job->command_buffer, 0, 1, &job->scissor);
+
+    //State is not inherited either, so every buffer binds from scratch
+    record_draws(job->command_buffer, job->objects, job->object_count, job->global_descriptor, &job->stats);
+
+    end_command_buffer(job->command_buffer);
+}
+
+/*
+    Must be called after the frame has been waited for and inside begin_scene_rendering for secondary
+    buffers. Objects are split into contiguous runs so the draws execute in the order they were given.
+    The jobs' draw counts are added to stats.
+*/
+void record_draws_parallel(parallel_recorder_t *recorder, renderer_t *renderer, VkCommandBuffer command_buffer, uint32_t image_index, render_object_t *objects, uint32_t object_count, VkDescriptorSet global_descriptor, uint32_t frame_index, draw_stats_t *stats) {
+    VkDevice logical_device = renderer->logical_device;
+    VkExtent2D extent = renderer->extent;
+    command_allocator_t *command_allocators = &recorder->command_allocators[frame_index*recorder->thread_count];
+    VkCommandBuffer *command_buffers = recorder->command_buffers;
+
+    uint32_t job_count = object_count/RECORDER_MIN_OBJECTS;
+    job_count = bound(job_count, 1, recorder->thread_count);
+
+    VkViewport viewport = {
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = extent.width,
+        .height = extent.height,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f
+    };
+    VkRect2D scissor = {
+        .offset = {0, 0},
+        .extent = extent
+    };
+
+    uint32_t first = 0;
+    for(uint32_t i = 0; i < job_count; i++) {
+        uint32_t count = object_count/job_count + (i < object_count % job_count);
+
+        reset_command_allocator(&command_allocators[i], logical_device);
+        command_buffers[i] = allocate_secondary_buffer(&command_allocators[i], logical_device);
+
+        recorder->jobs[i] = (recording_job_t){
+            .recorder = recorder,
+            .command_buffer = command_buffers[i],
+            .objects = objects + first,
+            .object_count = count,
+            .global_descriptor = global_descriptor,
+            .render_pass = renderer->render_pass,
+            .framebuffer = scene_framebuffer(renderer, image_index),
+            .color_format = renderer->swapchain_image_format,
+            .depth_format = renderer->depth.format,
+            .viewport = viewport,
+            .scissor = scissor,
+            .stats = {0}
+        };
+        submit_task(&recorder->pool, record_job, &recorder->jobs[i]);
+
+        first += count;
+    }
+
+    wait_for_tasks(&recorder->pool);
+    vkCmdExecuteCommands(command_buffer, job_count, command_buffers);
+
+    for(uint32_t i = 0; i < job_count; i++) {
+        stats->draws += recorder->jobs[i].stats.draws;
+        stats->binds += recorder->jobs[i].stats.binds;
+        stats->binds_saved += recorder->jobs[i].stats.binds_saved;
+    }
+}
+
+void destroy_parallel_recorder(parallel_recorder_t *recorder, VkDevice logical_device) {
+    wait_for_tasks(&recorder->pool);
+    destroy_thread_pool(&recorder->pool);
+
+    for(uint32_t i = 0; i < recorder->frame_count*recorder->thread_count; i++) {
+        destroy_command_allocator(&recorder->command_allocators[i], logical_device);
+    }
+
+    free(recorder->command_allocators);
+    free(recorder->command_buffers);
+    free(recorder->jobs);
+}
@@ -0,0 +1,589 @@
+#include "render_graph.h"
+
+#define GRAPH_WRITE_ACCESS (VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT)
+
+void initialise_render_graph(render_graph_t *graph, uint32_t frame_count) {
+    memset(graph, 0, sizeof(render_graph_t));
+    graph->frame_count = frame_count;
+}
+
+static graph_state_t initial_state(VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout) {
+    graph_state_t state = {
+        .layout = layout
+    };
+
+    if(access & GRAPH_WRITE_ACCESS) {
+        state.write_stages = stages;
+        state.write_access = access & GRAPH_WRITE_ACCESS;
+    } else {
+        state.read_stages = stages;
+    }
+
+    return state;
+}
+
+static uint32_t add_graph_resource(render_graph_t *graph, graph_resource_t resource) {
+    if(graph->compiled || graph->resource_count == GRAPH_MAX_RESOURCES) {
+        error(1, "Failed to add render graph resource\n");
+    }
+
+    if(resource.type == GRAPH_RESOURCE_IMAGE) {
+        resource.images = calloc(graph->frame_count, sizeof(VkImage));
+        resource.image_views = calloc(graph->frame_count, sizeof(VkImageView));
+
+        if(resource.images == NULL || resource.image_views == NULL) {
+            error(1, "Failed to allocate render graph resource\n");
+        }
+    } else {
+        resource.buffers = calloc(graph->frame_count, sizeof(VkBuffer));
+
+        if(resource.buffers == NULL) {
+            error(1, "Failed to allocate render graph resource\n");
+        }
+    }
+
+    resource.first_pass = ~0u;
+    resource.last_pass = 0;
+
+    graph->resources[graph->resource_count] = resource;
+    return graph->resource_count++;
+}
+
+/*
+    stages, access and layout describe the last use of the resource before the graph, the layout may be
+    VK_IMAGE_LAYOUT_UNDEFINED when its contents do not need to survive into the frame
+*/
+uint32_t import_graph_image(render_graph_t *graph, const char *name, VkImageAspectFlags aspect, VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout) {
+    graph_resource_t resource = {
+        .name = name,
+        .type = GRAPH_RESOURCE_IMAGE,
+        .aspect = aspect,
+        .initial = initial_state(stages, access, layout)
+    };
+
+    return add_graph_resource(graph, resource);
+}
+
+uint32_t import_graph_buffer(render_graph_t *graph, const char *name, VkPipelineStageFlags2 stages, VkAccessFlags2 access) {
+    graph_resource_t resource = {
+        .name = name,
+        .type = GRAPH_RESOURCE_BUFFER,
+        .initial = initial_state(stages, access, VK_IMAGE_LAYOUT_UNDEFINED)
+    };
+
+    return add_graph_resource(graph, resource);
+}
+
+uint32_t create_graph_image(render_graph_t *graph, const char *name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect) {
+    graph_resource_t resource = {
+        .name = name,
+        .type = GRAPH_RESOURCE_IMAGE,
+        .transient = 1,
+        .aspect = aspect,
+        .width = width,
+        .height = height,
+        .format = format,
+        .image_usage = usage,
+        .initial = initial_state(0, 0, VK_IMAGE_LAYOUT_UNDEFINED)
+    };
+
+    return add_graph_resource(graph, resource);
+}
+
+uint32_t create_graph_buffer(render_graph_t *graph, const char *name, VkDeviceSize size, VkBufferUsageFlags usage) {
+    graph_resource_t resource = {
+        .name = name,
+        .type = GRAPH_RESOURCE_BUFFER,
+        .transient = 1,
+        .size = size,
+        .buffer_usage = usage,
+        .initial = initial_state(0, 0, VK_IMAGE_LAYOUT_UNDEFINED)
+    };
+
+    return add_graph_resource(graph, resource);
+}
+
+void export_graph_resource(render_graph_t *graph, uint32_t resource) {
+    graph->resources[resource].exported = 1;
+}
+
+/*
+    Passes execute in the order they are added, record is called with data between the pass's barriers and the next pass's
+*/
+uint32_t add_graph_pass(render_graph_t *graph, const char *name, graph_record_t record, void *data, uint32_t flags) {
+    if(graph->compiled || graph->pass_count == GRAPH_MAX_PASSES) {
+        error(1, "Failed to add render graph pass\n");
+    }
+
+    graph->passes[graph->pass_count] = (graph_pass_t){
+        .name = name,
+        .record = record,
+        .data = data,
+        .flags = flags,
+        .first_access = graph->access_count
+    };
+
+    return graph->pass_count++;
+}
+
+/*
+    Declares a use of resource by the pass added last. Uses of the same resource by one pass are merged and must agree on the layout.
+*/
+void use_graph_resource(render_graph_t *graph, uint32_t pass, uint32_t resource, VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout) {
+    graph_pass_t *graph_pass = &graph->passes[pass];
+
+    if(graph->compiled || pass != graph->pass_count - 1) {
+        error(1, "Render graph resources must be used by the pass added last\n");
+    }
+
+    if(graph->resources[resource].type == GRAPH_RESOURCE_BUFFER) {
+        layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    for(uint32_t i = graph_pass->first_access; i < graph_pass->first_access + graph_pass->access_count; i++) {
+        if(graph->accesses[i].resource == resource) {
+            if(graph->accesses[i].layout != layout) {
+                error(1, "Render graph pass uses an image in two layouts\n");
+            }
+
+            graph->accesses[i].stages |= stages;
+            graph->accesses[i].access |= access;
+            return;
+        }
+    }
+
+    if(graph->access_count == GRAPH_MAX_ACCESSES) {
+        error(1, "Failed to add render graph access\n");
+    }
+
+    graph->accesses[graph->access_count++] = (graph_access_t){
+        .resource = resource,
+        .stages = stages,
+        .access = access,
+        .layout = layout
+    };
+    graph_pass->access_count++;
+}
+
+/*
+    Walks the passes backwards from the exported resources. A pass is kept if it has side effects or writes
+    something a kept pass or the caller reads, and then everything it reads is needed in turn.
+*/
+static void cull_passes(render_graph_t *graph) {
+    uint32_t needed[GRAPH_MAX_RESOURCES];
+
+    for(uint32_t i = 0; i < graph->resource_count; i++) {
+        needed[i] = graph->resources[i].exported;
+    }
+
+    for(uint32_t i = graph->pass_count; i-- > 0;) {
+        graph_pass_t *pass = &graph->passes[i];
+        uint32_t live = pass->flags & GRAPH_PASS_SIDE_EFFECTS;
+
+        for(uint32_t j = pass->first_access; j < pass->first_access + pass->access_count; j++) {
+            graph_access_t *access = &graph->accesses[j];
+            live |= (access->access & GRAPH_WRITE_ACCESS) && needed[access->resource];
+        }
+
+        pass->culled = !live;
+        if(pass->culled) {
+            graph->stats.culled_passes++;
+            continue;
+        }
+
+        for(uint32_t j = pass->first_access; j < pass->first_access + pass->access_count; j++) {
+            graph_access_t *access = &graph->accesses[j];
+
+            if((access->access & ~GRAPH_WRITE_ACCESS) || access->access == 0) {
+                needed[access->resource] = 1;
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < graph->pass_count; i++) {
+        graph_pass_t *pass = &graph->passes[i];
+
+        for(uint32_t j = pass->first_access; j < pass->first_access + pass->access_count && !pass->culled; j++) {
+            graph_resource_t *resource = &graph->resources[graph->accesses[j].resource];
+
+            resource->first_pass = resource->first_pass < i ? resource->first_pass : i;
+            resource->last_pass = i;
+        }
+    }
+}
+
+static VkDeviceSize align_offset(VkDeviceSize offset, VkDeviceSize alignment) {
+    return (offset + alignment - 1)/alignment*alignment;
+}
+
+static uint32_t lifetimes_overlap(graph_resource_t *a, graph_resource_t *b) {
+    return a->first_pass <= b->last_pass && b->first_pass <= a->last_pass;
+}
+
+static uint32_t memory_overlaps(graph_resource_t *a, graph_resource_t *b) {
+    return a->offset < b->offset + b->requirements.size && b->offset < a->offset + a->requirements.size;
+}
+
+//Whether transient order[index] at its current offset is clear of every transient placed before it that is alive at the same time
+static uint32_t fits_placed(render_graph_t *graph, uint32_t *order, uint32_t index) {
+    graph_resource_t *resource = &graph->resources[order[index]];
+
+    for(uint32_t i = 0; i < index; i++) {
+        graph_resource_t *placed = &graph->resources[order[i]];
+
+        if(lifetimes_overlap(resource, placed) && memory_overlaps(resource, placed)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void create_transient(graph_resource_t *resource, VkDevice logical_device, uint32_t frame_index) {
+    if(resource->type == GRAPH_RESOURCE_IMAGE) {
+        VkImageCreateInfo create_info = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .extent = {resource->width, resource->height, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .format = resource->format,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .usage = resource->image_usage,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+        };
+
+        if(vkCreateImage(logical_device, &create_info, NULL, &resource->images[frame_index]) != VK_SUCCESS) {
+            error(1, "Failed to create render graph image\n");
+        }
+        vkGetImageMemoryRequirements(logical_device, resource->images[frame_index], &resource->requirements);
+    } else {
+        VkBufferCreateInfo create_info = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = resource->size,
+            .usage = resource->buffer_usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+        };
+
+        if(vkCreateBuffer(logical_device, &create_info, NULL, &resource->buffers[frame_index]) != VK_SUCCESS) {
+            error(1, "Failed to create render graph buffer\n");
+        }
+        vkGetBufferMemoryRequirements(logical_device, resource->buffers[frame_index], &resource->requirements);
+    }
+}
+
+/*
+    Largest first, each transient goes at the lowest offset clear of every transient already placed whose
+    lifetime overlaps its own. Those that never overlap end up sharing memory.
+*/
+static void place_transients(render_graph_t *graph, renderer_t *renderer) {
+    uint32_t order[GRAPH_MAX_RESOURCES];
+    uint32_t order_count = 0;
+    uint32_t memory_type_bits = ~0u;
+    VkDeviceSize memory_size = 0;
+
+    for(uint32_t i = 0; i < graph->resource_count; i++) {
+        graph_resource_t *resource = &graph->resources[i];
+
+        if(!resource->transient || resource->first_pass == ~0u) {
+            continue;
+        }
+
+        for(uint32_t j = 0; j < graph->frame_count; j++) {
+            create_transient(resource, renderer->logical_device, j);
+        }
+        memory_type_bits &= resource->requirements.memoryTypeBits;
+        graph->stats.unaliased_memory += resource->requirements.size;
+
+        uint32_t j = order_count++;
+        for(; j > 0 && graph->resources[order[j - 1]].requirements.size < resource->requirements.size; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    graph->transient_memory = calloc(graph->frame_count, sizeof(VkDeviceMemory));
+    if(graph->transient_memory == NULL) {
+        error(1, "Failed to allocate render graph memory\n");
+    }
+
+    if(order_count == 0) {
+        return;
+    }
+
+    for(uint32_t i = 0; i < order_count; i++) {
+        graph_resource_t *resource = &graph->resources[order[i]];
+        VkDeviceSize best = ~(VkDeviceSize)0;
+
+        //Candidates are the start of memory and the ends of the placed transients it may not overlap
+        for(uint32_t j = 0; j <= i; j++) {
+            graph_resource_t *other = j > 0 ? &graph->resources[order[j - 1]] : NULL;
+
+            if(other != NULL && !lifetimes_overlap(resource, other)) {
+                continue;
+            }
+
+            resource->offset = other != NULL ? align_offset(other->offset + other->requirements.size, resource->requirements.alignment) : 0;
+            if(resource->offset < best && fits_placed(graph, order, i)) {
+                best = resource->offset;
+            }
+        }
+
+        resource->offset = best;
+        memory_size = memory_size > best + resource->requirements.size ? memory_size : best + resource->requirements.size;
+    }
+
+    uint32_t memory_type = select_memory_type(renderer->physical_device, memory_type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if(memory_type == ~0) {
+        error(1, "Failed to find a memory type for every transient resource\n");
+    }
+
+    VkMemoryAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = memory_size,
+        .memoryTypeIndex = memory_type
+    };
+
+    for(uint32_t i = 0; i < graph->frame_count; i++) {
+        if(vkAllocateMemory(renderer->logical_device, &alloc_info, NULL, &graph->transient_memory[i]) != VK_SUCCESS) {
+            error(1, "Failed to allocate render graph memory\n");
+        }
+
+        for(uint32_t j = 0; j < order_count; j++) {
+            graph_resource_t *resource = &graph->resources[order[j]];
+
+            if(resource->type == GRAPH_RESOURCE_IMAGE) {
+                vkBindImageMemory(renderer->logical_device, resource->images[i], graph->transient_memory[i], resource->offset);
+                resource->image_views[i] = create_image_view(resource->images[i], renderer->logical_device, 1, resource->format, resource->aspect);
+            } else {
+                vkBindBufferMemory(renderer->logical_device, resource->buffers[i], graph->transient_memory[i], resource->offset);
+            }
+        }
+    }
+
+    graph->stats.transient_memory = memory_size;
+}
+
+/*
+    A write, or a layout transition, waits for the last write and every read since, a read only for the last
+    write and only if that has not already been made visible to it. Returns whether a barrier is needed.
+*/
+static uint32_t derive_barrier(graph_state_t *state, graph_access_t *access, uint32_t is_image, graph_barrier_t *barrier) {
+    uint32_t writes = (access->access & GRAPH_WRITE_ACCESS) != 0;
+    uint32_t transition = is_image && access->layout != state->layout;
+    uint32_t needed;
+
+    *barrier = (graph_barrier_t){
+        .resource = access->resource,
+        .destination_stages = access->stages,
+        .source_access = state->write_access,
+        .destination_access = access->access,
+        .old_layout = state->layout,
+        .new_layout = is_image ? access->layout : VK_IMAGE_LAYOUT_UNDEFINED
+    };
+
+    if(writes || transition) {
+        barrier->source_stages = state->write_stages | state->read_stages;
+        needed = barrier->source_stages != 0 || transition;
+
+        state->write_stages = writes ? access->stages : 0;
+        state->write_access = access->access & GRAPH_WRITE_ACCESS;
+        state->read_stages = writes ? 0 : access->stages;
+        state->visible_stages = writes ? 0 : access->stages;
+        state->visible_access = writes ? 0 : access->access;
+        state->layout = barrier->new_layout;
+    } else {
+        barrier->source_stages = state->write_stages;
+        needed = state->write_stages != 0 && ((access->stages & ~state->visible_stages) || (access->access & ~state->visible_access));
+
+        state->read_stages |= access->stages;
+        if(needed) {
+            state->visible_stages |= access->stages;
+            state->visible_access |= access->access;
+        }
+    }
+
+    return needed;
+}
+
+static void derive_barriers(render_graph_t *graph) {
+    graph_state_t states[GRAPH_MAX_RESOURCES];
+
+    for(uint32_t i = 0; i < graph->resource_count; i++) {
+        states[i] = graph->resources[i].initial;
+    }
+
+    for(uint32_t i = 0; i < graph->pass_count; i++) {
+        graph_pass_t *pass = &graph->passes[i];
+        pass->first_barrier = graph->barrier_count;
+
+        if(pass->culled) {
+            continue;
+        }
+
+        for(uint32_t j = pass->first_access; j < pass->first_access + pass->access_count; j++) {
+            graph_access_t *access = &graph->accesses[j];
+            graph_resource_t *resource = &graph->resources[access->resource];
+            graph_state_t *state = &states[access->resource];
+
+            //A transient's first use also has to wait for whatever used its memory before it
+            if(resource->transient && resource->first_pass == i) {
+                for(uint32_t k = 0; k < graph->resource_count; k++) {
+                    graph_resource_t *other = &graph->resources[k];
+
+                    if(other->transient && other->first_pass != ~0u && other->last_pass < i && memory_overlaps(resource, other)) {
+                        state->write_stages |= states[k].write_stages | states[k].read_stages;
+                        state->write_access |= states[k].write_access;
+                    }
+                }
+            }
+
+            if(derive_barrier(state, access, resource->type == GRAPH_RESOURCE_IMAGE, &graph->barriers[graph->barrier_count])) {
+                pass->barrier_count++;
+                graph->barrier_count++;
+            }
+        }
+
+        graph->stats.barrier_count += pass->barrier_count;
+        graph->stats.barrier_batches += pass->barrier_count > 0;
+    }
+}
+
+void compile_render_graph(render_graph_t *graph, renderer_t *renderer) {
+    graph->stats.pass_count = graph->pass_count;
+
+    cull_passes(graph);
+    place_transients(graph, renderer);
+    derive_barriers(graph);
+
+    graph->compiled = 1;
+}
+
+void set_graph_image(render_graph_t *graph, uint32_t resource, VkImage image, uint32_t frame_index) {
+    graph->resources[resource].images[frame_index] = image;
+}
+
+void set_graph_buffer(render_graph_t *graph, uint32_t resource, VkBuffer buffer, uint32_t frame_index) {
+    graph->resources[resource].buffers[frame_index] = buffer;
+}
+
+VkImage graph_image(render_graph_t *graph, uint32_t resource, uint32_t frame_index) {
+    return graph->resources[resource].images[frame_index];
+}
+
+//Only transient images have a view made by the graph
+VkImageView graph_image_view(render_graph_t *graph, uint32_t resource, uint32_t frame_index) {
+    return graph->resources[resource].image_views[frame_index];
+}
+
+VkBuffer graph_buffer(render_graph_t *graph, uint32_t resource, uint32_t frame_index) {
+    return graph->resources[resource].buffers[frame_index];
+}
+
+/*
+    The frame must have been waited for, transient resources are then free for this frame to use
+*/
+void execute_render_graph(render_graph_t *graph, VkCommandBuffer command_buffer, uint32_t frame_index) {
+    VkImageMemoryBarrier2 image_barriers[GRAPH_MAX_RESOURCES];
+    VkBufferMemoryBarrier2 buffer_barriers[GRAPH_MAX_RESOURCES];
+
+    for(uint32_t i = 0; i < graph->pass_count; i++) {
+        graph_pass_t *pass = &graph->passes[i];
+        uint32_t image_barrier_count = 0, buffer_barrier_count = 0;
+
+        if(pass->culled) {
+            continue;
+        }
+
+        for(uint32_t j = pass->first_barrier; j < pass->first_barrier + pass->barrier_count; j++) {
+            graph_barrier_t *barrier = &graph->barriers[j];
+            graph_resource_t *resource = &graph->resources[barrier->resource];
+
+            if(resource->type == GRAPH_RESOURCE_IMAGE) {
+                image_barriers[image_barrier_count++] = (VkImageMemoryBarrier2){
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                    .image = resource->images[frame_index],
+                    .subresourceRange = (VkImageSubresourceRange){
+                        .aspectMask = resource->aspect,
+                        .levelCount = VK_REMAINING_MIP_LEVELS,
+                        .baseMipLevel = 0,
+                        .baseArrayLayer = 0,
+                        .layerCount = VK_REMAINING_ARRAY_LAYERS
+                    },
+                    .srcStageMask = barrier->source_stages,
+                    .srcAccessMask = barrier->source_access,
+                    .dstStageMask = barrier->destination_stages,
+                    .dstAccessMask = barrier->destination_access,
+                    .oldLayout = barrier->old_layout,
+                    .newLayout = barrier->new_layout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .pNext = NULL
+                };
+            } else {
+                buffer_barriers[buffer_barrier_count++] = (VkBufferMemoryBarrier2){
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                    .buffer = resource->buffers[frame_index],
+                    .offset = 0,
+                    .size = VK_WHOLE_SIZE,
+                    .srcStageMask = barrier->source_stages,
+                    .dstStageMask = barrier->destination_stages,
+                    .srcAccessMask = barrier->source_access,
+                    .dstAccessMask = barrier->destination_access,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .pNext = NULL
+                };
+            }
+        }
+
+        if(pass->barrier_count > 0) {
+            pipeline_barrier(command_buffer, 0, NULL, buffer_barrier_count, buffer_barriers, image_barrier_count, image_barriers);
+        }
+
+        pass->record(command_buffer, pass->data, frame_index);
+    }
+}
+
+void print_render_graph_stats(render_graph_t *graph) {
+    render_graph_stats_t *stats = &graph->stats;
+
+    printf("Render graph: %u passes, %u culled, %u barriers in %u batches, ",
+        stats->pass_count, stats->culled_passes, stats->barrier_count, stats->barrier_batches);
+    if(stats->unaliased_memory == 0) {
+        printf("no transient resources\n");
+    } else {
+        printf("transient memory %.2f MiB aliased from %.2f MiB per frame\n",
+            (double)stats->transient_memory/(1 << 20), (double)stats->unaliased_memory/(1 << 20));
+    }
+}
+
+void destroy_render_graph(render_graph_t *graph, VkDevice logical_device) {
+    for(uint32_t i = 0; i < graph->resource_count; i++) {
+        graph_resource_t *resource = &graph->resources[i];
+
+        for(uint32_t j = 0; j < graph->frame_count && resource->transient; j++) {
+            if(resource->type == GRAPH_RESOURCE_IMAGE) {
+                if(resource->image_views[j] != VK_NULL_HANDLE) {
+                    vkDestroyImageView(logical_device, resource->image_views[j], NULL);
+                }
+                vkDestroyImage(logical_device, resource->images[j], NULL);
+            } else {
+                vkDestroyBuffer(logical_device, resource->buffers[j], NULL);
+            }
+        }
+
+        free(resource->images);
+        free(resource->image_views);
+        free(resource->buffers);
+    }
+
+    for(uint32_t i = 0; i < graph->frame_count && graph->transient_memory != NULL; i++) {
+        if(graph->transient_memory[i] != VK_NULL_HANDLE) {
+            vkFreeMemory(logical_device, graph->transient_memory[i], NULL);
+        }
+    }
+    free(graph->transient_memory);
+}
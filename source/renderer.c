@@ -8,7 +8,10 @@
     const char *device_extensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 #endif
 
-const uint32_t frames_in_flight = 3;
+uint32_t frames_in_flight;//Set from the pacing mode when the renderer is initialised
+const pacing_mode_t pacing_mode = PACING_THROUGHPUT;
+const double pacing_target_fps = 60.0;//Only for PACING_TARGET_FPS
+const uint32_t dynamic_rendering = 1;//Otherwise the scene is drawn in a render pass, with framebuffers rebuilt on every resize
 
 void initialise_engine(engine_t *engine) {
     initialise_window(&engine->window);
@@ -36,8 +39,25 @@ void initialise_renderer(renderer_t *renderer, window_t window) {
     select_physical_device(&renderer->physical_device, renderer->instance, renderer->surface);
     create_logical_device(&renderer->logical_device, renderer->physical_device, &renderer->queues, device_extension_count, device_extensions);
 
-    setup_swapchain(renderer, window);
+    //Low latency never queues more than the display shows, throughput never waits for it
+    const VkPresentModeKHR low_latency_modes[] = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    const VkPresentModeKHR throughput_modes[] = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    renderer->pacing = initialise_frame_pacing(pacing_mode, pacing_target_fps);
+    frames_in_flight = renderer->pacing.frame_count;
+    if(pacing_mode == PACING_THROUGHPUT) {
+        renderer->present_mode = choose_swap_present_mode(renderer->physical_device, renderer->surface, throughput_modes, 3);
+    } else {
+        renderer->present_mode = choose_swap_present_mode(renderer->physical_device, renderer->surface, low_latency_modes, 2);
+    }
+
+    renderer->deletions = NULL;
+    renderer->deletion_count = 0;
+    renderer->deletion_capacity = 0;
 
+    setup_swapchain(renderer, window, VK_NULL_HANDLE);
+
+    renderer->dynamic_rendering = dynamic_rendering;
+    initialise_depth_manager(&renderer->depth, renderer->physical_device, frames_in_flight);
     setup_depth_resources(renderer);
     setup_render_pass(renderer);    
     setup_framebuffers(renderer);
@@ -51,6 +71,8 @@ void initialise_renderer(renderer_t *renderer, window_t window) {
 
 void terminate_renderer(renderer_t *renderer) {
     vkDeviceWaitIdle(renderer->logical_device);
+    flush_deletions(renderer, UINT64_MAX);
+    free(renderer->deletions);
 
     destroy_framebuffers(renderer);
     destroy_depth_resources(renderer);
@@ -60,6 +82,7 @@ void terminate_renderer(renderer_t *renderer) {
     vkDestroyCommandPool(renderer->logical_device, renderer->command_pool, NULL);
     
     destroy_render_pass(renderer);
+    destroy_frame_pacing(&renderer->pacing);
 
     vkDestroyDevice(renderer->logical_device, NULL);
 
@@ -70,11 +93,10 @@ void terminate_renderer(renderer_t *renderer) {
 
 
 
-void setup_swapchain(renderer_t *renderer, window_t window) {
+void setup_swapchain(renderer_t *renderer, window_t window, VkSwapchainKHR old_swapchain) {
     VkSurfaceCapabilitiesKHR capabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(renderer->physical_device, renderer->surface, &capabilities);
     
-    VkPresentModeKHR present_mode = choose_swap_present_mode(renderer->physical_device, renderer->surface);
     VkSurfaceFormatKHR surface_format = choose_swap_surface_format(renderer->physical_device, renderer->surface);
     VkExtent2D extent = choose_swap_extent(&capabilities, window);
     uint32_t min_image_count = capabilities.minImageCount + 1;
@@ -82,7 +104,7 @@ void setup_swapchain(renderer_t *renderer, window_t window) {
     renderer->swapchain_image_format = surface_format.format;
     renderer->extent = extent;
 
-    create_swapchain(&renderer->swapchain, renderer->logical_device, renderer->physical_device, renderer->surface, min_image_count, extent);
+    create_swapchain(&renderer->swapchain, renderer->logical_device, renderer->physical_device, renderer->surface, min_image_count, extent, renderer->present_mode, old_swapchain);
 
     vkGetSwapchainImagesKHR(renderer->logical_device, renderer->swapchain, &renderer->swapchain_image_count, NULL);
 
@@ -106,6 +128,32 @@ void terminate_swapchain(renderer_t *renderer) {
     free(renderer->swapchain_image_views);
 }
 
+static void destroy_retired_swapchain(renderer_t *renderer, void *data) {
+    retired_swapchain_t *retired = data;
+
+    for(uint32_t i = 0; i < retired->framebuffer_count; i++) {
+        vkDestroyFramebuffer(renderer->logical_device, retired->framebuffers[i], NULL);
+    }
+    for(uint32_t i = 0; i < retired->image_count; i++) {
+        vkDestroyImageView(renderer->logical_device, retired->image_views[i], NULL);
+    }
+    vkDestroySwapchainKHR(renderer->logical_device, retired->swapchain, NULL);
+
+    free(retired->images);
+    free(retired->image_views);
+    free(retired->framebuffers);
+    free(retired);
+}
+
+static void destroy_retired_depth_targets(renderer_t *renderer, void *data) {
+    destroy_depth_targets(data, renderer->depth.target_count, renderer->logical_device);
+}
+
+/*
+    The new swapchain takes over from the old one, which is retired along with its views and framebuffers,
+    and the depth buffers if the extent changed, once the frames already submitted against them have completed. Frames keep being recorded
+    meanwhile, only a minimised window, which has nothing to present to, blocks until it is restored.
+*/
 void recreate_swapchain(renderer_t *renderer, window_t window) {
     int width = 0, height = 0;
     get_framebuffer_size(window, &width, &height);
@@ -115,67 +163,297 @@ void recreate_swapchain(renderer_t *renderer, window_t window) {
         window_wait_events();
     }
 
-    vkDeviceWaitIdle(renderer->logical_device);
+    retired_swapchain_t *retired = malloc(sizeof(retired_swapchain_t));
+    if(retired == NULL) {
+        error(1, "Failed to allocate retired swapchain\n");
+    }
 
-    terminate_swapchain(renderer);
-    destroy_framebuffers(renderer);
-    destroy_depth_resources(renderer);
-    setup_swapchain(renderer, window);
+    *retired = (retired_swapchain_t){
+        .swapchain = renderer->swapchain,
+        .image_count = renderer->swapchain_image_count,
+        .images = renderer->swapchain_images,
+        .image_views = renderer->swapchain_image_views,
+        .framebuffers = renderer->framebuffers,
+        .framebuffer_count = renderer->framebuffers != NULL ? renderer->swapchain_image_count*renderer->depth.target_count : 0
+    };
+
+    setup_swapchain(renderer, window, retired->swapchain);
     setup_depth_resources(renderer);
     setup_framebuffers(renderer);
+
+    defer_deletion(renderer, destroy_retired_swapchain, retired);
 }
 
 
 
 void setup_render_pass(renderer_t *renderer) {
-    create_render_pass_depth_buffered(&renderer->render_pass, renderer->logical_device, renderer->swapchain_image_format, renderer->depth_image_format);
+    if(renderer->dynamic_rendering) {
+        renderer->render_pass = VK_NULL_HANDLE;
+        return;
+    }
+
+    create_render_pass_depth_buffered(&renderer->render_pass, renderer->logical_device, renderer->swapchain_image_format, renderer->depth.format);
 }
 
 void destroy_render_pass(renderer_t *renderer) {
-    vkDestroyRenderPass(renderer->logical_device, renderer->render_pass, NULL);
+    if(renderer->render_pass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(renderer->logical_device, renderer->render_pass, NULL);
+    }
 }
 
 
+/*
+    Resizes the depth buffers to the swapchain extent, a recreation that keeps the extent leaves them be
+*/
 void setup_depth_resources(renderer_t *renderer) {
-    renderer->depth_images = malloc(renderer->swapchain_image_count*sizeof(image_t));
-    renderer->depth_image_views = malloc(renderer->swapchain_image_count*sizeof(VkImageView));
-    renderer->depth_image_format = VK_FORMAT_D32_SFLOAT_S8_UINT ;
+    if(depth_targets_match(&renderer->depth, renderer->extent)) {
+        return;
+    }
 
-    for(uint32_t i = 0; i < renderer->swapchain_image_count; i++) {
-        renderer->depth_images[i] = create_image(renderer, renderer->extent.width, renderer->extent.width, 1, VK_SAMPLE_COUNT_1_BIT, renderer->depth_image_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        renderer->depth_image_views[i] = create_image_view(renderer->depth_images[i].image, renderer->logical_device, 1, renderer->depth_image_format, VK_IMAGE_ASPECT_DEPTH_BIT);
+    depth_target_t *replaced = resize_depth_targets(&renderer->depth, renderer->logical_device, renderer->physical_device, renderer->extent);
+    if(replaced != NULL) {
+        defer_deletion(renderer, destroy_retired_depth_targets, replaced);
     }
+
+    printf("Depth: %u targets of %ux%u, %.1f MB\n", renderer->depth.target_count, renderer->extent.width, renderer->extent.height, (double)renderer->depth.memory_size/(1024.0*1024.0));
 }
 
 void destroy_depth_resources(renderer_t *renderer) {
-    for(uint32_t i = 0; i < renderer->swapchain_image_count; i++) {
-        vkDestroyImageView(renderer->logical_device, renderer->depth_image_views[i], NULL);
-        destroy_image(&renderer->depth_images[i], renderer->logical_device);
-    }
+    destroy_depth_targets(renderer->depth.targets, renderer->depth.target_count, renderer->logical_device);
+    renderer->depth.targets = NULL;
 }
 
 
 
 void setup_framebuffers(renderer_t *renderer) {
-    renderer->framebuffers = malloc(renderer->swapchain_image_count*sizeof(VkFramebuffer));
+    if(renderer->dynamic_rendering) {
+        renderer->framebuffers = NULL;
+        return;
+    }
 
-    for(uint32_t i = 0; i < renderer->swapchain_image_count; i++) {
-        uint32_t attachment_count = 2;
-        VkImageView attachments[2] = {renderer->swapchain_image_views[i], renderer->depth_image_views[i]};
+    uint32_t framebuffer_count = renderer->swapchain_image_count*renderer->depth.target_count;
+    renderer->framebuffers = malloc(framebuffer_count*sizeof(VkFramebuffer));
+    if(renderer->framebuffers == NULL) {
+        error(1, "Failed to allocate framebuffers\n");
+    }
+
+    //Indexed by frame then swapchain image
+    for(uint32_t i = 0; i < framebuffer_count; i++) {
+        VkImageView attachments[2] = {renderer->swapchain_image_views[i%renderer->swapchain_image_count], renderer->depth.targets[i/renderer->swapchain_image_count].view};
         create_framebuffer(&renderer->framebuffers[i], renderer->logical_device, renderer->render_pass, 2, attachments, renderer->extent);
     }
 }
 
 void destroy_framebuffers(renderer_t *renderer) {
-    for(uint32_t i = 0; i < renderer->swapchain_image_count; i++) {
+    for(uint32_t i = 0; i < renderer->swapchain_image_count*renderer->depth.target_count && renderer->framebuffers != NULL; i++) {
         vkDestroyFramebuffer(renderer->logical_device, renderer->framebuffers[i], NULL);
     }
 
     free(renderer->framebuffers);
 }
 
+//The framebuffer pairing image_index with the current frame's depth buffer, VK_NULL_HANDLE with dynamic rendering
+VkFramebuffer scene_framebuffer(renderer_t *renderer, uint32_t image_index) {
+    if(renderer->framebuffers == NULL) {
+        return VK_NULL_HANDLE;
+    }
+
+    return renderer->framebuffers[renderer->frame_index*renderer->swapchain_image_count + image_index];
+}
+
+
+
+/*
+    What the scene's pipelines are built against. With dynamic rendering they only depend on the attachment
+    formats, which survive a resize.
+*/
+render_target_t scene_render_target(renderer_t *renderer) {
+    return (render_target_t){
+        .render_pass = renderer->render_pass,
+        .color_format = renderer->swapchain_image_format,
+        .depth_format = renderer->depth.format
+    };
+}
+
+/*
+    Begins drawing into the swapchain image and the current frame's depth buffer, cleared to clear_values. Without a render
+    pass the layout transitions its attachments and subpass dependencies made are recorded here instead.
+*/
+void begin_scene_rendering(renderer_t *renderer, VkCommandBuffer command_buffer, uint32_t image_index, VkClearValue clear_values[2], VkSubpassContents contents) {
+    VkRect2D render_area = {
+        .offset = {0, 0},
+        .extent = renderer->extent
+    };
+
+    if(!renderer->dynamic_rendering) {
+        VkRenderPassBeginInfo render_pass_info = {
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .renderPass = renderer->render_pass,
+            .framebuffer = scene_framebuffer(renderer, image_index),
+            .renderArea = render_area,
+            .clearValueCount = 2,
+            .pClearValues = clear_values,
+            .pNext = NULL
+        };
+
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, contents);
+        return;
+    }
+
+    //The previous contents of either are never needed, the acquire semaphore is waited on at the colour output stage
+    VkImageMemoryBarrier2 barriers[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .image = renderer->swapchain_images[image_index],
+            .subresourceRange = (VkImageSubresourceRange){
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .levelCount = 1,
+                .baseMipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask = VK_ACCESS_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .image = renderer->depth.targets[renderer->frame_index].image,
+            .subresourceRange = (VkImageSubresourceRange){
+                .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                .levelCount = 1,
+                .baseMipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .srcStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .pNext = NULL
+        }
+    };
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 2, barriers);
+
+    VkRenderingAttachmentInfo color_attachment = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = renderer->swapchain_image_views[image_index],
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .resolveMode = VK_RESOLVE_MODE_NONE,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = clear_values[0]
+    };
+
+    VkRenderingAttachmentInfo depth_attachment = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = renderer->depth.targets[renderer->frame_index].view,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .resolveMode = VK_RESOLVE_MODE_NONE,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .clearValue = clear_values[1]
+    };
+
+    VkRenderingInfo rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .flags = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0,
+        .renderArea = render_area,
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_attachment,
+        .pDepthAttachment = &depth_attachment,
+        .pStencilAttachment = NULL
+    };
+
+    vkCmdBeginRendering(command_buffer, &rendering_info);
+}
+
+void end_scene_rendering(renderer_t *renderer, VkCommandBuffer command_buffer, uint32_t image_index) {
+    if(!renderer->dynamic_rendering) {
+        vkCmdEndRenderPass(command_buffer);
+        return;
+    }
+
+    vkCmdEndRendering(command_buffer);
+
+    //Presentation waits on the render finished semaphore, which needs no stage here
+    VkImageMemoryBarrier2 present_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .image = renderer->swapchain_images[image_index],
+        .subresourceRange = (VkImageSubresourceRange){
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = 1,
+            .baseMipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask = VK_ACCESS_2_NONE,
+        .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .pNext = NULL
+    };
+    pipeline_barrier(command_buffer, 0, NULL, 0, NULL, 1, &present_barrier);
+}
 
 
+
+/*
+    Destroys data with destroy once every frame submitted so far has completed
+*/
+void defer_deletion(renderer_t *renderer, deletion_t destroy, void *data) {
+    if(renderer->deletion_count == renderer->deletion_capacity) {
+        uint32_t capacity = renderer->deletion_capacity > 0 ? 2*renderer->deletion_capacity : 4;
+        deferred_deletion_t *deletions = realloc(renderer->deletions, capacity*sizeof(deferred_deletion_t));
+
+        if(deletions == NULL) {
+            error(1, "Failed to allocate deferred deletions\n");
+        }
+        renderer->deletions = deletions;
+        renderer->deletion_capacity = capacity;
+    }
+
+    renderer->deletions[renderer->deletion_count++] = (deferred_deletion_t){
+        .timeline_value = renderer->frame_number,
+        .destroy = destroy,
+        .data = data
+    };
+}
+
+/*
+    Runs the deletions whose frames the timeline has passed, in the order they were deferred
+*/
+void flush_deletions(renderer_t *renderer, uint64_t completed_value) {
+    uint32_t kept = 0;
+
+    for(uint32_t i = 0; i < renderer->deletion_count; i++) {
+        deferred_deletion_t *deletion = &renderer->deletions[i];
+
+        if(deletion->timeline_value <= completed_value) {
+            deletion->destroy(renderer, deletion->data);
+        } else {
+            renderer->deletions[kept++] = *deletion;
+        }
+    }
+
+    renderer->deletion_count = kept;
+}
+
 void setup_frame_resources(renderer_t *renderer, uint32_t frame_count) {
     renderer->frame_count = frame_count;
     renderer->frames = malloc(renderer->frame_count*sizeof(frame_t));
@@ -188,20 +466,32 @@ void setup_frame_resources(renderer_t *renderer, uint32_t frame_count) {
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
     };
 
-    VkFenceCreateInfo fence_create_info = {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .flags = VK_FENCE_CREATE_SIGNALED_BIT
+    VkSemaphoreTypeCreateInfo timeline_type_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0
     };
 
+    VkSemaphoreCreateInfo timeline_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timeline_type_info
+    };
+
+    if(vkCreateSemaphore(renderer->logical_device, &timeline_create_info, NULL, &renderer->frame_timeline) != VK_SUCCESS) {
+        error(1, "Failed to create frame timeline");
+    }
+    renderer->frame_number = 0;
+
+    //Acquire and present only take binary semaphores
     for(uint32_t i = 0; i < frame_count; i++) {
         if(vkCreateSemaphore(renderer->logical_device, &semaphore_create_info, NULL, &renderer->frames[i].image_available_semaphore) != VK_SUCCESS ||
-           vkCreateSemaphore(renderer->logical_device, &semaphore_create_info, NULL, &renderer->frames[i].render_finished_semaphore) != VK_SUCCESS ||
-           vkCreateFence(renderer->logical_device, &fence_create_info, NULL, &renderer->frames[i].in_flight_fence) != VK_SUCCESS) {
+           vkCreateSemaphore(renderer->logical_device, &semaphore_create_info, NULL, &renderer->frames[i].render_finished_semaphore) != VK_SUCCESS) {
             error(1, "Failed to create frame sync resources");
         }
+        renderer->frames[i].timeline_value = 0;
 
-        create_command_pool(&renderer->frames[i].command_pool, renderer->logical_device, renderer->graphics_family);
-        create_primary_command_buffer(&renderer->frames[i].command_buffer, renderer->logical_device, renderer->command_pool, 1);
+        create_command_allocator(&renderer->frames[i].command_allocator, renderer->logical_device, renderer->graphics_family);
+        renderer->frames[i].command_buffer = VK_NULL_HANDLE;
     }
 }
 
@@ -210,6 +500,7 @@ void destroy_frame_resources(renderer_t *renderer) {
         clean_up_frame(&renderer->frames[i], renderer->logical_device);
     }
 
+    vkDestroySemaphore(renderer->logical_device, renderer->frame_timeline, NULL);
     free(renderer->frames);
 }
 
@@ -276,11 +567,15 @@ void transition_image(VkCommandBuffer command_buffer, VkImage image, VkImageLayo
 
 
 host_buffer_t create_host_buffer(renderer_t *renderer, VkDeviceSize device_size, VkQueue queue) {
+    return create_mapped_buffer(renderer, device_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+}
+
+host_buffer_t create_mapped_buffer(renderer_t *renderer, VkDeviceSize device_size, VkBufferUsageFlags usage) {
     VkBuffer buffer;
     VkDeviceMemory buffer_memory;
     void *mapped_memory;
 
-    create_buffer(&buffer, &buffer_memory, renderer->logical_device, renderer->physical_device, device_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    create_buffer(&buffer, &buffer_memory, renderer->logical_device, renderer->physical_device, device_size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     vkMapMemory(renderer->logical_device, buffer_memory, 0, device_size, 0, &mapped_memory);
 
     host_buffer_t host_buffer = {
@@ -292,6 +587,31 @@ host_buffer_t create_host_buffer(renderer_t *renderer, VkDeviceSize device_size,
     return host_buffer;
 }
 
+buffer_t create_device_buffer(renderer_t *renderer, VkDeviceSize device_size, VkBufferUsageFlags usage) {
+    buffer_t device_buffer;
+
+    create_buffer(&device_buffer.buffer, &device_buffer.memory, renderer->logical_device, renderer->physical_device, device_size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    return device_buffer;
+}
+
+void upload_buffer(renderer_t *renderer, buffer_t *destination, void *data, VkDeviceSize size) {
+    buffer_t staging_buffer;
+    VkCommandBuffer command_buffer;
+
+    create_buffer(&staging_buffer.buffer, &staging_buffer.memory, renderer->logical_device, renderer->physical_device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    void *mapped_memory;
+    vkMapMemory(renderer->logical_device, staging_buffer.memory, 0, size, 0, &mapped_memory);
+    memcpy(mapped_memory, data, size);
+    vkUnmapMemory(renderer->logical_device, staging_buffer.memory);
+
+    create_primary_command_buffer(&command_buffer, renderer->logical_device, renderer->command_pool, 1);
+    copy_buffer(destination->buffer, staging_buffer.buffer, renderer->logical_device, command_buffer, renderer->queues.graphics_queue, size);
+    vkFreeCommandBuffers(renderer->logical_device, renderer->command_pool, 1, &command_buffer);
+
+    destroy_buffer(&staging_buffer, renderer->logical_device);
+}
+
 buffer_t create_vertex_buffer(renderer_t *renderer, uint32_t vertex_count, size_t vertex_size, void *vertices, VkQueue queue, VkCommandBuffer command_buffer) {
     VkDeviceSize buffer_size = vertex_count*vertex_size;
     buffer_t staging_buffer, vertex_buffer;
@@ -341,8 +661,7 @@ void destroy_host_buffer(host_buffer_t *buffer, VkDevice logical_device) {
 
 
 void clean_up_frame(frame_t *frame, VkDevice logical_device) {
-    vkDestroyFence(logical_device, frame->in_flight_fence, NULL);
-    vkDestroyCommandPool(logical_device, frame->command_pool, NULL);
+    destroy_command_allocator(&frame->command_allocator, logical_device);
     vkDestroySemaphore(logical_device, frame->image_available_semaphore, NULL);
     vkDestroySemaphore(logical_device, frame->render_finished_semaphore, NULL);
 }
@@ -358,16 +677,22 @@ void clean_up_frames(frame_t *frames, uint32_t frame_count, VkDevice logical_dev
 
 
 void draw_mesh(frame_t *frame, render_object_t *object, VkDescriptorSet global_descriptor) {
-    vkCmdBindPipeline(frame->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object->material_instance->material_pipeline->pipeline);
+    record_draw(frame->command_buffer, object, global_descriptor);
+}
+
+void record_draw(VkCommandBuffer command_buffer, render_object_t *object, VkDescriptorSet global_descriptor) {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object->material_instance->material_pipeline->pipeline);
 
-    vkCmdBindDescriptorSets(frame->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object->material_instance->material_pipeline->layout, 0, 1, &global_descriptor, 0, NULL);
-    vkCmdBindDescriptorSets(frame->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object->material_instance->material_pipeline->layout, 1, 1, &object->material_instance->descriptor, 0, NULL);
-    vkCmdPushConstants(frame->command_buffer, object->material_instance->material_pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_data_t), &object->push_constant);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object->material_instance->material_pipeline->layout, 0, 1, &global_descriptor, 0, NULL);
+    if(object->material_instance->descriptor != VK_NULL_HANDLE) {
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object->material_instance->material_pipeline->layout, 1, 1, &object->material_instance->descriptor, 0, NULL);
+    }
+    vkCmdPushConstants(command_buffer, object->material_instance->material_pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_data_t), &object->push_constant);
     
     VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(frame->command_buffer, 0, 1, object->vertex_buffer, offsets);
-    vkCmdBindIndexBuffer(frame->command_buffer, object->index_buffer, 0, VK_INDEX_TYPE_UINT16);
-    vkCmdDrawIndexed(frame->command_buffer, object->index_count, 1, object->first_index, 0, 0);
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, object->vertex_buffer, offsets);
+    vkCmdBindIndexBuffer(command_buffer, object->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+    vkCmdDrawIndexed(command_buffer, object->index_count, 1, object->first_index, 0, 0);
 }
 
 void draw_frame(engine_t *engine, uint32_t frame_index) {
@@ -377,24 +702,55 @@ void draw_frame(engine_t *engine, uint32_t frame_index) {
     end_frame(engine, frame_index, image_index);
 }
 
+/*
+    Blocks until the slot's last submission has completed, which is also what keeps the CPU at most
+    frame_count frames ahead of the GPU
+*/
+void wait_for_frame(renderer_t *renderer, uint32_t frame_index) {
+    VkSemaphoreWaitInfo wait_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &renderer->frame_timeline,
+        .pValues = &renderer->frames[frame_index].timeline_value
+    };
+
+    if(vkWaitSemaphores(renderer->logical_device, &wait_info, UINT64_MAX) != VK_SUCCESS) {
+        error(1, "Failed to wait for frame");
+    }
+}
+
 uint32_t begin_frame(engine_t *engine, uint32_t frame_index) {
     renderer_t *renderer = &engine->renderer;
     frame_t *frame = &renderer->frames[frame_index];
     
-    vkWaitForFences(renderer->logical_device, 1, &frame->in_flight_fence, VK_TRUE, UINT64_MAX);
+    wait_for_frame_start(&renderer->pacing);
+    wait_for_frame(renderer, frame_index);
+    renderer->frame_index = frame_index;
 
-    uint32_t image_index;
-    VkResult result = vkAcquireNextImageKHR(renderer->logical_device, renderer->swapchain, UINT64_MAX, frame->image_available_semaphore, VK_NULL_HANDLE, &image_index);
+    uint64_t completed_value;
+    vkGetSemaphoreCounterValue(renderer->logical_device, renderer->frame_timeline, &completed_value);
+    for(uint32_t i = 0; i < renderer->frame_count; i++) {
+        if(renderer->frames[i].timeline_value <= completed_value) {
+            complete_frame(&renderer->pacing, i);
+        }
+    }
+    flush_deletions(renderer, completed_value);
 
-    if(result == VK_ERROR_OUT_OF_DATE_KHR) {
+    //An out of date acquire signals nothing, so the semaphore can be used again with the new swapchain
+    uint32_t image_index;
+    VkResult result;
+    while((result = vkAcquireNextImageKHR(renderer->logical_device, renderer->swapchain, UINT64_MAX, frame->image_available_semaphore, VK_NULL_HANDLE, &image_index)) == VK_ERROR_OUT_OF_DATE_KHR) {
         recreate_swapchain(renderer, engine->window);
-    } else if(result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+    }
+
+    if(result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         error(1, "Failed to acquire swap chain image!");
     }
 
-    vkResetFences(renderer->logical_device, 1, &frame->in_flight_fence);
-    vkResetCommandBuffer(frame->command_buffer, 0);
-    begin_command_buffer(frame->command_buffer, VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+    //Everything the frame recorded last time round has executed, so its buffers are reset in one call
+    reset_command_allocator(&frame->command_allocator, renderer->logical_device);
+    frame->command_buffer = allocate_primary_buffer(&frame->command_allocator, renderer->logical_device);
+    begin_command_buffer(frame->command_buffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
     return image_index;
 }
 
@@ -403,23 +759,45 @@ void end_frame(engine_t *engine, uint32_t frame_index, uint32_t image_index) {
     frame_t *frame = &renderer->frames[frame_index];
     VkImage *image = &renderer->swapchain_images[image_index];
 
-    VkSemaphore wait_semaphore[] = {frame->image_available_semaphore};
-    VkSemaphore signal_semaphore[] = {frame->render_finished_semaphore};
-    VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    
-    VkSubmitInfo submit_info = {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = wait_semaphore,
-        .pWaitDstStageMask = wait_stages,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &frame->command_buffer,
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores = signal_semaphore
+    frame->timeline_value = ++renderer->frame_number;
+
+    VkSemaphoreSubmitInfo wait_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = frame->image_available_semaphore,
+        .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT
+    };
+
+    VkSemaphoreSubmitInfo signal_infos[2] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = frame->render_finished_semaphore,
+            .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = renderer->frame_timeline,
+            .value = frame->timeline_value,
+            .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+        }
+    };
+
+    VkCommandBufferSubmitInfo command_buffer_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+        .commandBuffer = frame->command_buffer
+    };
+
+    VkSubmitInfo2 submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+        .waitSemaphoreInfoCount = 1,
+        .pWaitSemaphoreInfos = &wait_info,
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &command_buffer_info,
+        .signalSemaphoreInfoCount = 2,
+        .pSignalSemaphoreInfos = signal_infos
     };
 
     end_command_buffer(frame->command_buffer);
-    if(vkQueueSubmit(renderer->queues.graphics_queue, 1, &submit_info, frame->in_flight_fence) != VK_SUCCESS) {
+    if(vkQueueSubmit2(renderer->queues.graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
         error(1, "Failed to submit draw command buffer");
     }
 
@@ -428,7 +806,7 @@ void end_frame(engine_t *engine, uint32_t frame_index, uint32_t image_index) {
     VkPresentInfoKHR present_info = {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
         .waitSemaphoreCount = 1,
-        .pWaitSemaphores = signal_semaphore,
+        .pWaitSemaphores = &frame->render_finished_semaphore,
         .swapchainCount = 1,
         .pSwapchains = swapchains,
         .pImageIndices = &image_index,
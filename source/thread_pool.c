@@ -0,0 +1,123 @@
+#include "thread_pool.h"
+#include "vulkan_utils.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+uint32_t hardware_thread_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long count = (long)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+void *worker_thread(void *argument) {
+    thread_pool_t *pool = argument;
+
+    pthread_mutex_lock(&pool->mutex);
+    while(1) {
+        while(pool->count == 0 && !pool->stop) {
+            pthread_cond_wait(&pool->task_available, &pool->mutex);
+        }
+
+        if(pool->count == 0 && pool->stop) {
+            break;
+        }
+
+        task_t task = pool->tasks[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pool->active++;
+        pthread_cond_signal(&pool->slot_available);
+        pthread_mutex_unlock(&pool->mutex);
+
+        task.function(task.argument);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->active--;
+        if(pool->count == 0 && pool->active == 0) {
+            pthread_cond_broadcast(&pool->tasks_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+void initialise_thread_pool(thread_pool_t *pool, uint32_t thread_count, uint32_t capacity) {
+    pool->thread_count = thread_count;
+    pool->capacity = capacity;
+    pool->head = 0;
+    pool->count = 0;
+    pool->active = 0;
+    pool->stop = 0;
+
+    pool->threads = malloc(thread_count*sizeof(pthread_t));
+    pool->tasks = malloc(capacity*sizeof(task_t));
+
+    if(pool->threads == NULL || pool->tasks == NULL) {
+        error(1, "Failed to allocate thread pool\n");
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->task_available, NULL);
+    pthread_cond_init(&pool->slot_available, NULL);
+    pthread_cond_init(&pool->tasks_done, NULL);
+
+    for(uint32_t i = 0; i < thread_count; i++) {
+        if(pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0) {
+            error(1, "Failed to create worker thread\n");
+        }
+    }
+}
+
+void submit_task(thread_pool_t *pool, task_function_t function, void *argument) {
+    pthread_mutex_lock(&pool->mutex);
+    while(pool->count == pool->capacity) {
+        pthread_cond_wait(&pool->slot_available, &pool->mutex);
+    }
+
+    pool->tasks[(pool->head + pool->count) % pool->capacity] = (task_t){
+        .function = function,
+        .argument = argument
+    };
+    pool->count++;
+
+    pthread_cond_signal(&pool->task_available);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void wait_for_tasks(thread_pool_t *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    while(pool->count > 0 || pool->active > 0) {
+        pthread_cond_wait(&pool->tasks_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void destroy_thread_pool(thread_pool_t *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->task_available);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for(uint32_t i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->task_available);
+    pthread_cond_destroy(&pool->slot_available);
+    pthread_cond_destroy(&pool->tasks_done);
+
+    free(pool->threads);
+    free(pool->tasks);
+}
@@ -0,0 +1,261 @@
+#define _POSIX_C_SOURCE 200809L
+#include "tile_cache.h"
+#include "vulkan_utils.h"
+
+#ifdef _WIN32
+#define seek_payload(file, offset) _fseeki64(file, (long long)(offset), SEEK_SET)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define seek_payload(file, offset) fseeko(file, (off_t)(offset), SEEK_SET)
+#endif
+
+typedef struct tile_task_t {
+    tile_cache_t *cache;
+    uint64_t hash;
+    uint8_t *data;
+    uint32_t size;
+    float *destination;
+    atomic_uint *state;
+} tile_task_t;
+
+uint64_t tile_hash(tile_key_t *key) {
+    const uint8_t *bytes = (const uint8_t*)key;
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for(size_t i = 0; i < sizeof(tile_key_t); i++) {
+        hash = (hash ^ bytes[i])*0x100000001b3ull;
+    }
+
+    return hash == 0 ? 1 : hash;
+}
+
+//Caller holds the mutex
+tile_index_entry_t *find_tile_entry(tile_cache_t *cache, uint64_t hash) {
+    uint32_t mask = cache->header->capacity - 1;
+
+    for(uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask) {
+        if(cache->entries[i].hash == hash || cache->entries[i].hash == 0) {
+            return &cache->entries[i];
+        }
+    }
+}
+
+void *map_tile_index(tile_cache_t *cache) {
+#ifdef _WIN32
+    void *index = calloc(1, cache->index_size);
+    FILE *file = fopen(cache->index_name, "rb");
+
+    if(index == NULL) {
+        error(1, "Failed to allocate tile cache index\n");
+    }
+
+    if(file) {
+        fread(index, 1, cache->index_size, file);
+        fclose(file);
+    }
+
+    cache->index_descriptor = -1;
+    return index;
+#else
+    int descriptor = open(cache->index_name, O_RDWR | O_CREAT, 0644);
+
+    if(descriptor < 0 || ftruncate(descriptor, (off_t)cache->index_size) != 0) {
+        error(1, "Failed to open tile cache index\n");
+    }
+
+    void *index = mmap(NULL, cache->index_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if(index == MAP_FAILED) {
+        error(1, "Failed to map tile cache index\n");
+    }
+
+    cache->index_descriptor = descriptor;
+    return index;
+#endif
+}
+
+void unmap_tile_index(tile_cache_t *cache) {
+#ifdef _WIN32
+    FILE *file = fopen(cache->index_name, "wb");
+
+    if(file) {
+        fwrite(cache->header, 1, cache->index_size, file);
+        fclose(file);
+    }
+
+    free(cache->header);
+#else
+    msync(cache->header, cache->index_size, MS_SYNC);
+    munmap(cache->header, cache->index_size);
+    close(cache->index_descriptor);
+#endif
+}
+
+/*
+    An index written by another version or capacity is cleared together with the payloads it points into
+*/
+void open_tile_cache(tile_cache_t *cache, const char *index_name, const char *payload_name) {
+    cache->index_name = index_name;
+    cache->index_size = sizeof(tile_index_header_t) + TILE_CACHE_CAPACITY*sizeof(tile_index_entry_t);
+    cache->header = map_tile_index(cache);
+    cache->entries = (tile_index_entry_t*)(cache->header + 1);
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->stores = 0;
+
+    cache->payload = fopen(payload_name, "r+b");
+    uint32_t valid = cache->payload != NULL
+        && cache->header->magic == TILE_CACHE_MAGIC
+        && cache->header->version == TILE_CACHE_VERSION
+        && cache->header->capacity == TILE_CACHE_CAPACITY;
+
+    if(!valid) {
+        if(cache->payload) {
+            fclose(cache->payload);
+        }
+
+        cache->payload = fopen(payload_name, "w+b");
+        if(cache->payload == NULL) {
+            error(1, "Failed to create tile cache payload file\n");
+        }
+
+        memset(cache->header, 0, cache->index_size);
+        *cache->header = (tile_index_header_t){
+            .magic = TILE_CACHE_MAGIC,
+            .version = TILE_CACHE_VERSION,
+            .capacity = TILE_CACHE_CAPACITY,
+            .count = 0,
+            .payload_size = 0
+        };
+    }
+
+    pthread_mutex_init(&cache->mutex, NULL);
+    initialise_thread_pool(&cache->io_thread, 1, TILE_CACHE_QUEUE);
+}
+
+uint32_t tile_cached(tile_cache_t *cache, uint64_t hash) {
+    pthread_mutex_lock(&cache->mutex);
+    uint32_t cached = find_tile_entry(cache, hash)->hash == hash;
+    cache->hits += cached;
+    cache->misses += !cached;
+    pthread_mutex_unlock(&cache->mutex);
+
+    return cached;
+}
+
+void read_tile_task(void *argument) {
+    tile_task_t *task = argument;
+    tile_cache_t *cache = task->cache;
+
+    pthread_mutex_lock(&cache->mutex);
+    tile_index_entry_t entry = *find_tile_entry(cache, task->hash);
+    pthread_mutex_unlock(&cache->mutex);
+
+    uint8_t *data = malloc(task->size);
+    uint32_t read = data != NULL && entry.hash == task->hash && entry.size == task->size
+        && seek_payload(cache->payload, entry.offset) == 0
+        && fread(data, 1, task->size, cache->payload) == task->size;
+
+    if(read) {
+        for(uint32_t i = 0; i < task->size; i++) {
+            task->destination[i] = (float)data[i]/255.0f;
+        }
+    }
+
+    atomic_store(task->state, read ? TILE_READ_DONE : TILE_READ_FAILED);
+    free(data);
+    free(task);
+}
+
+void store_tile_task(void *argument) {
+    tile_task_t *task = argument;
+    tile_cache_t *cache = task->cache;
+
+    pthread_mutex_lock(&cache->mutex);
+    tile_index_entry_t *entry = find_tile_entry(cache, task->hash);
+    uint32_t full = TILE_CACHE_MAX_LOAD*(cache->header->count + 1) > cache->header->capacity;
+    uint32_t store = entry->hash == 0 && !full;
+    uint64_t offset = cache->header->payload_size;
+    pthread_mutex_unlock(&cache->mutex);
+
+    //Only this thread appends, so the entry and offset stay valid while the payload is written
+    if(store && seek_payload(cache->payload, offset) == 0 && fwrite(task->data, 1, task->size, cache->payload) == task->size) {
+        fflush(cache->payload);
+
+        pthread_mutex_lock(&cache->mutex);
+        *entry = (tile_index_entry_t){
+            .hash = task->hash,
+            .offset = offset,
+            .size = task->size,
+            .padding = 0
+        };
+        cache->header->count++;
+        cache->header->payload_size = offset + task->size;
+        cache->stores++;
+        pthread_mutex_unlock(&cache->mutex);
+    }
+
+    free(task->data);
+    free(task);
+}
+
+/*
+    destination holds texel_count RGBA32F texels and must stay untouched until state leaves TILE_READ_PENDING
+*/
+void read_tile(tile_cache_t *cache, uint64_t hash, float *destination, uint32_t texel_count, atomic_uint *state) {
+    tile_task_t *task = malloc(sizeof(tile_task_t));
+
+    if(task == NULL) {
+        error(1, "Failed to allocate tile read\n");
+    }
+
+    *task = (tile_task_t){
+        .cache = cache,
+        .hash = hash,
+        .data = NULL,
+        .size = 4*texel_count,
+        .destination = destination,
+        .state = state
+    };
+
+    atomic_store(state, TILE_READ_PENDING);
+    submit_task(&cache->io_thread, read_tile_task, task);
+}
+
+void store_tile(tile_cache_t *cache, uint64_t hash, const float *texels, uint32_t texel_count) {
+    tile_task_t *task = malloc(sizeof(tile_task_t));
+    uint8_t *data = malloc(4*texel_count);
+
+    if(task == NULL || data == NULL) {
+        error(1, "Failed to allocate tile store\n");
+    }
+
+    for(uint32_t i = 0; i < 4*texel_count; i++) {
+        float v = texels[i] < 0.0f ? 0.0f : (texels[i] > 1.0f ? 1.0f : texels[i]);
+        data[i] = (uint8_t)(v*255.0f + 0.5f);
+    }
+
+    *task = (tile_task_t){
+        .cache = cache,
+        .hash = hash,
+        .data = data,
+        .size = 4*texel_count,
+        .destination = NULL,
+        .state = NULL
+    };
+
+    submit_task(&cache->io_thread, store_tile_task, task);
+}
+
+void close_tile_cache(tile_cache_t *cache) {
+    wait_for_tasks(&cache->io_thread);
+    destroy_thread_pool(&cache->io_thread);
+
+    printf("Tile cache: %llu hits, %llu misses, %llu stored, %u tiles on disk\n",
+        (unsigned long long)cache->hits, (unsigned long long)cache->misses, (unsigned long long)cache->stores, cache->header->count);
+
+    unmap_tile_index(cache);
+    fclose(cache->payload);
+    pthread_mutex_destroy(&cache->mutex);
+}
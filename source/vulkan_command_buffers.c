@@ -44,6 +44,68 @@ void begin_command_buffer(VkCommandBuffer command_buffer, VkCommandBufferUsageFl
     }
 }
 
+/*
+    For secondary buffers executed inside a render pass, which must name the pass they continue
+*/
+void begin_secondary_command_buffer(VkCommandBuffer command_buffer, VkRenderPass render_pass, uint32_t subpass, VkFramebuffer framebuffer) {
+    VkCommandBufferInheritanceInfo inheritance_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = render_pass,
+        .subpass = subpass,
+        .framebuffer = framebuffer,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags = 0,
+        .pipelineStatistics = 0,
+        .pNext = NULL
+    };
+
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &inheritance_info
+    };
+
+    if(vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        error(1, "Failed to begin recording secondary command buffer");
+    }
+}
+
+/*
+    For secondary buffers executed inside dynamic rendering, which name the formats of the attachments instead
+*/
+void begin_secondary_rendering_buffer(VkCommandBuffer command_buffer, VkFormat color_format, VkFormat depth_format) {
+    VkCommandBufferInheritanceRenderingInfo rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &color_format,
+        .depthAttachmentFormat = depth_format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .pNext = NULL
+    };
+
+    VkCommandBufferInheritanceInfo inheritance_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0,
+        .framebuffer = VK_NULL_HANDLE,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags = 0,
+        .pipelineStatistics = 0,
+        .pNext = &rendering_info
+    };
+
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &inheritance_info
+    };
+
+    if(vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        error(1, "Failed to begin recording secondary command buffer");
+    }
+}
+
 void end_command_buffer(VkCommandBuffer command_buffer) {
     if(vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
         error(1, "Failed to record command buffer");
@@ -59,5 +121,89 @@ void submit_command_buffer(VkQueue queue, VkCommandBuffer command_buffers) {
 
 
 void reset_command_pool(VkDevice device, VkCommandPool command_pool) {
+    if(vkResetCommandPool(device, command_pool, 0) != VK_SUCCESS) {
+        error(1, "Failed to reset command pool");
+    }
+}
+
+
+
+/*
+    The pool is transient, its buffers are only ever recorded once between resets
+*/
+void create_command_allocator(command_allocator_t *allocator, VkDevice logical_device, uint32_t queue_family) {
+    VkCommandPoolCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .queueFamilyIndex = queue_family,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+    };
+
+    *allocator = (command_allocator_t){0};
+
+    if(vkCreateCommandPool(logical_device, &create_info, NULL, &allocator->command_pool) != VK_SUCCESS) {
+        error(1, "Failed to create command pool\n");
+    }
+}
+
+static VkCommandBuffer next_buffer(command_allocator_t *allocator, VkDevice logical_device, VkCommandBuffer **buffers, uint32_t *count, uint32_t *used, VkCommandBufferLevel level) {
+    if(*used == *count) {
+        VkCommandBuffer *grown = realloc(*buffers, (*count + 1)*sizeof(VkCommandBuffer));
+        if(grown == NULL) {
+            error(1, "Failed to allocate command buffers\n");
+        }
+        *buffers = grown;
+
+        if(level == VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+            create_primary_command_buffer(&grown[*count], logical_device, allocator->command_pool, 1);
+        } else {
+            create_secondary_command_buffer(&grown[*count], logical_device, allocator->command_pool, 1);
+        }
+        (*count)++;
+    }
+
+    return (*buffers)[(*used)++];
+}
+
+VkCommandBuffer allocate_primary_buffer(command_allocator_t *allocator, VkDevice logical_device) {
+    return next_buffer(allocator, logical_device, &allocator->primary_buffers, &allocator->primary_count, &allocator->primary_used, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+}
+
+VkCommandBuffer allocate_secondary_buffer(command_allocator_t *allocator, VkDevice logical_device) {
+    return next_buffer(allocator, logical_device, &allocator->secondary_buffers, &allocator->secondary_count, &allocator->secondary_used, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+}
+
+/*
+    Every buffer handed out since the last reset must have finished executing
+*/
+void reset_command_allocator(command_allocator_t *allocator, VkDevice logical_device) {
+    reset_command_pool(logical_device, allocator->command_pool);
+    allocator->primary_used = 0;
+    allocator->secondary_used = 0;
+}
+
+void destroy_command_allocator(command_allocator_t *allocator, VkDevice logical_device) {
+    //Destroying the pool frees the buffers allocated from it
+    vkDestroyCommandPool(logical_device, allocator->command_pool, NULL);
+
+    free(allocator->primary_buffers);
+    free(allocator->secondary_buffers);
+}
+
+
+
+/*
+    vkCmdPipelineBarrier2 without the dependency info, stages and accesses are carried by each barrier
+*/
+void pipeline_barrier(VkCommandBuffer command_buffer, uint32_t memory_barrier_count, const VkMemoryBarrier2 *memory_barriers, uint32_t buffer_barrier_count, const VkBufferMemoryBarrier2 *buffer_barriers, uint32_t image_barrier_count, const VkImageMemoryBarrier2 *image_barriers) {
+    VkDependencyInfo dependency_info = {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .memoryBarrierCount = memory_barrier_count,
+        .pMemoryBarriers = memory_barriers,
+        .bufferMemoryBarrierCount = buffer_barrier_count,
+        .pBufferMemoryBarriers = buffer_barriers,
+        .imageMemoryBarrierCount = image_barrier_count,
+        .pImageMemoryBarriers = image_barriers
+    };
 
+    vkCmdPipelineBarrier2(command_buffer, &dependency_info);
 }
@@ -167,10 +167,38 @@ void create_logical_device(VkDevice *logical_device, VkPhysicalDevice physical_d
         queue_create_infos[i] = queue_create_info;
     }
 
-    VkPhysicalDeviceFeatures device_features = {0};
+    VkPhysicalDeviceVulkan12Features supported_12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+    };
+    VkPhysicalDeviceFeatures2 supported_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &supported_12_features
+    };
+    vkGetPhysicalDeviceFeatures2(physical_device, &supported_features);
+
+    //Optional features are enabled when present, the modes that need them check for them themselves
+    VkPhysicalDeviceFeatures device_features = {
+        .fragmentStoresAndAtomics = supported_features.features.fragmentStoresAndAtomics,//Virtual texture feedback
+        .drawIndirectFirstInstance = supported_features.features.drawIndirectFirstInstance//GPU scene draws carry their object's index as first instance
+    };
+
+    //All core in 1.3: the frame loop paces on a timeline semaphore, all barriers are synchronization2 and the scene may be drawn without a render pass
+    VkPhysicalDeviceVulkan13Features vulkan_13_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .synchronization2 = VK_TRUE,
+        .dynamicRendering = VK_TRUE
+    };
+
+    VkPhysicalDeviceVulkan12Features vulkan_12_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = &vulkan_13_features,
+        .timelineSemaphore = VK_TRUE,
+        .drawIndirectCount = supported_12_features.drawIndirectCount
+    };
 
     VkDeviceCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = &vulkan_12_features,
         .pQueueCreateInfos = queue_create_infos,
         .queueCreateInfoCount = queue_count,
         .pEnabledFeatures = &device_features,
@@ -79,7 +79,7 @@ void create_render_pass_depth_buffered(VkRenderPass *render_pass, VkDevice logic
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
         .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
@@ -214,11 +214,20 @@ void set_depth_test(pipeline_details_t *pipeline_details) {
     pipeline_details->depth_stencil.maxDepthBounds = 1.0f;
 }
 
-VkPipeline create_graphics_pipeline(VkDevice logical_device, VkPipelineLayout pipeline_layout, VkRenderPass render_pass, pipeline_details_t *pipeline_details) {
+VkPipeline create_graphics_pipeline(VkDevice logical_device, VkPipelineLayout pipeline_layout, render_target_t target, pipeline_details_t *pipeline_details) {
     VkPipeline graphics_pipeline;
+
+    VkPipelineRenderingCreateInfo rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &target.color_format,
+        .depthAttachmentFormat = target.depth_format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED
+    };
     
     VkGraphicsPipelineCreateInfo create_info = {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = target.render_pass == VK_NULL_HANDLE ? &rendering_info : NULL,
         .stageCount = pipeline_details->stage_count,
         .pStages = pipeline_details->shader_stages,
         .pVertexInputState = &pipeline_details->vertex_input,
@@ -230,7 +239,7 @@ VkPipeline create_graphics_pipeline(VkDevice logical_device, VkPipelineLayout pi
         .pColorBlendState = &pipeline_details->color_blender,
         .pDynamicState = &pipeline_details->dynamic_state,
         .layout = pipeline_layout,
-        .renderPass = render_pass,
+        .renderPass = target.render_pass,
         .subpass = 0,
         /* Used if pipeline is recreated */
         .basePipelineHandle = VK_NULL_HANDLE,
@@ -20,6 +20,23 @@ uint32_t select_memory_type(VkPhysicalDevice physical_device, uint32_t type_filt
     return ~0;
 }
 
+/*
+    Whether compute shaders may use operations, a mask of VkSubgroupFeatureFlagBits. Only the basic ones are
+    guaranteed, shaders using others have a variant without them.
+*/
+uint32_t compute_subgroup_support(VkPhysicalDevice physical_device, VkSubgroupFeatureFlags operations) {
+    VkPhysicalDeviceSubgroupProperties subgroup_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES
+    };
+    VkPhysicalDeviceProperties2 device_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &subgroup_properties
+    };
+    vkGetPhysicalDeviceProperties2(physical_device, &device_properties);
+
+    return (subgroup_properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) && (subgroup_properties.supportedOperations & operations) == operations;
+}
+
 VkImageView create_image_view(VkImage image, VkDevice logical_device, uint32_t mip_levels, VkFormat image_format, VkImageAspectFlags aspect_flags) {
     VkImageView image_view;
     VkImageSubresourceRange subresource_range = {
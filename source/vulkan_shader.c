@@ -28,6 +28,18 @@ uint32_t parse_file(const char *file_name, char **p_buffer) {
     return file_size;
 }
 
+void create_shader_module(VkShaderModule *shader_module, VkDevice logical_device, const uint32_t *code, size_t code_size) {
+    VkShaderModuleCreateInfo create_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = code_size,
+        .pCode = code
+    };
+
+    if(vkCreateShaderModule(logical_device, &create_info, NULL, shader_module)) {
+        error(1, "Failed to create shader module");
+    }
+}
+
 void load_shader_module(VkShaderModule *shader_module, VkDevice logical_device, const char *file_name) {
     char *shader_binary;
     uint32_t binary_size;
@@ -37,16 +49,7 @@ void load_shader_module(VkShaderModule *shader_module, VkDevice logical_device,
         Naïve casting only works if the endianness of the binary and uint32 is the same.
         Should make a more general solution
     */
-
-    VkShaderModuleCreateInfo create_info = {
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = binary_size,
-        .pCode = (uint32_t *)shader_binary
-    };
-
-    if(vkCreateShaderModule(logical_device, &create_info, NULL, shader_module)) {
-        error(1, "Failed to create shader module");
-    }
+    create_shader_module(shader_module, logical_device, (uint32_t *)shader_binary, binary_size);
 
     free(shader_binary);
 }
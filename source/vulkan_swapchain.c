@@ -67,16 +67,21 @@ VkSurfaceFormatKHR choose_swap_surface_format(VkPhysicalDevice physical_device,
     }
 }
 
-VkPresentModeKHR choose_swap_present_mode(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
+/*
+    The first of preferred_modes the surface supports, in order of preference
+*/
+VkPresentModeKHR choose_swap_present_mode(VkPhysicalDevice physical_device, VkSurfaceKHR surface, const VkPresentModeKHR *preferred_modes, uint32_t preferred_count) {
     uint32_t present_mode_count = 0;
     vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, NULL);
 
     VkPresentModeKHR present_modes[present_mode_count];
     vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, present_modes);
     
-    for (uint32_t i = 0; i < present_mode_count; i++) {
-        if(present_modes[i] == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return present_modes[i];
+    for(uint32_t i = 0; i < preferred_count; i++) {
+        for(uint32_t j = 0; j < present_mode_count; j++) {
+            if(present_modes[j] == preferred_modes[i]) {
+                return present_modes[j];
+            }
         }
     }
 
@@ -85,11 +90,10 @@ VkPresentModeKHR choose_swap_present_mode(VkPhysicalDevice physical_device, VkSu
 
 
 
-void create_swapchain(VkSwapchainKHR *swapchain, VkDevice device, VkPhysicalDevice physical_device, VkSurfaceKHR surface, uint32_t image_count, VkExtent2D image_extent) {
+void create_swapchain(VkSwapchainKHR *swapchain, VkDevice device, VkPhysicalDevice physical_device, VkSurfaceKHR surface, uint32_t image_count, VkExtent2D image_extent, VkPresentModeKHR present_mode, VkSwapchainKHR old_swapchain) {
     VkSurfaceCapabilitiesKHR capabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &capabilities);
 
-    VkPresentModeKHR present_mode = choose_swap_present_mode(physical_device, surface);
     VkSurfaceFormatKHR surface_format = choose_swap_surface_format(physical_device, surface);
     
     VkSwapchainCreateInfoKHR create_info = {
@@ -105,7 +109,7 @@ void create_swapchain(VkSwapchainKHR *swapchain, VkDevice device, VkPhysicalDevi
         .preTransform = capabilities.currentTransform,//Can specify transforms to apply to images in swap chain
         .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,//Opaque -> alpha channel should not be used to blend with other windows
         .clipped = VK_TRUE,//True -> we don't care about color of obscured pixel
-        .oldSwapchain = VK_NULL_HANDLE//If swap chain must be replaced, then reference to old one must be given here
+        .oldSwapchain = old_swapchain//The swap chain being replaced, its presentable images are handed over and it is retired
     };
     
     queue_family_indices indices = find_queue_families(physical_device);